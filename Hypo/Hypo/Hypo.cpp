@@ -1,1738 +1,8813 @@
-/*
-* 
-* --------------------------------
-* | Hypothetical Decimal Machine |
-* -------------------------
-* 
-* The hypothetical decimal machine is a simulation of a decimal-based processor that
-* simulates hardware by executing instructions from a proprietary executable object
-* module format comprised of opcodes, opmodes, and simualated memory hardware addresses.
-* 
-* The Hypo simulator will be used to run MTOPS real-time executions.
-* 
-*/
-
-#include <iostream>
-#include <iomanip>
-#include <cstdio>
-#include <fstream>
-#include <string>
-#include <math.h>
-#include <assert.h>
-#include <vector>
-
-namespace Hypo
-{
-    // ------ Debugging stuff. ------
-    const bool h_debug = false;
-    const std::string debug_opmode_descs[] 
-        = { "no opmode", "register", "register deferred", "auto increment", "auto decrement", "direct", "immediate" };
-
-    const std::string debug_opcode_descs[] 
-        = { "halt", "add", "subtract", "multiply", "divide", "move", "branch", "branch on minus", "branch on plus", "branch on zero", "push", "pop", "syscall" };
-    // ------ Debugging stuff. ------
-
-    // Constants.
-    constexpr int H_EOF = -1;
-    constexpr int H_PROGRAM_ADDR = 0;
-    constexpr int H_MAX_PROGRAM_ADDR = 2499;
-    constexpr int H_MAX_USER_FREE_ADDR = 4499;
-    constexpr int H_MAX_MEM_ADDR = 9999;
-    constexpr int H_TTL = 2000;
-    constexpr int H_TOTAL_USER_PROG = 99;
-    constexpr int H_OS_MODE = 1;
-    constexpr int H_USER_MODE = 2;
-
-    // MTOPS constants.
-    constexpr int H_EOL = -1;
-    constexpr int H_EOP = -1;
-    constexpr int H_STACK_SIZE = 9;
-    constexpr int H_START_SIZE_USER_FREE = 2000;
-    constexpr int H_START_SIZE_OS_FREE = 5500;
-    constexpr int H_PCBSIZE = 25;
-    constexpr int H_DEFAULT_PRIORITY = 128;
-    constexpr int H_TTL_EXP = 2;
-    constexpr int H_HALT = 1;
-
-    // State constants.
-    constexpr int H_READY_STATE = 1;
-    constexpr int H_WAITING_STATE = 2;
-
-    // Error bitflags to be returned by Hypo methods.
-    enum H_ERROR_CODE
-    {
-        OK = 0x01,
-        E_FS_CANT_OPEN = -0x01,
-        E_INVALID_ADDR_IN_PROGRAM = -0x02,
-        E_INVALID_PC = -0x04,
-        E_NO_EOF = -0x08,
-        E_INVALID_MODE = -0x10,
-        E_INVALID_GPR = -0x20,
-        E_INVALID_OPCODE = -0x40,
-        E_INVALID_ADDR_IN_GPR = -0x80,
-        E_STACK_OVERFLOW = -0x100,
-        E_STACK_UNDERFLOW = -0x200,
-        E_DIVIDE_BY_ZERO = -0x400,
-
-        E_UNKNOWN = -0xDEAD,
-
-        // MTOPS specific errors.
-        E_MTOPS_INVALID_PID = -0x800,
-        E_MTOPS_INSUFFICIENT_MEM = -0x1000,
-        E_MTOPS_NOT_MEM_BLOCK = -0x2000,
-        E_MTOPS_INVALID_SYSCALL = -0x4000,
-        E_MTOPS_QUEUE_FULL = -0x8000,
-        E_MTOPS_INVALID_FS_NAME = -0x10000,
-        E_MTOPS_INVALID_MEM_ADDR = -0x20000,
-        E_MTOPS_REQ_MEM_TOO_SMALL = -0x40000,
-        E_MTOPS_INVALID_MEM_RANGE = -0x80000,
-        E_MTOPS_INVALID_SIZE = -0x100000
-    };
-
-    // Hypo opcodes.
-    enum H_OPCODE
-    {
-        HALT = 0,
-        ADD = 1,
-        SUBTRACT = 2,
-        MULTIPLY = 3,
-        DIVIDE = 4,
-        MOVE = 5,
-        BRANCH = 6,
-        BRANCH_ON_MINUS = 7,
-        BRANCH_ON_PLUS = 8,
-        BRANCH_ON_ZERO = 9,
-        PUSH = 10,
-        POP = 11,
-        SYSCALL = 12
-    };
-
-    // Hypo opmodes.
-    enum H_OPMODE
-    {
-        NO_OP = 0,
-        REGISTER = 1,
-        REGISTER_DEF = 2,
-        AUTO_INC = 3,
-        AUTO_DEC = 4,
-        DIRECT = 5,
-        IMMEDIATE = 6
-    };
-
-    // PCB indicies.
-    enum H_PCB_IDX
-    {
-        I_NEXT_POINTER = 0,
-        I_STATE = 2,
-        I_PID = 1,
-        I_WAIT_REASON = 3,
-        I_PRIORITY = 4,
-        I_STACK_START = 5,
-        I_STACK_SIZE = 6,
-        I_GPR0 = 11,
-        I_GPR1 = 12,
-        I_GPR2 = 13,
-        I_GPR3 = 14,
-        I_GPR4 = 15,
-        I_GPR5 = 16,
-        I_GPR6 = 17,
-        I_GPR7 = 18,
-        I_R_SP = 19,
-        I_R_PC = 20,
-        I_R_PSR = 21
-    };
-
-    enum H_INTS
-    {
-        INT_NO_OP = 0,
-        INT_RUN_PROG = 1,
-        INT_SHUTDOWN = 2,
-        INT_IO_GETC = 3,
-        INT_IO_PUTC = 4
-    };
-
-    enum SYSCALLS
-    {
-        PROCESS_CREATE = 1,
-        PROCESS_DELETE = 2,
-        PROCESS_INQ = 3,
-        MEM_ALLOC = 4,
-        MEM_FREE = 5,
-        MSG_SEND = 6,
-        MSG_RECV = 7,
-        IO_GETC = 8,
-        IO_PUTC = 9,
-        TIME_GET = 10,
-        TIME_SET = 11
-    };
-    
-    // Words are signed 32-bit and should accomodate 6 digits.
-    typedef long word;
-
-    // Memory, addresses are simply integers 1-5000.
-    word memory[10000];
-
-    // Clock time in ms.
-    word clock;
-
-    // Memory address register.
-    word r_mar;
-
-    // Memory buffer register.
-    word r_mbr;
-
-    // General purpose registers.
-    word r_gpr[8];
-
-    // Instruction register.
-    word r_ir;
-
-    // Processor status register.
-    word r_psr;
-
-    // Stack pointer.
-    word r_sp;
-
-    // Program counter.
-    word r_pc;
-
-    // Running PCB pointer.
-    word mtops_pcb_ptr = H_EOL;
-
-    // Ready queue.
-    word mtops_rq = H_EOL;
-
-    // Waiting queue.
-    word mtops_wq = H_EOL;
-
-    // PID
-    word mtops_pid = 1;
-
-    // OS free list.
-    word mtops_os_free_list = H_EOL;
-
-    // User free list.
-    word mtops_user_free_list = H_EOL;
-
-    // Ready queue.
-    word RQ = H_EOL;
-
-    // Waiting queue.
-    word WQ = H_EOL;
-
-    // Should shutdown status (to process interrupts).
-    bool shutdown_status = false;
-
-    // Prototyping some methods.
-    long CreateProcess(std::string* filename, word priority);
-    word InsertIntoRQ(word pcb_ptr);
-
-    bool OSAddressInRange(int addr)
-    {
-        if (addr > H_MAX_USER_FREE_ADDR && addr <= H_MAX_MEM_ADDR)
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-    }
-
-    /*
-    * bool: UserFreeAddressInRange
-    *
-    * Check if a given address in memory is in the range for the user-free list area.
-    *
-    * @param addr Address in memory.
-    * 
-    * @return true if in range, false if not in range.
-    * 
-    */
-    bool UserFreeAddressInRange(int addr)
-    {
-        if (addr > H_MAX_PROGRAM_ADDR && addr <= H_MAX_USER_FREE_ADDR)
-        {
-            return true;
-        }
-        else 
-        {
-            return false;
-        }
-    }
-
-    /*
-    * bool: ProgramAddressInRange
-    *
-    * Check if a given address in memory is in the range for the program area.
-    *
-    * @param addr Address in memory.
-    * 
-    * @return true if in range, false if not in range.
-    * 
-    */
-    bool ProgramAddressInRange(int addr)
-    {
-        if (addr > H_MAX_PROGRAM_ADDR || addr < H_PROGRAM_ADDR)
-        {
-            return false;
-        }
-        else
-        {
-            return true;
-        }
-    }
-
-    /*
-    * void: InitializeSystem
-    *
-    * Initialize the hypo machine. This will set all global Hypo fields to 0.
-    * 
-    */
-    void InitializeSystem()
-    {
-        // Initialize clock to 0.
-        clock = 0;
-
-        // Initalize memory to 0.
-        memset(memory, 0, 10000);
-
-        // Initialize MAR and MBR to 0.
-        r_mar = 0;
-        r_mbr = 0;
-
-        // Initialize GPRs to 0.
-        memset(r_gpr, 0, 8);
-        
-        // Initialize IR, PSR, SP, PC to 0.
-        r_ir = 0;
-        r_psr = 0;
-        r_sp = 0;
-        r_pc = 0;
-
-        mtops_user_free_list = H_MAX_PROGRAM_ADDR + 1;
-        memory[mtops_user_free_list + I_NEXT_POINTER] = H_EOL;
-        memory[mtops_user_free_list + 1] = H_START_SIZE_USER_FREE;
-
-        mtops_os_free_list = H_MAX_USER_FREE_ADDR + 1;
-        memory[mtops_os_free_list + I_NEXT_POINTER] = H_EOL;
-        memory[mtops_os_free_list + 1] = H_START_SIZE_OS_FREE;
-
-        std::string nullf = "../null.eom";
-        std::string* nullfp = &nullf;
-        CreateProcess(nullfp, 0);
-    }
-
-    /*
-    * int: AbsoluteLoader
-    *
-    * Loads the given EOM file and loads it into memory.
-    * 
-    * @param filename The EOM file to load.
-    * 
-    * @return One of the following status codes:
-    *   -1 = Cannot open file.
-    *   -2 = Invalid address in EOM.
-    *   -4 = Invalid PC.
-    *   -8 = No end-of-file marker in EOM.
-    * 
-    *   OR
-    * 
-    *   Any value over 0, which is to be the first instruction to be executed.
-    * 
-    */
-    int AbsoluteLoader(std::string filename)
-    {
-        // Open an ifstream.
-        std::ifstream i_prog(filename);
-
-        // Check for file buffer validity.
-        if (!i_prog)
-        {
-            std::cerr << "Cannot open file: " << filename;
-            return E_FS_CANT_OPEN;
-        }
-
-        int32_t h_addr, h_content;
-        
-        // Loops through columns of the EOM.
-        while (i_prog >> h_addr >> h_content)
-        {
-            if (h_addr == H_EOF)
-            {
-                // The operand for opcode -1 is the first address to be
-                // executed from the EOM, so we should make sure it is 
-                // pointing to a valid address.
-                auto& entrypoint = h_content;
-
-                if (ProgramAddressInRange(entrypoint))
-                {
-                    std::cout << "Program [" + filename + "] successfully loaded into memory.";
-
-                    // Return the first instruction to execute.
-                    return h_content;
-                }
-                else
-                {
-                    std::cout << "Invalid address for program counter: " << h_content;
-                    return E_INVALID_PC;
-                }
-            }
-            else
-            {
-                if (ProgramAddressInRange(h_addr))
-                {
-                    // Store the instruction in memory.
-                    memory[h_addr] = h_content;
-                }
-                else
-                {
-                    std::cout << "Invalid address in program: " << h_addr;
-                    return E_INVALID_ADDR_IN_PROGRAM;
-                }
-            }
-        }
-        return E_NO_EOF;
-    }
-
-    /*
-    * void: DumpMemory
-    *
-    * Dumps the running memory to the screen.
-    *
-    * @param str The header string to display.
-    * @param start_addr The address to start dumping from
-    * @param size How many values should be displayed past the start address.
-    * 
-    */
-    void DumpMemory(std::string str, word start_addr, word size)
-    {
-        using namespace std;
-
-        cout << endl << str << endl;
-
-        // Checks for invalid starting location, ending location, or size. Checks for valid memory dump range between 0-9999.
-        if (start_addr < 0 || start_addr > H_MAX_MEM_ADDR || size < 1 || start_addr + size > H_MAX_MEM_ADDR)
-        {
-            cout << "Invalid parameter.";
-        }
-        else
-        {
-            cout << setw(12) << "\nGPRs: " << setw(7) << "G0" << setw(7) << "G1" << setw(7) << "G2" << setw(7) << "G3" << setw(7) << "G4" << setw(7) << "G5" << setw(7) << "G6" << setw(7) << "G7" << setw(7) << "SP" << setw(7) << "PC" << endl; //Display GPR header.
-            cout << left << setfill(' ') << setw(11) << " " << setw(7) << r_gpr[0] << setw(7) << r_gpr[1] << setw(7) << r_gpr[2] << setw(7) << r_gpr[3] << setw(7) << r_gpr[4] << setw(7) << r_gpr[5] << setw(7) << r_gpr[6] << setw(7) << r_gpr[7] << setw(7) << r_sp << setw(7) << r_pc << endl; //Display GPR, SP, and PC.
-
-            cout << left << setw(12) << "\nAddress: " << setw(7) << "+0" << setw(7) << "+1" << setw(7) << "+2" << setw(7) << "+3" << setw(7) << "+4" << setw(7) << "+5" << setw(7) << "+6" << setw(7) << "+7" << setw(7) << "+8" << setw(7) << "+9" << endl; //Display memory header.
-
-            int addr = start_addr;
-            int end_address = start_addr + size;
-
-            while (addr <= end_address)
-            {
-                // Print starting memory location in the row.
-                cout << left << setw(11) << addr;
-
-                // Prints all values at the desired memory location until the end address is reached.
-                for (int i = 0; i < 10; i++)
-                {
-                    if (addr <= end_address)
-                    {
-                        cout << setw(7) << memory[addr];
-                        addr++;
-                    }
-                    else
-                    {
-                        // No more values to print, break out of the loop.
-                        break;
-                    }
-                }
-                cout << "\n";
-            }
-
-            cout << "Clock: " << clock << endl;
-            cout << "PSR: " << r_psr << endl;
-        }
-    }
-
-    /*
-    * word: FetchOperand
-    *
-    * Gets the operand from a given sliced EOM instruction from memory.
-    *
-    * @param op_mode The operand mode to process the operand with.
-    * @param op_reg The operand register for modes that access the GPRs.
-    * @param op_addr The address in memory to fetch.
-    * @param op_value The final value fetched from the instruction.
-    *
-    * @return A status code corresponding to H_ERROR_CODE.
-    * 
-    */
-    word FetchOperand(word op_mode, word op_reg, word* op_addr, word* op_value)
-    {
-        switch (op_mode)
-        {
-
-        // ------ Register mode ------ Operand value is in the GPR.
-        case H_OPMODE::REGISTER:
-
-            // Set the address to a negative value, since our value is in a GPR.
-            *op_addr = -2;
-
-            *op_value = r_gpr[op_reg];
-
-            break;
-
-        // ------ Register deferred mode ------ Operand address is in a GPR & value is in memory.
-        case H_OPMODE::REGISTER_DEF:
-            *op_addr = r_gpr[op_reg];
-
-            if (UserFreeAddressInRange(*op_addr))
-            {
-                *op_value = memory[*op_addr];
-            }
-            else
-            {
-                std::cout << "Invalid address in GPR: " << op_reg;
-                std::cout << "\n-- Address: " << *op_addr;
-                std::cout << "\n-- PC: " << r_pc;
-                return E_INVALID_ADDR_IN_GPR;
-            }
-
-            break;
-
-        // ------ Auto-increment mode ------ Operand address is in a GPR & operand value is in memory; auto-increment the register value.
-        case H_OPMODE::AUTO_INC:
-            *op_addr = r_gpr[op_reg];
-
-            if (UserFreeAddressInRange(*op_addr))
-            {
-                *op_value = memory[*op_addr];
-            }
-            else
-            {
-                std::cout << "Invalid address in GPR: " << op_reg;
-                std::cout << "\n-- Address: " << *op_addr;
-                std::cout << "\n-- PC: " << r_pc;
-                return E_INVALID_ADDR_IN_GPR;
-            }
-
-            r_gpr[op_reg]++; // Increment register value +1.
-
-            break;
-
-        // ------ Auto-decrement mode ------ Operand address is in a GPR & operand value is in memory; auto-decrement the register value.
-        case H_OPMODE::AUTO_DEC:
-
-            // Decrement register value -1.
-            --r_gpr[op_reg];
-
-            *op_addr = r_gpr[op_reg];
-
-            if (UserFreeAddressInRange(*op_addr))
-            {
-                *op_value = memory[*op_addr];
-            }
-            else
-            {
-                std::cout << "Invalid address in GPR: " << op_reg;
-                std::cout << "\n-- Address: " << *op_addr;
-                std::cout << "\n-- PC: " << r_pc;
-                return E_INVALID_ADDR_IN_GPR;
-            }
-
-            break;
-
-        // ------ Direct mode ------ Operand address is in the instruction, pointed to by r_pc.
-        case H_OPMODE::DIRECT:
-
-            // Get address from r_pc.
-            *op_addr = memory[r_pc++];
-
-            if (UserFreeAddressInRange(*op_addr))
-            {
-                *op_value = memory[*op_addr];
-            }
-            else
-            {
-                std::cout << "Invalid address in GPR: " << op_reg;
-                std::cout << "\n-- Address: " << *op_addr;
-                std::cout << "\n-- PC: " << r_pc;
-
-                return E_INVALID_ADDR_IN_GPR;
-            }
-
-            break;
-
-        // ------ Immediate mode ------ Operand value is in the instruction.
-        case H_OPMODE::IMMEDIATE:
-            if (ProgramAddressInRange(r_pc))
-            {
-                // Set the address to a negative value, since our value is in a GPR.
-                *op_addr = -2;
-
-                *op_value = memory[r_pc++];
-            }
-            else
-            {
-                std::cout << "Invalid address in PC: " << op_reg;
-                return E_INVALID_ADDR_IN_GPR;
-            }
-
-            break;
-        // ------ Invalid opmode ------
-        default:
-            std::cout << "Invalid opmode: " << op_mode;
-            return E_INVALID_MODE;
-        }
-
-        return OK;
-    }
-
-    /*
-    * void: InitializePCB
-    * 
-    * Initializes the simulated hardware for our PCB.
-    * 
-    * @param pcb_ptr The address in memory for the PCB.
-    * 
-    */
-    void InitializePCB(word pcb_ptr)
-    {
-        for (int pcb_idx = 0; pcb_idx < H_PCBSIZE; pcb_idx++)
-        {
-            memory[pcb_ptr + pcb_idx] = 0;
-        }
-
-        memory[pcb_ptr + I_NEXT_POINTER] = H_EOL;
-        memory[pcb_ptr + I_PID] = mtops_pid++;
-        memory[pcb_ptr + I_STATE] = H_READY_STATE;
-        memory[pcb_ptr + I_PRIORITY] = H_DEFAULT_PRIORITY;
-    }
-
-    // Allocate memory for the OS.
-    word AllocateOSMemory(word size)
-    {
-        if (mtops_os_free_list == H_EOL) // If there is no free memory (-1)
-        {
-            std::cout << "No memory available to allocate.";
-            return E_MTOPS_INSUFFICIENT_MEM;
-        }
-
-        if (size <= 1) // If size is 1 or less, return, since 2 at minimum are required.
-        {
-            std::cout << "Requested memory is too small. Must be >= 2.";
-            return E_MTOPS_REQ_MEM_TOO_SMALL;
-        }
-
-        word c_ptr = mtops_os_free_list; // c_ptr = free OS block
-        word p_ptr = H_EOL; // previous pointer = end of list
-
-        while (c_ptr != H_EOL)
-        {
-            if (memory[c_ptr + 1] == size) // If the size of the block = requested size, use this block
-            {
-                if (c_ptr == mtops_os_free_list) // First block is correct size
-                {
-                    mtops_os_free_list = memory[c_ptr]; // Adjust OS block pointer.
-                    memory[c_ptr] = H_EOL;
-                    return c_ptr; // Return block starting pointer
-                }
-                else // Size is exact but not the first block.
-                {
-                    memory[p_ptr] = memory[c_ptr]; 
-                    memory[c_ptr] = H_EOL;
-                    return c_ptr; // Return starting block pointer.
-                }
-            }
-            else if (memory[c_ptr + 1] > size) // Block is larger than requested
-            {
-                if (c_ptr == mtops_os_free_list) // First block 
-                {
-                    memory[c_ptr + size] = memory[c_ptr]; // Move next block pointer up until requested size is matched
-                    memory[c_ptr + size + 1] = memory[c_ptr + 1] - size; // Adjust block so it is the size it was - requested size.
-                    mtops_os_free_list = c_ptr + size;
-                    return c_ptr; // Return starting block pointer
-                }
-                else // Block was found but it was not the first block.
-                {
-                    memory[c_ptr + size] = memory[c_ptr]; // Move next block pointer up until requested size is matched
-                    memory[c_ptr + size + 1] = memory[c_ptr + 1] - size; // Adjust block so it is the size it was - requested size.
-                    memory[p_ptr] = c_ptr + size; // Adjust next pointer.
-                    memory[c_ptr] = H_EOL;
-                    return c_ptr; // Return starting block pointer.
-                }
-            }
-            else // Block is too small, continue iteration.
-            {
-                p_ptr = c_ptr;
-                c_ptr = memory[c_ptr];
-            }
-        }
-
-        std::cout << "No memory blocks were large enough for the requested allocation size.";
-        return E_MTOPS_INSUFFICIENT_MEM;
-    }
-
-    // Allocate memory for the user.
-    word AllocateUserMemory(word size)
-    {
-        if (mtops_user_free_list == H_EOL)
-        {
-            std::cout << "No memory available to allocate.";
-            return E_MTOPS_INSUFFICIENT_MEM;
-        }
-
-        if (size <= 1)
-        {
-            std::cout << "Requested memory is too small. Must be >= 2.";
-            return E_MTOPS_REQ_MEM_TOO_SMALL;
-        }
-
-        word c_ptr = mtops_user_free_list;
-        word p_ptr = H_EOL;
-
-        while (c_ptr != H_EOL)
-        {
-            if (memory[c_ptr + 1] == size) // Block found of requested size.
-            {
-                if (c_ptr == mtops_user_free_list) // First block is the correct size.
-                {
-                    mtops_user_free_list = memory[c_ptr]; // Adjust user free list pointer to match the next user block pointer.
-                    memory[c_ptr] = H_EOL;
-                    if (h_debug) { std::cout << "\nPointer returned [1]: " + c_ptr << std::endl; }
-                    return c_ptr;
-                }
-                else // Block found is correct size, but is not the first block.
-                {
-                    memory[p_ptr] = memory[c_ptr]; // Set pointer of previous block to pointer of current block
-                    memory[c_ptr] = H_EOL;
-                    if (h_debug) { std::cout << "\nPointer returned [2]: " + c_ptr << std::endl; }
-                    return c_ptr; 
-                }
-            }
-            else if (memory[c_ptr + 1] > size) // Size is greater than requested.
-            {
-                if (c_ptr == mtops_user_free_list) // First block meets requested size.
-                {
-                    memory[c_ptr + size] = memory[c_ptr]; // Move next block pointer up to the requested size.
-                    memory[c_ptr + size + 1] = memory[c_ptr + 1] - size; // Set block size to original block size - requested block size.
-                    mtops_user_free_list = c_ptr + size; // Adjust beginning of user free list to adjusted block.
-                    if (h_debug) { std::cout << "\nPointer returned [3]: " + c_ptr << std::endl; }
-                    return c_ptr;
-                }
-                else // Block meets requested size but it is not the first block.
-                {
-                    memory[c_ptr + size] = memory[c_ptr]; // Move next block pointer up to request size.
-                    memory[c_ptr + size + 1] = memory[c_ptr + 1] - size; // Set block size to original block size - requested block size.
-                    memory[p_ptr] = c_ptr + size; // Set previous pointer block to current pointer + size.
-                    memory[c_ptr] = H_EOL;
-                    if (h_debug) { std::cout << "\nPointer returned [4]: " + c_ptr << std::endl; }
-                    return c_ptr;
-                }
-            }
-            else // Current block is too small, move to next iteration.
-            {
-                p_ptr = c_ptr;
-                c_ptr = memory[c_ptr];
-            }
-        }
-
-        std::cout << "No memory blocks were large enough for the requested allocation size.";
-        return E_MTOPS_INSUFFICIENT_MEM;
-    }
-
-    // Take location in memory and free it to OS free list. May error based on requested size and memory freed out of range.
-    word FreeOSMemory(word ptr, word size)
-    {
-        if (OSAddressInRange(ptr))
-        {
-            if (size <= 1)
-            {
-                std::cout << "Requested memory is too small. Must be >= 2."; // Minimum alloc is 2, so return error if < 2.
-                return E_MTOPS_REQ_MEM_TOO_SMALL;
-            }
-            else // Size is correct.
-            {
-                if ((ptr + size) > H_MAX_MEM_ADDR) // The size would take pointer out of bounds, so error.
-                {
-                    std::cout << "The requested memory size was too large.";
-                    return E_MTOPS_INVALID_MEM_RANGE;
-                }
-                else
-                {
-                    memory[ptr] = mtops_os_free_list; // Set pointer of free block to the leading address in OS free list.
-                    memory[ptr + 1] = size; // Set size of block to given size.
-                    mtops_os_free_list = ptr; // Set given pointer to be the leading address in OS free list.
-                    return OK;
-                }
-            }
-        }
-        else
-        {
-            std::cout << "Pointer address is outside of the OS memory.";
-            return E_MTOPS_NOT_MEM_BLOCK;
-        }
-    }
-
-    word FreeUserMemory(word ptr, word size)
-    {
-        if (!UserFreeAddressInRange(ptr))
-        {
-            std::cout << "Memory address out of bounds for user free memory.";
-            return E_MTOPS_NOT_MEM_BLOCK;
-        }
-        
-        if (size < 2) //Size to User memory to free is too small, return error.
-        {
-            std::cout << "Memory size is too small, must be >= 2.";
-            return E_MTOPS_REQ_MEM_TOO_SMALL;
-        }
-        else if ((ptr + size) > H_MAX_MEM_ADDR) //Trying to free elements in memory that pass its' limit, return error.
-        {
-            std::cout << "Requested size is too large and is out of bounds.";
-            return E_MTOPS_INVALID_MEM_RANGE;
-        }
-
-        memory[ptr] = mtops_user_free_list; //Set the pointer of the released free block to point to the 'front' of the UserFreeList (the newly released block is taking it's place at the front).
-        memory[ptr + 1] = size; //Set the size of this block in UserFreeList to the size given.
-        mtops_user_free_list = ptr; //Set the pointer given to be the new front of the UserFreeList.
-        return OK;
-    }
-
-    void TerminateProcess(word pcb_ptr)
-    {
-        FreeUserMemory(memory[pcb_ptr + I_STACK_START], memory[pcb_ptr + I_STACK_SIZE]); // Return stack memory using stack start address and stack size in the given PCB.
-
-        FreeOSMemory(pcb_ptr, H_PCBSIZE); // Return PCB memory using the pcb_ptr.
-    }
-
-    void PrintPCB(word pcb_ptr)
-    {
-        using namespace std;
-
-        cout << "\nPCB @ " << pcb_ptr << ":" << endl;
-
-        //Prints PCB address, Next Pointer Address, PID, State, Priority, PC, and SP values of the PCB.
-        cout << "PCB address = " << pcb_ptr << ", Next PCB Ptr = " << memory[pcb_ptr + I_NEXT_POINTER] << ", PID = " << memory[pcb_ptr + I_PID] << ", State = " << memory[pcb_ptr + I_STATE] << ", Reason for Waiting = " << memory[pcb_ptr + I_WAIT_REASON] << ", PC = " << memory[pcb_ptr + I_R_PC] << ", SP = " << memory[pcb_ptr + I_R_SP] << ", Priority = " << memory[pcb_ptr + I_PRIORITY] << ", STACK INFO: Starting Stack Address " << memory[pcb_ptr + I_STACK_START] << ", Stack Size = " << memory[pcb_ptr + I_STACK_SIZE] << endl;
-
-        //Prints the GPR values of the PCB.
-        cout << "GPRs:   GPR0: " << memory[pcb_ptr + I_GPR0] << "   GPR1: " << memory[pcb_ptr + I_GPR1] << "   GPR2: " << memory[pcb_ptr + I_GPR2] << "   GPR3: " << memory[pcb_ptr + I_GPR3] << "   GPR4: " << memory[pcb_ptr + I_GPR4] << "   GPR5: " << memory[pcb_ptr + I_GPR5] << "   GPR6: " << memory[pcb_ptr + I_GPR6] << "   GPR7: " << memory[pcb_ptr + I_GPR7] << "\n" << endl;
-    }
-
-    // Create process given a filename and allocated a PCB for it. Also defines stack space for the program and dumps user program locations and memory addresses + contents.
-    // May error based on memory size given and file I/O errors.
-    //
-    //     Errors if: 
-    // requested size is too small.
-    // can't open file.
-    // not enough memory available.
-    // invalid PC.
-    // invalid mem address.
-    long CreateProcess(std::string *filename, word priority)
-    {
-        word pcb_ptr = AllocateOSMemory(H_PCBSIZE); // Allocate space for the PCB, returns leading address.
-        if (pcb_ptr < 0) { return pcb_ptr; } // Error code.
-
-        InitializePCB(pcb_ptr); // Init the PCB.
-
-        word status = AbsoluteLoader(*filename); // Load the file into memory.
-        if (status < 0) { return status; } // Error code.
-
-        memory[pcb_ptr + I_R_PC] = status; // Set PC value in PCB.
-
-        word u_ptr = AllocateUserMemory(H_STACK_SIZE); // Allocate user memory.
-        if (pcb_ptr < 0) { FreeOSMemory(pcb_ptr, H_PCBSIZE); return pcb_ptr; } // Error code.
-
-        memory[pcb_ptr + I_STACK_START] = u_ptr; // Set beginning stack addr in PCB.
-        memory[pcb_ptr + I_R_SP] = u_ptr - 1; // Set stack pointer.
-        memory[pcb_ptr + I_STACK_SIZE] = H_STACK_SIZE; // Set stack size.
-        memory[pcb_ptr + I_PRIORITY] = priority; // Set prioerity.
-
-        DumpMemory("\n User Program Area \n", H_PROGRAM_ADDR, H_TOTAL_USER_PROG);
-
-        PrintPCB(pcb_ptr);
-        InsertIntoRQ(pcb_ptr);
-
-        return OK;
-    }
-
-    // Print data from the queue given a pointer.
-    long PrintQueue(long queue_ptr)
-    {
-        long c_pcb_ptr = queue_ptr;
-
-        if (c_pcb_ptr == H_EOL) //If the initial address is EndOfList, then the list itself is empty.
-        {
-            std::cout << "Empty list."; 
-            return OK;
-        }
-
-        // Walk thru the queue.
-        while (c_pcb_ptr != H_EOL)
-        {
-            PrintPCB(c_pcb_ptr);
-            c_pcb_ptr = memory[c_pcb_ptr + I_NEXT_POINTER]; // Next pointer.
-        }
-
-        return OK;
-
-    }
-
-    // Insert into the waiting queue given a pcb pointer.
-    word InsertIntoWQ(word pcb_ptr)
-    {
-        if (pcb_ptr < 0 || pcb_ptr > H_MAX_MEM_ADDR)
-        {
-            std::cout << "Invalid memory range.";
-            return E_MTOPS_INVALID_MEM_RANGE;
-        }
-
-        memory[pcb_ptr + I_STATE] = H_WAITING_STATE; //Set the PCB's state to "waiting."
-        memory[pcb_ptr + I_NEXT_POINTER] = WQ;
-        WQ = pcb_ptr;
-
-        return OK;
-
-    }
-
-    // Insert into the ready queue given a PCB pointer.
-    word InsertIntoRQ(word pcb_ptr)
-    {
-        word p_ptr = H_EOL;
-        word c_ptr = RQ;
-
-        if (pcb_ptr < 0 || pcb_ptr > H_MAX_MEM_ADDR)
-        {
-            std::cout << "Invalid memory range.";
-            return E_MTOPS_INVALID_MEM_RANGE;
-        }
-
-        memory[pcb_ptr + I_STATE] = H_READY_STATE; //Set the PCB's state to "ready."
-        memory[pcb_ptr + I_NEXT_POINTER] = H_EOL; //Set the PCB's Next Pointer value to EndOfList.
-
-        if (RQ == H_EOL) //If RQ is equal to the value of EndOfList (-1), then RQ is empty.
-        {
-            RQ = pcb_ptr;
-            return OK;
-        }
-
-        while (c_ptr != H_EOL)
-        {
-            if (memory[pcb_ptr + I_PRIORITY] > memory[c_ptr + I_PRIORITY]) //If the priority of the PCB we want to insert is higher than the priority of the current PCB...
-            {
-                if (p_ptr == H_EOL) //If p_ptr is EndOfList, then the priority of the PCB that we want to insert is higher than the highest priority PCB.
-                {
-                    memory[pcb_ptr + I_NEXT_POINTER] = RQ; //Change the current PCB's next pointer from EOL to the first PCB in the ready queue.
-                    RQ = pcb_ptr; //Change the RQ value to the address of the PCB that we want to insert (because it is now the head of the queue).
-                    return OK;
-                }
-
-                //If it isn't at the start of the RQ, then we're inserting this PCB into the middle of the list.
-                memory[pcb_ptr + I_NEXT_POINTER] = memory[p_ptr + I_NEXT_POINTER]; //Set pcb_ptr's next pointer index to the previous pointer's next pointer index, because pcb_ptr is taking over the previous pointer's slot.
-                memory[p_ptr + I_NEXT_POINTER] = pcb_ptr; //Set the previous pointer's next pointer index to the PCB address, completing the insertion.
-                return OK;
-            }
-
-            else //PCB to be inserted has lower or equal priority as the current PCB in RQ, move on to the next PCB.
-            {
-                p_ptr = c_ptr;
-                c_ptr = memory[c_ptr + I_NEXT_POINTER];
-            }
-        }
-
-        //If it gets to this point in the InsertIntoRQ() function, than the PCB we want to insert has the lowest priority in the RQ. Insert the new PCB into the end of the RQ.
-        memory[p_ptr + I_NEXT_POINTER] = pcb_ptr; //Change the previous pointer's next pointer index from EOL to the new PCB address. Note that the new PCB has a next pointer address of EOL.
-        return OK;
-
-    }
-
-    // Get the PCB for a PID from the WQ.
-    word SearchAndRemovePCBfromWQ(word this_pid)
-    {
-        word currentpcb_ptr = WQ;
-        word previouspcb_ptr = H_EOL;
-
-        if (this_pid < 1) //PID cannot be zero or less than zero. Check for an incorrect PID.
-        {
-            std::cout << "Invalid PID.";
-            return E_MTOPS_INVALID_PID;
-        }
-
-        //Search WQ for a PCB that has the given pid. If a match is found, remove it from WQ and return the PCB pointer
-        while (currentpcb_ptr != H_EOL)
-        {
-            if (memory[currentpcb_ptr + I_PID] == this_pid) //If the current pointer's PID matches the PID we're looking for, then a match is found. Remove that process from WQ.
-            {
-                if (previouspcb_ptr == H_EOL) //First PCB in WQ is a match.
-                {
-                    WQ = memory[currentpcb_ptr + I_NEXT_POINTER]; //Set the starting point of WQ to the second PCB in WQ.
-                }
-                else //Match is somewhere in the middle of WQ.
-                {
-                    memory[previouspcb_ptr + I_NEXT_POINTER] = memory[currentpcb_ptr + I_NEXT_POINTER]; //Adjust the previous PCB's next pointer index to be the next pointer index of the PCB that's being removed from WQ.
-                }
-
-                memory[currentpcb_ptr + I_NEXT_POINTER] = H_EOL; //Adjust the returning PCB's next pointer index to be 'EndOfList'.
-                return currentpcb_ptr; //Return matching PCB.
-            }
-
-            previouspcb_ptr = currentpcb_ptr; //Move on to the next PCB if there is no match.
-            currentpcb_ptr = memory[currentpcb_ptr + I_NEXT_POINTER];
-        }
-
-        std::cout << "No process with ID " << this_pid << " could be found.";
-        return E_MTOPS_INVALID_PID; // TODO: Replace with new error.
-    }
-
-    // Get a process from the RQ.
-    long SelectProcessFromRQ()
-    {
-        long pcb_ptr = RQ;
-
-        if (RQ != H_EOL)
-        {
-            RQ = memory[RQ + I_NEXT_POINTER];
-        }
-
-        memory[pcb_ptr + I_NEXT_POINTER] = H_EOL; // This may be memory[-1].
-        return pcb_ptr;
-    }
-
-    // Save the context of the GPRs when control is switched for the CPU.
-    void SaveContext(long pcb_ptr)
-    {
-        memory[pcb_ptr + I_GPR0] = r_gpr[0];
-        memory[pcb_ptr + I_GPR1] = r_gpr[1];
-        memory[pcb_ptr + I_GPR2] = r_gpr[2];
-        memory[pcb_ptr + I_GPR3] = r_gpr[3];
-        memory[pcb_ptr + I_GPR4] = r_gpr[4];
-        memory[pcb_ptr + I_GPR5] = r_gpr[5];
-        memory[pcb_ptr + I_GPR6] = r_gpr[6];
-        memory[pcb_ptr + I_GPR7] = r_gpr[7];
-
-        memory[pcb_ptr + I_R_SP] = r_sp;
-        memory[pcb_ptr + I_R_PC] = r_pc;
-        memory[pcb_ptr + I_R_PSR] = r_psr;
-    }
-
-    // Restore saved GPR values.
-    void Dispatcher(long pcb_ptr)
-    {
-        r_gpr[0] = memory[pcb_ptr + I_GPR0];
-        r_gpr[1] = memory[pcb_ptr + I_GPR1];
-        r_gpr[2] = memory[pcb_ptr + I_GPR2];
-        r_gpr[3] = memory[pcb_ptr + I_GPR3];
-        r_gpr[4] = memory[pcb_ptr + I_GPR4];
-        r_gpr[5] = memory[pcb_ptr + I_GPR5];
-        r_gpr[6] = memory[pcb_ptr + I_GPR6];
-        r_gpr[7] = memory[pcb_ptr + I_GPR7];
-        r_sp = memory[pcb_ptr + I_R_SP];
-        r_pc = memory[pcb_ptr + I_R_PC];
-        r_psr = H_USER_MODE;
-    }
-
-    // Run the interrupt for loading an EOM program.
-    void ISRrunProgramInterrupt()
-    {
-        std::string programToRun;
-        std::cout << "\nEnter filename: ";
-        std::cin >> programToRun; //Prompt and read filename.
-
-        std::string* fptr = &programToRun;
-        CreateProcess(fptr, H_DEFAULT_PRIORITY); //Call Create Process passing filename and Default Priority as arguments.
-
-    }
-
-    // Run the interrupt for handing input characters.
-    void ISRinputCompletionInterrupt()
-    {
-        word PID;
-        char i_char;
-
-        std::cout << "ISR designed for input completion has begun running, please specify the PID of the process that the input is being completed for: ";
-        std::cin >> PID; //Read the PID of the process we're completing input for.
-
-        PID = (int) PID;
-
-        word pcb_ptr = SearchAndRemovePCBfromWQ(PID); //Search WQ to find the PCB that has the given PID, return value is stored in pcb_ptr.
-        if (pcb_ptr > 0) //Only performs this section with a valid PCB address.
-        {
-            std::cout << "Please enter a character to store: ";
-            std::cin >> i_char; //Read one character from standard input device keyboard.
-            memory[pcb_ptr + I_GPR1] = (int) i_char; //Store the character in the GPR in the PCB. Use typecasting from char to word data types.
-            memory[pcb_ptr + I_STATE] = H_READY_STATE; //Set process state to Ready in the PCB.
-            std::cout << "The character " << i_char << " was successfully INPUTTED.";
-            InsertIntoRQ(pcb_ptr); //Insert PCB into ready queue.
-        }
-    } 
-
-    // Run the interrupt for handling output.
-    void ISRoutputCompletionInterrupt()
-    {
-        word PID;
-        char o_char;
-
-        std::cout << "ISR designed for output completion has begun running, please specify the PID of the process that the output is being completed for: ";
-        std::cin >> PID; //Read the PID of the process we're completing input for.
-
-        PID = (int) PID;
-
-        word pcb_ptr = SearchAndRemovePCBfromWQ(PID); //Search WQ to find the PCB that has the given PID, return value is stored in pcb_ptr.
-        if (pcb_ptr > 0) //Only performs this section with a valid PCB address.
-        {
-            o_char = (char) memory[pcb_ptr + I_GPR1]; //Typecast the ascii code for the output character back into a character value. Store in output character.
-            std::cout << "\nOUTPUT COMPLETED, CHARACTER DISPLAYED: " << o_char << std::endl; //Print the character that was in the PCB's GPR1 slot.
-            memory[pcb_ptr + I_STATE] = H_READY_STATE; //Set process state to Ready in the PCB.
-            InsertIntoRQ(pcb_ptr); //Insert PCB into ready queue.
-        }
-
-    }
-
-    // Gracefully shutdown the machine.
-    void ISRshutdownSystem()
-    {
-        //Terminate all processes in RQ one by one.
-        word ptr = RQ; //Set ptr to first PCB pointed by RQ.
-
-        while (ptr != H_EOL) //While there are still PCBs in the RQ...
-        {
-            RQ = memory[ptr + I_NEXT_POINTER]; //Set RQ to equal the next PCB in RQ.
-            TerminateProcess(ptr); //Terminate the current process in the list.
-            ptr = RQ; //Set ptr to the next PCB in RQ.
-        }
-
-        //Terminate all processes in WQ one by one.	
-        ptr = WQ; //Set ptr to first PCB pointed by WQ.
-
-        while (ptr != H_EOL) //While there are still PCBs in the WQ...
-        {
-            WQ = memory[ptr + I_NEXT_POINTER]; //Set RQ to equal the next PCB in RQ.
-            TerminateProcess(ptr); //Terminate the current process in the list.
-            ptr = WQ; //Set ptr to the next PCB in WQ.
-        }
-    }
-
-    // Handle an interrupt and process the input.
-    word CheckAndProcessInterrupt()
-    {
-        word i_id;
-
-        std::cout << "\n Interrupts: \n 0: No interrupt. \n 1: Run program. \n 2: Shutdown system. \n 3: io_getc \n 4: io_putc \n Interrupt ID:";
-        std::cin >> i_id;
-
-        switch (i_id)
-        {
-        case INT_NO_OP: // Interrupt 0 is a no-op.
-            break;
-        case INT_RUN_PROG: // Interrupt 1 is to load and run a program.
-            ISRrunProgramInterrupt();
-            break;
-        case INT_SHUTDOWN: // Interrupt 2 is to shut down the system.
-            ISRshutdownSystem();
-            shutdown_status = true;
-            break;
-        case INT_IO_GETC: // Interrupt 3 is to get input.
-            ISRinputCompletionInterrupt();
-            break;
-        case INT_IO_PUTC: // Interrupt 4 is to get output.
-            ISRoutputCompletionInterrupt();
-            break;
-        default: // All other interrupts are invalid, so no-op.
-            std::cout << "Invalid interrupt signal. This is a no-op...";
-            return INT_NO_OP;
-        }
-
-        return i_id;
-    }
-
-    // Run the memory allocation syscall. May return errors based on invalid size.
-    word MemAllocSystemCall()
-    {
-        long size = r_gpr[2];
-
-        if (size < 2 || size > H_START_SIZE_USER_FREE) // Size must be 2 at minimum.
-        {
-            std::cout << "The size of memory requested was out of range.";
-            return E_MTOPS_INVALID_SIZE;
-        }
-
-        r_gpr[1] = AllocateUserMemory(size); // Allocate user memory and put starting pointer addr in GPR1.
-
-        if (r_gpr[1] < 0) // GPR1 reached an error status.
-        {
-            r_gpr[0] = r_gpr[1];
-        }
-        else
-        {
-            r_gpr[0] = 0; // BranchOnZero = OK
-        }
-
-        std::cout << "MemAllocSystemCall => GPR0: " << r_gpr[0] << " GPR1: " << r_gpr[1] << " GPR2: " << r_gpr[2] << std::endl;
-
-        return r_gpr[0];
-    }
-
-    // Run the free memory system call. May return erorrs if memory requested was out of range.
-    word MemFreeSystemCall()
-    {
-        long size = r_gpr[2];
-
-        if (size < 2 || size > H_START_SIZE_USER_FREE) // Minimum size is two, maximum size must be < 2000.
-        {
-            std::cout << "The size of memory requested was out of range.";
-            return E_MTOPS_INVALID_SIZE;
-        }
-
-        r_gpr[0] = FreeUserMemory(r_gpr[1], size); // Free user memory and place pointer addr into GPR0.
-
-        std::cout << "MemFreeSystemCall => GPR0: " << r_gpr[0] << " GPR1: " << r_gpr[1] << " GPR2: " << r_gpr[2] << std::endl;
-    
-        return r_gpr[0];
-    }
-
-    word io_getcSystemCall()
-    {
-        return INT_IO_GETC;
-    }
-
-    word io_putcSystemCall()
-    {
-        return INT_IO_PUTC;
-    }
-
-    /*
-    * word: SystemCall
-    *
-    * Performs a system call (unimplemented).
-    *
-    * @param id The syscall ID to execute.
-    *
-    * @return OK
-    * 
-    */
-    word SystemCall(word id)
-    {
-        r_psr = H_OS_MODE;
-
-        word status = OK;
-
-        switch (id)
-        {
-        case PROCESS_CREATE:
-        {
-            std::cout << "PROCESS_CREATE not implemented.";
-            break;
-        }
-        case PROCESS_DELETE:
-        {
-            std::cout << "PROCESS_DELETE not implemented.";
-            break;
-        }
-        case PROCESS_INQ:
-        {
-            std::cout << "PROCESS_INQ not implemented.";
-            break;
-        }
-        case MEM_ALLOC:
-        {
-            status = MemAllocSystemCall();
-            break;
-        }
-        case MEM_FREE:
-        {
-            status = MemFreeSystemCall();
-            break;
-        }
-        case MSG_SEND:
-        {
-            std::cout << "MSG_SEND not implemented.";
-            break;
-        }
-        case MSG_RECV:
-        {
-            std::cout << "MSG_RECV not implemented.";
-            break;
-        }
-        case IO_GETC:
-        {
-            status = io_getcSystemCall();
-            break;
-        }
-        case IO_PUTC:
-        {
-            status = io_putcSystemCall();
-            break;
-        }
-        case TIME_GET:
-        {
-            std::cout << "TIME_GET not implemented.";
-            break;
-        }
-        case TIME_SET:
-        {
-            std::cout << "TIME_SET not implemented.";
-            break;
-        }
-        default:
-        {
-            std::cout << "Invalid syscall ID.";
-            return E_MTOPS_INVALID_SYSCALL;
-        }
-        }
-
-        r_psr = H_USER_MODE; // Set PSR to user mode.
-
-        return status;
-    }
-
-    /*
-    * word: CPU
-    *
-    * Simulate the Hypo CPU.
-    *
-    * @return A status code corresponding to H_ERROR_CODE.
-    * 
-    */
-    word CPU()
-    {
-        // Instruction parameters.
-        word opcode, op1_mode, op1_gpr, op2_mode, op2_gpr, op1_addr, op1_value, op2_addr, op2_value, result;
-
-        // Time left before CPU times out.
-        word time_left = H_TTL;
-
-        // Whether or not the CPU should halt execution.
-        bool should_halt = false;
-
-        // The status of execution based on FetchOperand.
-        word status;
-
-        while (!should_halt && time_left > 0)
-        {
-            if (ProgramAddressInRange(r_pc))
-            {
-                // Set r_mar to r_pc and increment r_pc to get the next word.
-                r_mar = r_pc++;
-
-                r_mbr = memory[r_mar];
-            }
-            else
-            {
-                std::cout << "Invalid address for program counter: " << r_pc;
-                return E_INVALID_PC;
-            }
-
-            // Copy r_mbr to r_ir to process instruction.
-            r_ir = r_mbr;
-
-            word _rem;
-            
-            // Slice EOM instruction down into opcodes, operand modes, and GPR dests.
-            opcode = r_ir / 10000;
-            _rem = r_ir % 10000;
-
-            if (h_debug) { std::cout << std::endl << "instruction: " << r_ir << std::endl; }
-            if (h_debug) { std::cout << "opcode: " << opcode << " = " << debug_opcode_descs[opcode] << std::endl; }
-
-            op1_mode = _rem / 1000;
-            _rem = _rem % 1000;
-
-            if (h_debug) { std::cout << "op1 mode: " << op1_mode << " = " << debug_opmode_descs[op1_mode] << std::endl; }
-
-            op1_gpr = _rem / 100;
-            _rem = _rem % 100;
-
-            if (h_debug) { std::cout << "op1 gpr: " << op1_gpr << std::endl; }
-
-            op2_mode = _rem / 10;
-            _rem = _rem % 10;
-
-            if (h_debug) { std::cout << "op2 mode: " << op2_mode << " = " << debug_opmode_descs[op2_mode] << std::endl; }
-
-            op2_gpr = _rem;
-
-            if (h_debug) { std::cout << "op2 gpr: " << op2_gpr << std::endl; }
-
-            // Check validity of operand mode.
-            if (op1_mode < H_OPMODE::NO_OP || op1_mode > H_OPMODE::IMMEDIATE || op2_mode < H_OPMODE::NO_OP || op2_mode > H_OPMODE::IMMEDIATE)
-            {
-                std::cout << "Invalid mode for operand.\n" << "-- First operand mode: " << op1_mode << "\n-- Second operand mode: " << op2_mode;
-                return E_INVALID_MODE;
-            }
-
-            size_t _gpr_len = (sizeof(r_gpr) / sizeof(r_gpr[0])) - 1;
-
-            // Check if the GPR exists (0 to sizeof(gprs)).
-            if (op1_gpr < 0 || op1_gpr > _gpr_len || op2_gpr < 0 || op2_gpr > _gpr_len)
-            {
-                std::cout << "Invalid GPR for operand.\n" << "-- First operand GPR: " << op1_gpr << "\n-- Second operand GPR: " << op2_gpr;
-                return E_INVALID_GPR;
-            }
-
-            switch (opcode)
-            {
-            case H_OPCODE::HALT: // Opcode 0, halt execution.
-
-                // Halt execution.
-                should_halt = true;
-
-                clock += 12;
-                time_left -= 12;
-
-                break;
-
-            case H_OPCODE::ADD: // Opcode 1, add operands.
-                
-                status = FetchOperand(op1_mode, op1_gpr, &op1_addr, &op1_value);
-                if (status < 0) { return status; }
-
-                status = FetchOperand(op2_mode, op2_gpr, &op2_addr, &op2_value);
-                if (status < 0) { return status; }
-
-                // Add the values.
-                result = op1_value + op2_value;
-
-                if (op1_mode == H_OPMODE::IMMEDIATE) { std::cout << "Cannot store value in immediate mode."; return H_ERROR_CODE::E_INVALID_MODE; }
-                if (op1_mode == H_OPMODE::REGISTER) { r_gpr[op1_gpr] = result; }
-                else { memory[op1_addr] = result; }
-
-                clock += 3;
-                time_left -= 3;
-
-                break;
-            case H_OPCODE::SUBTRACT: // Opcode 2, subtract operands.
-                
-                status = FetchOperand(op1_mode, op1_gpr, &op1_addr, &op1_value);
-                if (status < 0) { return status; }
-
-                status = FetchOperand(op2_mode, op2_gpr, &op2_addr, &op2_value);
-                if (status < 0) { return status; }
-
-                // Subtract the values.
-                result = op1_value - op2_value;
-
-                if (op1_mode == H_OPMODE::IMMEDIATE) { std::cout << "Cannot store value in immediate mode."; return H_ERROR_CODE::E_INVALID_MODE; }
-                if (op1_mode == H_OPMODE::REGISTER) { r_gpr[op1_gpr] = result; }
-                else { memory[op1_addr] = result; }
-
-                clock += 3;
-                time_left -= 3;
-
-                break;
-            case H_OPCODE::MULTIPLY: // Opcode 3, multiply operands.
-                
-                status = FetchOperand(op1_mode, op1_gpr, &op1_addr, &op1_value);
-                if (status < 0) { return status; }
-
-                status = FetchOperand(op2_mode, op2_gpr, &op2_addr, &op2_value);
-                if (status < 0) { return status; }
-
-                // Multiply the values.
-                result = op1_value * op2_value;
-
-                if (op1_mode == H_OPMODE::IMMEDIATE) { std::cout << "Cannot store value in immediate mode."; return H_ERROR_CODE::E_INVALID_MODE; }
-                if (op1_mode == H_OPMODE::REGISTER) { r_gpr[op1_gpr] = result; }
-                else { memory[op1_addr] = result; }
-
-                clock += 6;
-                time_left -= 6;
-
-                break;
-            case H_OPCODE::DIVIDE: // Opcode 4, divide operands.
-                
-                status = FetchOperand(op1_mode, op1_gpr, &op1_addr, &op1_value);
-                if (status < 0) { return status; }
-
-                status = FetchOperand(op2_mode, op2_gpr, &op2_addr, &op2_value);
-                if (status < 0) { return status; }
-
-                // x/0 is undefined.
-                if (op2_value == 0)
-                {
-                    std::cout << "Cannot divide by zero.";
-                    return E_DIVIDE_BY_ZERO;
-                }
-
-                // Divide the values.
-                result = op1_value / op2_value;
-
-                if (op1_mode == H_OPMODE::IMMEDIATE) { std::cout << "Cannot store value in immediate mode."; return H_ERROR_CODE::E_INVALID_MODE; }
-                if (op1_mode == H_OPMODE::REGISTER) { r_gpr[op1_gpr] = result; }
-                else { memory[op1_addr] = result; }
-
-                clock += 6;
-                time_left -= 6;
-
-                break;
-            case H_OPCODE::MOVE: // Opcode 5, move/reassign memory address to value.
-                
-                status = FetchOperand(op1_mode, op1_gpr, &op1_addr, &op1_value);
-                if (status < 0) { return status; }
-
-                status = FetchOperand(op2_mode, op2_gpr, &op2_addr, &op2_value);
-                if (status < 0) { return status; }
-
-                // Get result from operand 2.
-                result = op2_value;
-
-                if (op1_mode == H_OPMODE::IMMEDIATE) { std::cout << "Cannot store value in immediate mode."; return H_ERROR_CODE::E_INVALID_MODE; }
-                if (op1_mode == H_OPMODE::REGISTER) { r_gpr[op1_gpr] = result; }
-                else { memory[op1_addr] = result; } // Move result to memory address from operand 1.
-
-                clock += 2;
-                time_left -= 2;
-
-                break;
-            case H_OPCODE::BRANCH: // Opcode 6, branch/`goto` another memory address to continue execution.
-                
-                if (ProgramAddressInRange(r_pc))
-                {
-                    // Get next instruction from current instruction.
-                    r_pc = memory[r_pc];
-                }
-                else
-                {
-                    std::cout << "Invalid address for program counter on BRANCH: " << r_pc;
-                    return E_INVALID_PC;
-                }
-
-                clock += 2;
-                time_left -= 2;
-
-                break;
-            case H_OPCODE::BRANCH_ON_MINUS: // Opcode 7, branch if the value in operand 0 is negative.
-                
-                status = FetchOperand(op1_mode, op1_gpr, &op1_addr, &op1_value);
-                if (status < 0) { return status; }
-
-                // Check if operand 1 is negative.
-                if (op1_value < 0)
-                {
-                    if (ProgramAddressInRange(r_pc))
-                    {
-                        // Get next instruction from current instruction.
-                        r_pc = memory[r_pc];
-                    }
-                    else
-                    {
-                        std::cout << "\nInvalid address for program counter on BRANCH_ON_MINUS: " << r_pc << std::endl;
-                        return E_INVALID_PC;
-                    }
-                }
-                else
-                {
-                    r_pc++; // Skip branch instruction.
-                }
-
-                clock += 4;
-                time_left -= 4;
-
-                break;
-            case H_OPCODE::BRANCH_ON_PLUS: // Opcode 8, branch if the value in operand 0 is positive.
-
-                status = FetchOperand(op1_mode, op1_gpr, &op1_addr, &op1_value);
-                if (status < 0) { return status; }
-
-                // Check if operand 1 is positive.
-                if (op1_value > 0)
-                {
-                    if (ProgramAddressInRange(r_pc))
-                    {
-                        // Get next instruction from current instruction.
-                        r_pc = memory[r_pc];
-                    }
-                    else
-                    {
-                        std::cout << "Invalid address for program counter on BRANCH_ON_PLUS: " << r_pc;
-                        return E_INVALID_PC;
-                    }
-                }
-                else
-                {
-                    r_pc++; // Skip branch instruction.
-                }
-
-                clock += 4;
-                time_left -= 4;
-
-                break;
-            case H_OPCODE::BRANCH_ON_ZERO: // Opcode 9, branch if the value in operand 0 is equal to zero.
-                
-                status = FetchOperand(op1_mode, op1_gpr, &op1_addr, &op1_value);
-                if (status < 0) { return status; }
-
-                // Check if operand 1 is zero.
-                if (op1_value == 0)
-                {
-                    if (ProgramAddressInRange(r_pc))
-                    {
-                        // Get next instruction from current instruction.
-                        r_pc = memory[r_pc];
-                    }
-                    else
-                    {
-                        std::cout << "Invalid address for program counter on BRANCH_ON_ZERO: " << r_pc;
-                        return E_INVALID_PC;
-                    }
-                }
-                else
-                {
-                    r_pc++; // Skip branch instruction.
-                }
-
-                clock += 4;
-                time_left -= 4;
-
-                break;
-            case H_OPCODE::PUSH: // Opcode 10, push the value of operand 1 to the stack.
-                
-                status = FetchOperand(op1_mode, op1_gpr, &op1_addr, &op1_value);
-                if (status < 0) { return status; }
-
-                if (r_sp == memory[mtops_pcb_ptr + I_STACK_START] + H_STACK_SIZE)
-                {
-                    std::cout << "Stack is full, cannot push.";
-                    return E_STACK_OVERFLOW;
-                }
-                else
-                {
-                    r_sp++;
-                    memory[r_sp] = op1_value;
-                }
-
-                clock += 2;
-                time_left -= 2;
-
-                break;
-            case H_OPCODE::POP: // Opcode 11, pop the latest value from the stack.
-                
-                status = FetchOperand(op1_mode, op1_gpr, &op1_addr, &op1_value);
-                if (status < 0) { return status; }
-
-                if (r_sp < memory[mtops_pcb_ptr + I_STACK_START])
-                {
-                    std::cout << "Stack is empty, cannot pop.";
-                    return E_STACK_UNDERFLOW;
-                }
-                else
-                {
-                    std::cout << "Popping " << memory[r_sp] << " from the stack." << std::endl;;
-                    op1_addr = memory[r_sp];
-                    r_sp--;
-                }
-
-                clock += 2;
-                time_left -= 2;
-
-                break;
-            case H_OPCODE::SYSCALL: // Opcode 12, perform a system function call.
-                
-                if (ProgramAddressInRange(r_pc))
-                {
-                    status = FetchOperand(op1_mode, op1_gpr, &op1_addr, &op1_value);
-                    if (status < 0) { return status; }
-
-                    // Execute the system call.
-                    status = SystemCall(op1_value);
-                    if (status == INT_IO_GETC || status == INT_IO_PUTC) { return status; }
-                }
-                else
-                {
-                    std::cout << "Invalid address for program counter on SYSCALL: " << r_pc;
-                    return E_INVALID_PC;
-                }
-
-                clock += 12;
-                time_left -= 12;
-
-                break;
-            default:
-                std::cout << "Invalid opcode: " << opcode;
-                return E_INVALID_OPCODE;
-            }
-        }
-
-        if (should_halt)         { return H_HALT; }
-        else if (time_left <= 0) { return H_TTL_EXP; }
-        else                     { return E_UNKNOWN; }
-    }
-}
-
-// Begin Hypo process execution.
-int main()
-{
-    Hypo::word status; // Init status.
-
-    Hypo::InitializeSystem();
-
-    while (!Hypo::shutdown_status) // Loop while machine is running.
-    {
-        status = Hypo::CheckAndProcessInterrupt(); // Process interrupt for next user step.
-        if (status == Hypo::INT_SHUTDOWN) { break; } // Break out of loop if shutdown interrupt is entered.
-
-        std::cout << "\nPre-CPU scheduling RQ: ";
-        Hypo::PrintQueue(Hypo::RQ);
-
-        std::cout << "\nPre-CPU scheduling WQ: ";
-        Hypo::PrintQueue(Hypo::WQ);
-
-        Hypo::DumpMemory("\nMemory pre-CPU scheduling: ", Hypo::H_MAX_PROGRAM_ADDR + 1, 249);
-
-        Hypo::mtops_pcb_ptr = Hypo::SelectProcessFromRQ(); // Select a process from the RQ to dispatch and load.
-
-        Hypo::Dispatcher(Hypo::mtops_pcb_ptr); // Restore context given the current PCB pointer.
-
-        std::cout << "\nPost-process selection from RQ: ";
-        Hypo::PrintQueue(Hypo::RQ);
-
-        std::cout << "Dumping memory of running PCB: ";
-        Hypo::PrintPCB(Hypo::mtops_pcb_ptr);
-
-        std::cout << "\nCPU execution starting...\n";
-        status = Hypo::CPU(); // Run CPU.
-        std::cout << "\n --> CPU execution completed. Status code: " + (int) status << std::endl;
-
-        Hypo::DumpMemory("\nDynamic memory post-exeuction: ", Hypo::H_MAX_PROGRAM_ADDR + 1, 249);
-
-        if (status == Hypo::H_TTL_EXP) // Time has expired.
-        {
-            std::cout << "TTL has timed out, saving context and reinserting to RQ...";
-            Hypo::SaveContext(Hypo::mtops_pcb_ptr); // Save CPU context because the process is giving up CPU.
-            Hypo::InsertIntoRQ(Hypo::mtops_pcb_ptr); // Insert the current PCB into the RQ.
-            Hypo::mtops_pcb_ptr = Hypo::H_EOL;
-        }
-
-        else if (status == Hypo::H_HALT || status < 0) // Halt reached.
-        {
-            std::cout << "Halt reached, terminating program...";
-            Hypo::TerminateProcess(Hypo::mtops_pcb_ptr); // End the process.
-            Hypo::mtops_pcb_ptr = Hypo::H_EOL;
-        }
-        
-        else if (status == Hypo::INT_IO_GETC) // Input IO started.
-        {
-            std::cout << "\nIIO_GETC, enter interrupt for PID: " << Hypo::memory[Hypo::mtops_pcb_ptr + Hypo::I_PID];
-            Hypo::SaveContext(Hypo::mtops_pcb_ptr); //Save CPU Context of running process in its PCB, because the running process is losing control of the CPU.
-            Hypo::memory[Hypo::mtops_pcb_ptr + Hypo::I_WAIT_REASON] = Hypo::INT_IO_GETC;
-            Hypo::InsertIntoWQ(Hypo::mtops_pcb_ptr); //Insert running process into WQ.
-            Hypo::mtops_pcb_ptr = Hypo::H_EOL; 
-        }
-
-        else if (status == Hypo::INT_IO_PUTC)  // Output IO started.
-        {
-            std::cout << "\nIO_PUTC, enter interrupt for PID: " << Hypo::memory[Hypo::mtops_pcb_ptr + Hypo::I_PID];
-            Hypo::SaveContext(Hypo::mtops_pcb_ptr); //Save CPU Context of running process in its PCB, because the running process is losing control of the CPU.
-            Hypo::memory[Hypo::mtops_pcb_ptr + Hypo::I_WAIT_REASON] = Hypo::INT_IO_PUTC; //Set reason for waiting in the running PCB to 'Output Completion Event'.
-            Hypo::InsertIntoWQ(Hypo::mtops_pcb_ptr); //Insert running process into WQ.
-            Hypo::mtops_pcb_ptr = Hypo::H_EOL; // Set the running PCB ptr to the end of list.
-        }
-
-        else
-        {
-            std::cout << "\nUnknown error. (0xDEAD)"; // Unknown programming error.
-            return Hypo::E_UNKNOWN;
-        }
-    }
-
-    std::cout << "System is shutting down.";
-    return 0;
-}
+/*
+* 
+* --------------------------------
+* | Hypothetical Decimal Machine |
+* -------------------------
+* 
+* The hypothetical decimal machine is a simulation of a decimal-based processor that
+* simulates hardware by executing instructions from a proprietary executable object
+* module format comprised of opcodes, opmodes, and simualated memory hardware addresses.
+* 
+* The Hypo simulator will be used to run MTOPS real-time executions.
+* 
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <math.h>
+#include <assert.h>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifdef HYPO_BENCH
+#include <random>
+#if !defined(_MSC_VER) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#endif
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// Performance counter hooks. They compile to nothing unless HYPO_PERF_COUNTERS is defined.
+#ifdef HYPO_PERF_COUNTERS
+#define H_PERF(statement) do { statement; } while (0)
+#else
+#define H_PERF(statement) do { } while (0)
+#endif
+
+// Machine geometry. Override with -DHYPO_WORD=<signed type> and -DHYPO_MEMORY_WORDS=<count> for larger workloads.
+#ifndef HYPO_WORD
+#define HYPO_WORD int32_t
+#endif
+#ifndef HYPO_MEMORY_WORDS
+#define HYPO_MEMORY_WORDS 10000
+#endif
+
+namespace Hypo
+{
+    // ------ Debugging stuff. ------
+    const bool h_debug = false;
+    const std::string debug_opmode_descs[] 
+        = { "no opmode", "register", "register deferred", "auto increment", "auto decrement", "direct", "immediate" };
+
+    const std::string debug_opcode_descs[] 
+        = { "halt", "add", "subtract", "multiply", "divide", "move", "branch", "branch on minus", "branch on plus", "branch on zero", "push", "pop", "syscall",
+            "call", "return", "compare", "branch on equal", "branch on not equal", "branch on less", "branch on less or equal",
+            "branch on greater", "branch on greater or equal", "block move", "block fill", "block sum", "block compare" };
+    // ------ Debugging stuff. ------
+
+    // Constants. The partitions keep the original 25% program, 20% user free, 55% OS split of memory.
+    constexpr int H_MEMORY_WORDS = HYPO_MEMORY_WORDS;
+    static_assert(H_MEMORY_WORDS >= 10000 && H_MEMORY_WORDS % 20 == 0, "HYPO_MEMORY_WORDS must be at least 10000 and a multiple of 20.");
+    constexpr int H_EOF = -1;
+    constexpr int H_PROGRAM_ADDR = 0;
+    constexpr int H_MAX_PROGRAM_ADDR = H_MEMORY_WORDS / 4 - 1;
+    constexpr int H_MAX_USER_FREE_ADDR = H_MEMORY_WORDS / 20 * 9 - 1;
+    constexpr int H_MAX_MEM_ADDR = H_MEMORY_WORDS - 1;
+    constexpr int H_TTL = 2000; // Default, see h_ttl.
+    constexpr int H_TOTAL_USER_PROG = 99;
+    constexpr int H_OS_MODE = 1;
+    constexpr int H_USER_MODE = 2;
+    constexpr int H_PSR_MODE = 0x0F; // PSR bits holding H_OS_MODE or H_USER_MODE.
+    constexpr int H_PSR_NEGATIVE = 0x10; // Set by COMPARE when operand 1 is below operand 2.
+    constexpr int H_PSR_ZERO = 0x20; // Set by COMPARE when the operands are equal.
+    constexpr int H_PSR_FLAGS = H_PSR_NEGATIVE | H_PSR_ZERO;
+
+    // MTOPS constants.
+    constexpr int H_EOL = -1;
+    constexpr int H_EOP = -1;
+    constexpr int H_STACK_SIZE = 9; // Default, see h_stack_words.
+    constexpr int H_START_SIZE_USER_FREE = H_MAX_USER_FREE_ADDR - H_MAX_PROGRAM_ADDR;
+    constexpr int H_MAX_STACK_SIZE = H_START_SIZE_USER_FREE / 4; // Words a stack may grow to.
+    constexpr int H_START_SIZE_OS_FREE = H_MAX_MEM_ADDR - H_MAX_USER_FREE_ADDR;
+    constexpr int H_PCBSIZE = 32;
+    constexpr int H_DEFAULT_PRIORITY = 128;
+    constexpr int H_TTL_EXP = 2;
+    constexpr int H_HALT = 1;
+    constexpr int H_FUTEX_WAIT = 5;
+    constexpr int H_SLEEP = 6;
+    constexpr int H_EXIT = 7;
+    constexpr int H_PAGE_FAULT = 8;
+    constexpr int H_THROTTLED = 9;
+    constexpr int H_UNVERIFIED = 10; // Never leaves CPU, see Interpret.
+
+    // Shared memory constants.
+    constexpr int H_SHMSIZE = 6;
+    constexpr int H_SHM_ATTACH_SIZE = 2;
+
+    // Timer wheel constants. Each level has 64 slots, so level n covers 64^(n+1) clock ticks.
+    constexpr int H_TIMER_BITS = 6;
+    constexpr int H_TIMER_SLOTS = 1 << H_TIMER_BITS;
+    constexpr int H_TIMER_LEVELS = 4;
+
+    // Snapshot file constants.
+    constexpr char H_SNAPSHOT_MAGIC[8] = { 'H', 'Y', 'P', 'O', 'S', 'N', 'A', 'P' };
+    constexpr uint32_t H_SNAPSHOT_VERSION = 3; // 3: PCBs grew to 32 words for CPU quotas.
+    constexpr uint32_t H_SNAPSHOT_FULL = 1;
+    constexpr uint32_t H_SNAPSHOT_INCREMENTAL = 2;
+
+    // Binary EOM constants. The magic is followed by a uint32_t word count, that many int64_t
+    // address and content pairs, and the int64_t entry point, all in host byte order.
+    constexpr char H_EOM_MAGIC[8] = { 'H', 'Y', 'P', 'O', 'E', 'O', 'M', 'B' };
+    constexpr size_t H_EOM_CHUNK_BYTES = 1 << 18; // Least text EOM a loader thread parses, so small programs load on one thread.
+
+    // Clock value a batch run is abandoned at.
+    constexpr long H_BATCH_MAX_CLOCK = 10000000;
+
+    // Dirty page tracking constants. Each consumer of dirty pages owns one bit of a page's flags.
+    constexpr int H_PAGE_SIZE = 100;
+    constexpr int H_PAGE_COUNT = (H_MAX_MEM_ADDR + H_PAGE_SIZE) / H_PAGE_SIZE;
+    constexpr uint8_t H_DIRTY_CHECKPOINT = 0x01;
+    constexpr uint8_t H_DIRTY_DUMP = 0x02;
+    constexpr uint8_t H_DIRTY_RESET = 0x04;
+    constexpr uint8_t H_DIRTY_ALL = 0xFF;
+
+    // Paging constants. Each process' program area is paged in H_PAGE_SIZE pages; the physical program
+    // area holds the frames they run from.
+    constexpr int H_PROGRAM_PAGES = (H_MAX_PROGRAM_ADDR + H_PAGE_SIZE) / H_PAGE_SIZE;
+    constexpr int H_PROGRAM_FRAMES = (H_MAX_PROGRAM_ADDR + 1) / H_PAGE_SIZE;
+    constexpr size_t H_SWAP_SLOT_WORDS = (size_t) H_PROGRAM_PAGES * H_PAGE_SIZE;
+    constexpr int H_SWAP_SLOTS = 256; // Program areas the swap file holds unless --vm-slots says otherwise.
+    constexpr int H_TLB_ENTRIES = 16; // Direct mapped, must be a power of two.
+    constexpr int H_PAGE_FAULT_TICKS = 50; // Clock ticks a page takes to read in from swap.
+
+    // State constants.
+    constexpr int H_READY_STATE = 1;
+    constexpr int H_WAITING_STATE = 2;
+    constexpr int H_RUNNING_STATE = 3;
+
+    // Error bitflags to be returned by Hypo methods.
+    enum H_ERROR_CODE
+    {
+        OK = 0x01,
+        E_FS_CANT_OPEN = -0x01,
+        E_INVALID_ADDR_IN_PROGRAM = -0x02,
+        E_INVALID_PC = -0x04,
+        E_NO_EOF = -0x08,
+        E_INVALID_MODE = -0x10,
+        E_INVALID_GPR = -0x20,
+        E_INVALID_OPCODE = -0x40,
+        E_INVALID_ADDR_IN_GPR = -0x80,
+        E_STACK_OVERFLOW = -0x100,
+        E_STACK_UNDERFLOW = -0x200,
+        E_DIVIDE_BY_ZERO = -0x400,
+
+        E_UNKNOWN = -0xDEAD,
+
+        // MTOPS specific errors.
+        E_MTOPS_INVALID_PID = -0x800,
+        E_MTOPS_INSUFFICIENT_MEM = -0x1000,
+        E_MTOPS_NOT_MEM_BLOCK = -0x2000,
+        E_MTOPS_INVALID_SYSCALL = -0x4000,
+        E_MTOPS_QUEUE_FULL = -0x8000,
+        E_MTOPS_INVALID_FS_NAME = -0x10000,
+        E_MTOPS_INVALID_MEM_ADDR = -0x20000,
+        E_MTOPS_REQ_MEM_TOO_SMALL = -0x40000,
+        E_MTOPS_INVALID_MEM_RANGE = -0x80000,
+        E_MTOPS_INVALID_SIZE = -0x100000,
+        E_MTOPS_SHM_EXISTS = -0x200000,
+        E_MTOPS_SHM_NOT_FOUND = -0x400000,
+        E_MTOPS_INVALID_TIME = -0x800000,
+        E_MTOPS_BAD_SNAPSHOT = -0x1000000,
+        E_MTOPS_DEADLOCK = -0x2000000,
+        E_MTOPS_CYCLE_LIMIT = -0x4000000,
+        E_MTOPS_INVALID_COUNTER = -0x8000000,
+        E_MTOPS_BAD_TRACE = -0x10000000,
+        E_MTOPS_BAD_REPLAY = -0x20000000
+    };
+
+    // Hypo opcodes.
+    enum H_OPCODE
+    {
+        HALT = 0,
+        ADD = 1,
+        SUBTRACT = 2,
+        MULTIPLY = 3,
+        DIVIDE = 4,
+        MOVE = 5,
+        BRANCH = 6,
+        BRANCH_ON_MINUS = 7,
+        BRANCH_ON_PLUS = 8,
+        BRANCH_ON_ZERO = 9,
+        PUSH = 10,
+        POP = 11,
+        SYSCALL = 12,
+        CALL = 13,
+        RETURN = 14,
+        COMPARE = 15,
+        BRANCH_ON_EQUAL = 16, // Branches on the PSR flags from here on.
+        BRANCH_ON_NOT_EQUAL = 17,
+        BRANCH_ON_LESS = 18,
+        BRANCH_ON_LESS_EQUAL = 19,
+        BRANCH_ON_GREATER = 20,
+        BRANCH_ON_GREATER_EQUAL = 21,
+        BLOCK_MOVE = 22, // Block opcodes work on GPR0 words from their operands' addresses.
+        BLOCK_FILL = 23,
+        BLOCK_SUM = 24,
+        BLOCK_COMPARE = 25
+    };
+
+    constexpr int H_OPCODE_COUNT = H_OPCODE::BLOCK_COMPARE + 1;
+
+    // Hypo opmodes.
+    enum H_OPMODE
+    {
+        NO_OP = 0,
+        REGISTER = 1,
+        REGISTER_DEF = 2,
+        AUTO_INC = 3,
+        AUTO_DEC = 4,
+        DIRECT = 5,
+        IMMEDIATE = 6
+    };
+
+    // Operands an instruction of an opcode fetches with FetchOperand, in order.
+    int OpcodeOperands(int opcode)
+    {
+        switch (opcode)
+        {
+        case H_OPCODE::ADD: case H_OPCODE::SUBTRACT: case H_OPCODE::MULTIPLY: case H_OPCODE::DIVIDE: case H_OPCODE::MOVE: case H_OPCODE::COMPARE:
+        case H_OPCODE::BLOCK_MOVE: case H_OPCODE::BLOCK_FILL: case H_OPCODE::BLOCK_SUM: case H_OPCODE::BLOCK_COMPARE:
+            return 2;
+        case H_OPCODE::BRANCH_ON_MINUS: case H_OPCODE::BRANCH_ON_PLUS: case H_OPCODE::BRANCH_ON_ZERO: case H_OPCODE::PUSH: case H_OPCODE::POP: case H_OPCODE::SYSCALL:
+            return 1;
+        default:
+            return 0;
+        }
+    }
+
+    // Whether an instruction of an opcode is followed by a branch target word.
+    bool OpcodeBranches(int opcode)
+    {
+        return (opcode >= H_OPCODE::BRANCH && opcode <= H_OPCODE::BRANCH_ON_ZERO) || opcode == H_OPCODE::CALL
+            || (opcode >= H_OPCODE::BRANCH_ON_EQUAL && opcode <= H_OPCODE::BRANCH_ON_GREATER_EQUAL);
+    }
+
+    // PCB indicies.
+    enum H_PCB_IDX
+    {
+        I_NEXT_POINTER = 0,
+        I_STATE = 2,
+        I_PID = 1,
+        I_WAIT_REASON = 3,
+        I_PRIORITY = 4,
+        I_STACK_START = 5,
+        I_STACK_SIZE = 6,
+        I_SHM_LIST = 7,
+        I_WAIT_ADDR = 8,
+        I_PREV_POINTER = 9,
+        I_WAKE_TIME = 10,
+        I_GPR0 = 11,
+        I_GPR1 = 12,
+        I_GPR2 = 13,
+        I_GPR3 = 14,
+        I_GPR4 = 15,
+        I_GPR5 = 16,
+        I_GPR6 = 17,
+        I_GPR7 = 18,
+        I_R_SP = 19,
+        I_R_PC = 20,
+        I_R_PSR = 21,
+        I_TIMER_NEXT = 22,
+        I_TIMER_PREV = 23,
+        I_TIMER_SLOT = 24,
+        I_PARENT_PID = 25,
+        I_QUEUED_CLOCK = 26,
+        I_PAGE_TABLE = 27,
+        I_QUOTA = 28, // Clock ticks the process may run per quota period, 0 for no limit.
+        I_QUOTA_USED = 29,
+        I_QUOTA_EPOCH = 30 // Quota period I_QUOTA_USED counts in.
+    };
+
+    // Shared memory segment descriptor indicies.
+    enum H_SHM_IDX
+    {
+        I_SHM_NEXT = 0,
+        I_SHM_KEY = 1,
+        I_SHM_START = 2,
+        I_SHM_SIZE = 3,
+        I_SHM_REFS = 4,
+        I_SHM_DESTROYED = 5
+    };
+
+    // Shared memory attachment record indicies (next pointer is I_NEXT_POINTER).
+    enum H_SHM_ATTACH_IDX
+    {
+        I_ATTACH_SHM = 1
+    };
+
+    // Page table indicies. A page table is shared by a process and the children it forks.
+    enum H_PAGE_TABLE_IDX
+    {
+        I_PT_REFS = 0,
+        I_PT_SWAP_SLOT = 1,
+        I_PT_PAGES = 2 // Frame of each page, or H_EOL if it is not resident.
+    };
+
+    constexpr int H_PAGE_TABLE_SIZE = I_PT_PAGES + H_PROGRAM_PAGES;
+
+    enum H_INTS
+    {
+        INT_NO_OP = 0,
+        INT_RUN_PROG = 1,
+        INT_SHUTDOWN = 2,
+        INT_IO_GETC = 3,
+        INT_IO_PUTC = 4,
+        INT_SNAPSHOT_SAVE = 5,
+        INT_SNAPSHOT_RESTORE = 6,
+        INT_CHECKPOINT_SAVE = 7,
+        INT_TRACE_TOGGLE = 8,
+        INT_LATENCY_REPORT = 9
+    };
+
+    enum SYSCALLS
+    {
+        PROCESS_CREATE = 1,
+        PROCESS_DELETE = 2,
+        PROCESS_INQ = 3,
+        MEM_ALLOC = 4,
+        MEM_FREE = 5,
+        MSG_SEND = 6,
+        MSG_RECV = 7,
+        IO_GETC = 8,
+        IO_PUTC = 9,
+        TIME_GET = 10,
+        TIME_SET = 11,
+        SHM_CREATE = 12,
+        SHM_ATTACH = 13,
+        SHM_DETACH = 14,
+        SHM_DESTROY = 15,
+        FUTEX_WAIT = 16,
+        FUTEX_WAKE = 17,
+        TIME_SLEEP = 18,
+        PERF_READ = 19
+    };
+    
+    // Words are signed and at least 32-bit so they accomodate 6 digits. The default int32_t keeps memory compact.
+    typedef HYPO_WORD word;
+    static_assert(std::is_signed<word>::value && sizeof(word) >= 4, "HYPO_WORD must be a signed type of at least 32 bits.");
+
+    // Machine state is per host thread, so every thread that runs the simulator owns an isolated machine.
+
+    // Memory, addresses are simply integers 0 to H_MAX_MEM_ADDR.
+    thread_local word memory[H_MEMORY_WORDS];
+
+    // Clock time in ms.
+    thread_local word clock;
+
+    // Memory address register.
+    thread_local word r_mar;
+
+    // Memory buffer register.
+    thread_local word r_mbr;
+
+    // General purpose registers.
+    thread_local word r_gpr[8];
+
+    // Instruction register.
+    thread_local word r_ir;
+
+    // Processor status register.
+    thread_local word r_psr;
+
+    // Stack pointer.
+    thread_local word r_sp;
+
+    // First word of the running process' stack and the word past its last, cached from the PCB when it is dispatched.
+    thread_local word r_stack_base;
+    thread_local word r_stack_limit;
+
+    // Program counter.
+    thread_local word r_pc;
+
+    // Running PCB pointer.
+    thread_local word mtops_pcb_ptr = H_EOL;
+
+    // Ready queue.
+    thread_local word mtops_rq = H_EOL;
+
+    // Waiting queue.
+    thread_local word mtops_wq = H_EOL;
+
+    // PID
+    thread_local word mtops_pid = 1;
+
+    // PID of the null process.
+    thread_local word mtops_null_pid = H_EOL;
+
+    // OS free list.
+    thread_local word mtops_os_free_list = H_EOL;
+
+    // User free list.
+    thread_local word mtops_user_free_list = H_EOL;
+
+    // Named shared memory segment list.
+    thread_local word mtops_shm_list = H_EOL;
+
+    // Timer wheel slot heads. Each slot is a doubly linked list of sleeping PCBs.
+    thread_local word mtops_timer_wheel[H_TIMER_LEVELS][H_TIMER_SLOTS];
+
+    // Occupied slots of each timer wheel level, one bit per slot.
+    thread_local uint64_t mtops_timer_bitmap[H_TIMER_LEVELS];
+
+    // Clock time the timer wheel has been advanced to.
+    thread_local word mtops_timer_time = 0;
+
+    // Number of armed timers.
+    thread_local word mtops_timer_count = 0;
+
+    // Guest instructions retired on this machine, for throughput measurements.
+    thread_local uint64_t mtops_instructions = 0;
+
+    // Ready queue.
+    thread_local word RQ = H_EOL;
+
+    // Waiting queue.
+    thread_local word WQ = H_EOL;
+
+    // Should shutdown status (to process interrupts).
+    thread_local bool shutdown_status = false;
+
+    // Pages written since each dirty page consumer last cleared its bit.
+    thread_local uint8_t mtops_dirty_pages[H_PAGE_COUNT];
+
+    // Checkpoint chain the machine state belongs to and the last checkpoint written or applied in it.
+    thread_local uint64_t mtops_checkpoint_chain = 0;
+    thread_local uint32_t mtops_checkpoint_seq = 0;
+
+    // Whether DumpMemory prints only the words changed since the previous dump.
+    bool h_dump_diff = false;
+
+    // Whether CPU may skip the checks VerifyProgram has done once for a process.
+    bool h_verify = true;
+
+    // Shape of a set associative cache or TLB: sets and ways, both powers of two, and words per line.
+    struct CacheGeometry
+    {
+        int sets;
+        int ways;
+        int line;
+    };
+
+    // Memory hierarchy every machine models when enabled: its caches, its TLB, and what misses cost in clock ticks.
+    struct CacheConfig
+    {
+        bool enabled = false;
+        CacheGeometry icache = { 64, 2, 4 };
+        CacheGeometry dcache = { 64, 4, 4 };
+        CacheGeometry tlb = { 8, 2, 100 }; // Lines are H_PAGE_SIZE pages.
+        word miss_ticks = 10;
+        word walk_ticks = 4;
+    };
+
+    CacheConfig h_cache_config;
+
+    // Clock ticks each opcode costs, by opcode. Every execution engine charges instructions from here.
+    word h_cycle_costs[H_OPCODE_COUNT] = { 12, 3, 3, 6, 6, 2, 2, 4, 4, 4, 2, 2, 12, 4, 4, 3, 2, 2, 2, 2, 2, 2, 6, 4, 6, 6 };
+
+    // Words a block opcode gets through per clock tick on top of its cost above, as a SIMD unit would.
+    word h_block_words_per_tick = 4;
+
+    // Clock ticks of a burst before it times out.
+    word h_ttl = H_TTL;
+
+    // Quota of new user processes in clock ticks per quota period, 0 for none, and the length of a quota period.
+    word h_quota = 0;
+    word h_quota_period = 10 * H_TTL;
+
+    // Words of the stack a loaded process starts with. Stacks grow from there as they fill.
+    word h_stack_words = H_STACK_SIZE;
+
+    // Processes whose code passed VerifyProgram, by PID, with the return sites their verification found.
+    thread_local std::unordered_map<word, std::vector<bool>> mtops_verified_pids;
+
+    // Return sites of the running process while CPU skips its checks, see Interpret's RETURN.
+    thread_local const std::vector<bool>* mtops_return_sites = nullptr;
+
+    // EOM file of the null process loaded by InitializeSystem.
+    std::string h_null_program = "../null.eom";
+
+    // Console the machine on this thread prints to. Batch runs point it at a null stream.
+    thread_local std::ostream* h_console = &std::cout;
+
+    // Console with no stream buffer. Its badbit is set, so output to it is dropped before formatting.
+    thread_local std::ostream h_null_console(nullptr);
+
+    // Interrupt source of the machine on this thread. Batch jobs point it at their interrupt script.
+    thread_local std::istream* h_input = &std::cin;
+
+    // Get the interrupt source of the machine on this thread.
+    inline std::istream& Input()
+    {
+        return *h_input;
+    }
+
+    // Get the console of the machine on this thread.
+    inline std::ostream& Console()
+    {
+        return *h_console;
+    }
+
+    // An operator input in a record/replay log: the scheduling point and clock it was read at, and what was read.
+    struct ReplayEvent
+    {
+        word point;
+        word clock;
+        std::string token;
+    };
+
+    // Scheduling points so far, the times the machine stopped to take an interrupt.
+    thread_local word mtops_sched_point = 0;
+
+    // Log the operator's inputs are recorded into, if open.
+    thread_local std::ofstream mtops_record;
+
+    // Inputs being replayed instead of read from Input(), the next one due, and whether the machine has strayed from them.
+    thread_local bool mtops_replaying = false;
+    thread_local std::vector<ReplayEvent> mtops_replay;
+    thread_local size_t mtops_replay_next = 0;
+    thread_local bool mtops_replay_diverged = false;
+
+    /*
+    * bool: ReadInput
+    *
+    * Read one operator input. When recording, the input is logged with the scheduling point and
+    * clock it was read at. When replaying, the next logged input is taken instead, and only if the
+    * machine has reached the same scheduling point and clock; otherwise the replay has diverged and
+    * no more input is given.
+    *
+    * @param value Where to read the input to.
+    *
+    * @return false if there is no input left.
+    *
+    */
+    template <typename T>
+    bool ReadInput(T* value)
+    {
+        *value = T(); // What a failed stream read leaves.
+
+        if (mtops_replaying)
+        {
+            if (mtops_replay_diverged || mtops_replay_next + 1 >= mtops_replay.size()) { return false; } // Only the end line is left.
+
+            const ReplayEvent& event = mtops_replay[mtops_replay_next];
+
+            if (event.point != mtops_sched_point || event.clock != clock)
+            {
+                Console() << "\nReplay diverged: input recorded at scheduling point " << event.point << " clock " << event.clock
+                    << ", machine is at scheduling point " << mtops_sched_point << " clock " << clock << ".";
+                mtops_replay_diverged = true;
+                return false;
+            }
+
+            mtops_replay_next++;
+
+            std::istringstream in(event.token);
+            return (bool) (in >> *value);
+        }
+
+        if (!(Input() >> *value)) { return false; }
+
+        if (mtops_record.is_open()) { mtops_record << mtops_sched_point << " " << clock << " " << *value << "\n"; }
+
+        return true;
+    }
+
+    // Memory contents as of the previous diff-mode dump.
+    thread_local word mtops_dump_shadow[H_MEMORY_WORDS];
+
+    /*
+    * void: StoreWord
+    *
+    * Store a word into memory and mark its page dirty for every consumer. All writes to memory[]
+    * go through here so checkpoints and diff dumps only need to look at dirty pages.
+    *
+    * @param addr Address in memory.
+    * @param value The value to store.
+    *
+    */
+    inline void StoreWord(word addr, word value)
+    {
+        memory[addr] = value;
+        mtops_dirty_pages[addr / H_PAGE_SIZE] = H_DIRTY_ALL;
+    }
+
+    // Mark every page dirty, for bulk writes to memory[] that bypass StoreWord.
+    void MarkAllPagesDirty()
+    {
+        memset(mtops_dirty_pages, H_DIRTY_ALL, sizeof(mtops_dirty_pages));
+    }
+
+    // Mark the pages of a range of words dirty, for block writes to memory[] that bypass StoreWord.
+    void MarkRangeDirty(word addr, word count)
+    {
+        for (word page = addr / H_PAGE_SIZE; page <= (addr + count - 1) / H_PAGE_SIZE; page++)
+        {
+            mtops_dirty_pages[page] = H_DIRTY_ALL;
+        }
+    }
+
+    // Clear one consumer's dirty bit on every page.
+    void ClearDirtyPages(uint8_t consumer)
+    {
+        for (int page = 0; page < H_PAGE_COUNT; page++)
+        {
+            mtops_dirty_pages[page] &= ~consumer;
+        }
+    }
+
+    // Performance counter indicies. Arrays of counters start at their index.
+    enum H_PERF_IDX
+    {
+        P_OPCODE = 0, // Instructions retired, by opcode.
+        P_OPMODE = 13, // Operands fetched, by addressing mode.
+        P_BRANCH_TAKEN = 20,
+        P_BRANCH_NOT_TAKEN = 21,
+        P_SYSCALL = 22, // System calls, by ID.
+        P_CONTEXT_SWITCHES = 54,
+        P_TTL_EXPIRATIONS = 55,
+        P_RQ_WAIT = 56, // Clock ticks spent in the RQ.
+        P_WQ_WAIT = 57, // Clock ticks spent in the WQ.
+        P_PAGE_FAULTS = 58,
+        P_TLB_MISSES = 59,
+        P_ICACHE_HITS = 60, // Memory hierarchy model, see CacheAccess.
+        P_ICACHE_MISSES = 61,
+        P_DCACHE_HITS = 62,
+        P_DCACHE_MISSES = 63,
+        P_CACHE_TLB_HITS = 64,
+        P_CACHE_TLB_MISSES = 65,
+        P_MEMORY_STALL = 66, // Clock ticks added by cache and TLB misses.
+        P_THROTTLES = 67, // Times the process was parked with its quota used up.
+        P_OPCODE_EXT = 68, // Instructions retired, by opcode, from CALL on.
+        P_COUNT = P_OPCODE_EXT + H_OPCODE_COUNT - H_OPCODE::CALL
+    };
+
+    // Counter of the instructions retired of one opcode.
+    int OpcodeCounter(int opcode)
+    {
+        return opcode < H_OPCODE::CALL ? P_OPCODE + opcode : P_OPCODE_EXT + opcode - H_OPCODE::CALL;
+    }
+
+    // Latency histogram indicies.
+    enum H_LATENCY_IDX
+    {
+        L_RQ_WAIT = 0, // Clock ticks from entering the RQ to being dispatched.
+        L_WQ_WAIT = 1, // Clock ticks from entering the WQ to leaving it.
+        L_BURST = 2, // Clock ticks from dispatch to the end of the burst.
+        L_COUNT = 3
+    };
+
+    // Latency histograms keep values exactly below 2^H_HIST_SUB_BITS, and above that in buckets of
+    // 2^(H_HIST_SUB_BITS - 1) per power of two, so a value is off by at most 1/16 of itself.
+    constexpr int H_HIST_SUB_BITS = 5;
+    constexpr int H_HIST_HALF = 1 << (H_HIST_SUB_BITS - 1);
+    constexpr int H_HIST_BUCKETS = (64 - H_HIST_SUB_BITS + 1) * H_HIST_HALF;
+
+    // Log-linear (HDR) histogram of clock tick latencies.
+    struct LatencyHistogram
+    {
+        uint64_t buckets[H_HIST_BUCKETS] = {};
+        uint64_t samples = 0;
+        uint64_t max = 0;
+    };
+
+    // Counter block of a process or a machine. CPU counts each instruction once, by opcode and operand
+    // modes, and the per-opcode, per-mode and branch-taken counters are derived from that on read.
+    struct PerfCounters
+    {
+        uint64_t counts[P_COUNT] = {};
+        uint64_t decoded[H_OPCODE_COUNT][H_OPMODE::IMMEDIATE + 1][H_OPMODE::IMMEDIATE + 1] = {};
+        LatencyHistogram latency[L_COUNT];
+    };
+
+    // Clock the running process was dispatched at, for its burst length.
+    thread_local word mtops_burst_start = 0;
+
+    // Index of the highest set bit of a non-zero value.
+    int HighestBit(uint64_t value)
+    {
+#ifdef _MSC_VER
+        unsigned long idx;
+        _BitScanReverse64(&idx, value);
+        return (int) idx;
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+
+    // Bucket of a value in a latency histogram.
+    int HistogramBucket(uint64_t value)
+    {
+        if (value < 2 * H_HIST_HALF) { return (int) value; }
+
+        int shift = HighestBit(value) - H_HIST_SUB_BITS + 1;
+        return shift * H_HIST_HALF + (int) (value >> shift);
+    }
+
+    // Highest value that falls in a bucket of a latency histogram.
+    uint64_t HistogramBucketTop(int bucket)
+    {
+        if (bucket < 2 * H_HIST_HALF) { return bucket; }
+
+        int shift = bucket / H_HIST_HALF - 1;
+        uint64_t base = bucket % H_HIST_HALF + H_HIST_HALF;
+        return ((base + 1) << shift) - 1;
+    }
+
+    // Add a latency to a histogram. Negative latencies, from the clock being set back, count as 0.
+    void RecordLatency(LatencyHistogram& histogram, word latency)
+    {
+        uint64_t value = latency > 0 ? (uint64_t) latency : 0;
+
+        histogram.buckets[HistogramBucket(value)]++;
+        histogram.samples++;
+        histogram.max = std::max(histogram.max, value);
+    }
+
+    // Add every sample of one histogram to another.
+    void MergeHistogram(LatencyHistogram& into, const LatencyHistogram& from)
+    {
+        for (int bucket = 0; bucket < H_HIST_BUCKETS; bucket++)
+        {
+            into.buckets[bucket] += from.buckets[bucket];
+        }
+
+        into.samples += from.samples;
+        into.max = std::max(into.max, from.max);
+    }
+
+    // Value at or below which a fraction of a histogram's samples fall, rounded up to the top of its bucket.
+    uint64_t HistogramPercentile(const LatencyHistogram& histogram, double fraction)
+    {
+        if (histogram.samples == 0) { return 0; }
+
+        uint64_t rank = (uint64_t) ceil(fraction * histogram.samples);
+        uint64_t seen = 0;
+
+        for (int bucket = 0; bucket < H_HIST_BUCKETS; bucket++)
+        {
+            seen += histogram.buckets[bucket];
+            if (seen >= std::max<uint64_t>(rank, 1)) { return std::min(HistogramBucketTop(bucket), histogram.max); }
+        }
+
+        return histogram.max;
+    }
+
+    // Counters of processes that have terminated on this machine.
+    thread_local PerfCounters mtops_machine_perf;
+
+    // Counters of live processes, by PID.
+    thread_local std::unordered_map<word, PerfCounters> mtops_process_perf;
+
+    // Counters for work done while no process is dispatched.
+    thread_local PerfCounters mtops_unattributed_perf;
+
+    // Counter block of the running process. CPU counts into it.
+    thread_local PerfCounters* mtops_perf = &mtops_unattributed_perf;
+
+    // Errors by H_ERROR_CODE, from bursts that ended in an error and failed system calls.
+    thread_local std::map<word, uint64_t> mtops_error_counts;
+
+    // Count an error returned to a process or the OS.
+    void CountError(word code)
+    {
+        if (code < 0) { mtops_error_counts[code]++; }
+    }
+
+    // Drop every counter, for a machine that is booted, reset or restored.
+    void ResetPerfCounters()
+    {
+        mtops_machine_perf = PerfCounters();
+        mtops_unattributed_perf = PerfCounters();
+        mtops_process_perf.clear();
+        mtops_perf = &mtops_unattributed_perf;
+    }
+
+    // Name of a latency histogram, for reports.
+    std::string LatencyName(int kind)
+    {
+        if (kind == L_RQ_WAIT) { return "RQ wait"; }
+        if (kind == L_WQ_WAIT) { return "WQ wait"; }
+        return "burst";
+    }
+
+    // Print the tail latencies of a counter block, in clock ticks.
+    void PrintLatencyReport(const std::string& title, const PerfCounters& block)
+    {
+        Console() << "\n" << title << " latency (clock ticks):\n";
+
+        for (int kind = 0; kind < L_COUNT; kind++)
+        {
+            const LatencyHistogram& histogram = block.latency[kind];
+
+            Console() << std::setw(10) << std::left << LatencyName(kind) << std::right << " samples " << histogram.samples
+                << "  p50 " << HistogramPercentile(histogram, 0.50) << "  p99 " << HistogramPercentile(histogram, 0.99)
+                << "  p99.9 " << HistogramPercentile(histogram, 0.999) << "  max " << histogram.max << "\n";
+        }
+    }
+
+    // Fold the counters of a terminating process into the machine's, reporting its latencies.
+    void RetirePerfCounters(word pid)
+    {
+        auto entry = mtops_process_perf.find(pid);
+        if (entry == mtops_process_perf.end()) { return; }
+
+        for (int counter = 0; counter < P_COUNT; counter++)
+        {
+            mtops_machine_perf.counts[counter] += entry->second.counts[counter];
+        }
+
+        uint64_t* decoded = &mtops_machine_perf.decoded[0][0][0];
+        const uint64_t* retired = &entry->second.decoded[0][0][0];
+
+        for (size_t i = 0; i < sizeof(mtops_machine_perf.decoded) / sizeof(uint64_t); i++)
+        {
+            decoded[i] += retired[i];
+        }
+
+        for (int kind = 0; kind < L_COUNT; kind++)
+        {
+            MergeHistogram(mtops_machine_perf.latency[kind], entry->second.latency[kind]);
+        }
+
+        PrintLatencyReport("Process " + std::to_string(pid), entry->second);
+
+        if (mtops_perf == &entry->second) { mtops_perf = &mtops_unattributed_perf; }
+
+        mtops_process_perf.erase(entry);
+    }
+
+    // Read one counter of a counter block.
+    uint64_t PerfCounterValue(const PerfCounters& block, int counter)
+    {
+        uint64_t total = 0;
+
+        if (counter < P_OPMODE || counter >= P_OPCODE_EXT) // Instructions of one opcode, in any mode.
+        {
+            int opcode = counter < P_OPMODE ? counter - P_OPCODE : counter - P_OPCODE_EXT + H_OPCODE::CALL;
+
+            for (int op1_mode = 0; op1_mode <= H_OPMODE::IMMEDIATE; op1_mode++)
+            {
+                for (int op2_mode = 0; op2_mode <= H_OPMODE::IMMEDIATE; op2_mode++)
+                {
+                    total += block.decoded[opcode][op1_mode][op2_mode];
+                }
+            }
+        }
+        else if (counter < P_BRANCH_TAKEN) // Operands fetched in one mode, by the opcodes that fetch them.
+        {
+            int mode = counter - P_OPMODE;
+
+            for (int opcode = 0; opcode < H_OPCODE_COUNT; opcode++)
+            {
+                int operands = OpcodeOperands(opcode);
+
+                for (int other = 0; other <= H_OPMODE::IMMEDIATE; other++)
+                {
+                    if (operands >= 1) { total += block.decoded[opcode][mode][other]; }
+                    if (operands == 2) { total += block.decoded[opcode][other][mode]; }
+                }
+            }
+        }
+        else if (counter == P_BRANCH_TAKEN) // Every branch that was not counted as not taken. CALL is not a branch here.
+        {
+            for (int opcode = 0; opcode < H_OPCODE_COUNT; opcode++)
+            {
+                if (OpcodeBranches(opcode) && opcode != H_OPCODE::CALL) { total += PerfCounterValue(block, OpcodeCounter(opcode)); }
+            }
+
+            total -= block.counts[P_BRANCH_NOT_TAKEN];
+        }
+        else
+        {
+            total = block.counts[counter];
+        }
+
+        return total;
+    }
+
+    // Read one machine-wide counter: terminated processes plus live ones.
+    uint64_t MachinePerfCounter(int counter)
+    {
+        uint64_t total = PerfCounterValue(mtops_machine_perf, counter) + PerfCounterValue(mtops_unattributed_perf, counter);
+
+        for (const auto& process : mtops_process_perf)
+        {
+            total += PerfCounterValue(process.second, counter);
+        }
+
+        return total;
+    }
+
+    // Print the latencies of the machine, then of each live process.
+    void PrintLatencyReports()
+    {
+        PerfCounters machine = mtops_machine_perf;
+
+        for (int kind = 0; kind < L_COUNT; kind++)
+        {
+            MergeHistogram(machine.latency[kind], mtops_unattributed_perf.latency[kind]);
+
+            for (const auto& process : mtops_process_perf)
+            {
+                MergeHistogram(machine.latency[kind], process.second.latency[kind]);
+            }
+        }
+
+        PrintLatencyReport("Machine", machine);
+
+        for (const auto& process : mtops_process_perf)
+        {
+            PrintLatencyReport("Process " + std::to_string(process.first), process.second);
+        }
+    }
+
+    // Name of a performance counter, for reports.
+    std::string PerfCounterName(int counter)
+    {
+        if (counter < P_OPMODE) { return "opcode " + debug_opcode_descs[counter - P_OPCODE]; }
+        if (counter >= P_OPCODE_EXT) { return "opcode " + debug_opcode_descs[counter - P_OPCODE_EXT + H_OPCODE::CALL]; }
+        if (counter < P_BRANCH_TAKEN) { return "opmode " + debug_opmode_descs[counter - P_OPMODE]; }
+        if (counter == P_BRANCH_TAKEN) { return "branches taken"; }
+        if (counter == P_BRANCH_NOT_TAKEN) { return "branches not taken"; }
+        if (counter < P_CONTEXT_SWITCHES) { return "syscall " + std::to_string(counter - P_SYSCALL); }
+        if (counter == P_CONTEXT_SWITCHES) { return "context switches"; }
+        if (counter == P_TTL_EXPIRATIONS) { return "TTL expirations"; }
+        if (counter == P_RQ_WAIT) { return "RQ wait"; }
+        if (counter == P_WQ_WAIT) { return "WQ wait"; }
+        if (counter == P_PAGE_FAULTS) { return "page faults"; }
+        if (counter == P_TLB_MISSES) { return "TLB misses"; }
+        if (counter == P_ICACHE_HITS) { return "icache hits"; }
+        if (counter == P_ICACHE_MISSES) { return "icache misses"; }
+        if (counter == P_DCACHE_HITS) { return "dcache hits"; }
+        if (counter == P_DCACHE_MISSES) { return "dcache misses"; }
+        if (counter == P_CACHE_TLB_HITS) { return "cache model TLB hits"; }
+        if (counter == P_CACHE_TLB_MISSES) { return "cache model TLB misses"; }
+        if (counter == P_MEMORY_STALL) { return "memory stall ticks"; }
+        return "quota throttles";
+    }
+
+    // Print the machine's non-zero performance counters.
+    void PrintPerfCounters()
+    {
+        Console() << "\nPerformance counters:\n";
+
+        for (int counter = 0; counter < P_COUNT; counter++)
+        {
+            uint64_t value = MachinePerfCounter(counter);
+            if (value != 0) { Console() << std::setw(26) << std::left << PerfCounterName(counter) << std::right << value << "\n"; }
+        }
+    }
+
+    // Machine state the metrics exporter publishes, taken by the machine thread between bursts.
+    struct MetricsSnapshot
+    {
+        std::chrono::steady_clock::time_point taken;
+        word clock = 0;
+        uint64_t instructions = 0;
+        uint64_t context_switches = 0;
+        uint64_t syscalls[P_CONTEXT_SWITCHES - P_SYSCALL] = {};
+        word ready = 0;
+        word waiting = 0;
+        word running = 0;
+        word free_blocks[2] = {}; // OS free list, then user free list.
+        word free_words[2] = {};
+        word largest_free[2] = {};
+        std::map<word, uint64_t> errors;
+    };
+
+    /*
+    * Metrics exporter of a machine. The machine thread publishes a snapshot every interval and the
+    * exporter thread formats the latest one, so the CPU loop never waits on file or socket IO.
+    * The target is a file, rewritten every interval, or unix:<path> for a socket that serves the
+    * metrics to each connection.
+    */
+    struct MetricsExporter
+    {
+        std::string target;
+        std::chrono::milliseconds interval;
+        std::chrono::steady_clock::time_point next_publish;
+        std::thread thread;
+        std::mutex lock;
+        std::condition_variable wake;
+        std::shared_ptr<const MetricsSnapshot> latest;
+        std::shared_ptr<const MetricsSnapshot> previous;
+        bool stopping = false;
+    };
+
+    // Metrics exporter of this machine, nullptr when metrics are off.
+    thread_local MetricsExporter* mtops_metrics = nullptr;
+
+    // Count the blocks and words of a free list, and its largest block.
+    void MeasureFreeList(word ptr, word* blocks, word* words, word* largest)
+    {
+        *blocks = *words = *largest = 0;
+
+        while (ptr != H_EOL && *blocks <= H_MAX_MEM_ADDR) // Bounded, in case the list is corrupt.
+        {
+            (*blocks)++;
+            *words += memory[ptr + 1];
+            *largest = std::max(*largest, memory[ptr + 1]);
+            ptr = memory[ptr];
+        }
+    }
+
+    // Snapshot the metrics of the machine on this thread.
+    std::shared_ptr<const MetricsSnapshot> TakeMetricsSnapshot()
+    {
+        std::shared_ptr<MetricsSnapshot> snapshot = std::make_shared<MetricsSnapshot>();
+
+        snapshot->taken = std::chrono::steady_clock::now();
+        snapshot->clock = clock;
+        snapshot->instructions = mtops_instructions;
+#ifdef HYPO_PERF_COUNTERS
+        snapshot->context_switches = MachinePerfCounter(P_CONTEXT_SWITCHES);
+
+        for (int id = 0; id < P_CONTEXT_SWITCHES - P_SYSCALL; id++)
+        {
+            snapshot->syscalls[id] = MachinePerfCounter(P_SYSCALL + id);
+        }
+#endif
+        for (word ptr = RQ; ptr != H_EOL; ptr = memory[ptr + I_NEXT_POINTER]) { snapshot->ready++; }
+        for (word ptr = WQ; ptr != H_EOL; ptr = memory[ptr + I_NEXT_POINTER]) { snapshot->waiting++; }
+        snapshot->running = mtops_pcb_ptr != H_EOL ? 1 : 0;
+
+        MeasureFreeList(mtops_os_free_list, &snapshot->free_blocks[0], &snapshot->free_words[0], &snapshot->largest_free[0]);
+        MeasureFreeList(mtops_user_free_list, &snapshot->free_blocks[1], &snapshot->free_words[1], &snapshot->largest_free[1]);
+
+        snapshot->errors = mtops_error_counts;
+
+        return snapshot;
+    }
+
+    // Hand a fresh snapshot to the exporter once the interval has passed. Called between bursts.
+    void PublishMetrics(bool force = false)
+    {
+        auto now = std::chrono::steady_clock::now();
+        if (!force && now < mtops_metrics->next_publish) { return; }
+
+        mtops_metrics->next_publish = now + mtops_metrics->interval;
+        std::shared_ptr<const MetricsSnapshot> snapshot = TakeMetricsSnapshot();
+
+        std::lock_guard<std::mutex> guard(mtops_metrics->lock);
+        mtops_metrics->previous = std::move(mtops_metrics->latest);
+        mtops_metrics->latest = std::move(snapshot);
+    }
+
+    /*
+    * std::string: FormatMetrics
+    *
+    * Format a snapshot in the Prometheus text exposition format. Rates are taken against the
+    * snapshot before it.
+    *
+    * @param now The snapshot to format.
+    * @param before The snapshot published before it, or nullptr.
+    *
+    * @return The metrics text.
+    *
+    */
+    std::string FormatMetrics(const MetricsSnapshot& now, const MetricsSnapshot* before)
+    {
+        std::ostringstream out;
+        double seconds = before == nullptr ? 0 : std::chrono::duration<double>(now.taken - before->taken).count();
+
+        auto family = [&out](const char* name, const char* type, const char* help)
+        {
+            out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+        };
+
+        auto rate = [seconds](uint64_t current, uint64_t earlier)
+        {
+            return seconds > 0 ? (current - earlier) / seconds : 0.0;
+        };
+
+        family("hypo_clock", "gauge", "Machine clock in ticks.");
+        out << "hypo_clock " << now.clock << "\n";
+
+        family("hypo_instructions_total", "counter", "Guest instructions retired.");
+        out << "hypo_instructions_total " << now.instructions << "\n";
+
+        family("hypo_instructions_per_second", "gauge", "Guest instructions retired per second of wall time.");
+        out << "hypo_instructions_per_second " << rate(now.instructions, before ? before->instructions : 0) << "\n";
+
+        family("hypo_context_switches_total", "counter", "Processes dispatched.");
+        out << "hypo_context_switches_total " << now.context_switches << "\n";
+
+        family("hypo_context_switches_per_second", "gauge", "Processes dispatched per second of wall time.");
+        out << "hypo_context_switches_per_second " << rate(now.context_switches, before ? before->context_switches : 0) << "\n";
+
+        family("hypo_syscalls_total", "counter", "System calls, by ID.");
+        for (int id = 0; id < P_CONTEXT_SWITCHES - P_SYSCALL; id++)
+        {
+            if (now.syscalls[id] != 0) { out << "hypo_syscalls_total{id=\"" << id << "\"} " << now.syscalls[id] << "\n"; }
+        }
+
+        family("hypo_syscalls_per_second", "gauge", "System calls per second of wall time, by ID.");
+        for (int id = 0; id < P_CONTEXT_SWITCHES - P_SYSCALL; id++)
+        {
+            if (now.syscalls[id] != 0) { out << "hypo_syscalls_per_second{id=\"" << id << "\"} " << rate(now.syscalls[id], before ? before->syscalls[id] : 0) << "\n"; }
+        }
+
+        family("hypo_queue_length", "gauge", "PCBs in the ready and waiting queues.");
+        out << "hypo_queue_length{queue=\"rq\"} " << now.ready << "\nhypo_queue_length{queue=\"wq\"} " << now.waiting << "\n";
+
+        family("hypo_processes", "gauge", "Processes by state.");
+        out << "hypo_processes{state=\"ready\"} " << now.ready << "\nhypo_processes{state=\"waiting\"} " << now.waiting
+            << "\nhypo_processes{state=\"running\"} " << now.running << "\n";
+
+        const char* lists[2] = { "os", "user" };
+
+        family("hypo_free_list_blocks", "gauge", "Blocks on a free list.");
+        for (int list = 0; list < 2; list++) { out << "hypo_free_list_blocks{list=\"" << lists[list] << "\"} " << now.free_blocks[list] << "\n"; }
+
+        family("hypo_free_list_words", "gauge", "Words on a free list.");
+        for (int list = 0; list < 2; list++) { out << "hypo_free_list_words{list=\"" << lists[list] << "\"} " << now.free_words[list] << "\n"; }
+
+        family("hypo_free_list_largest_block", "gauge", "Largest block on a free list, in words.");
+        for (int list = 0; list < 2; list++) { out << "hypo_free_list_largest_block{list=\"" << lists[list] << "\"} " << now.largest_free[list] << "\n"; }
+
+        family("hypo_errors_total", "counter", "Errors by H_ERROR_CODE.");
+        for (const auto& error : now.errors)
+        {
+            out << "hypo_errors_total{code=\"" << error.first << "\"} " << error.second << "\n";
+        }
+
+        return out.str();
+    }
+
+    // Format the latest published snapshot, or nothing if none has been published yet.
+    std::string LatestMetrics(MetricsExporter* exporter)
+    {
+        std::shared_ptr<const MetricsSnapshot> latest, previous;
+
+        {
+            std::lock_guard<std::mutex> guard(exporter->lock);
+            latest = exporter->latest;
+            previous = exporter->previous;
+        }
+
+        return latest ? FormatMetrics(*latest, previous.get()) : std::string();
+    }
+
+    // Rewrite the metrics file every interval, through a temporary file so readers never see half of it.
+    void MetricsFileThread(MetricsExporter* exporter)
+    {
+        std::string temporary = exporter->target + ".tmp";
+        std::unique_lock<std::mutex> guard(exporter->lock);
+
+        while (true)
+        {
+            bool stopping = exporter->wake.wait_for(guard, exporter->interval, [exporter] { return exporter->stopping; });
+            guard.unlock();
+
+            std::string text = LatestMetrics(exporter);
+
+            if (!text.empty())
+            {
+                std::ofstream out(temporary, std::ios::trunc);
+                out << text;
+                out.close();
+
+                if (out) { std::rename(temporary.c_str(), exporter->target.c_str()); }
+            }
+
+            guard.lock();
+            if (stopping) { break; }
+        }
+    }
+
+#ifndef _WIN32
+    // Serve the metrics over HTTP on a Unix socket, one response per connection.
+    void MetricsSocketThread(MetricsExporter* exporter, int listener)
+    {
+        while (true)
+        {
+            {
+                std::lock_guard<std::mutex> guard(exporter->lock);
+                if (exporter->stopping) { break; }
+            }
+
+            pollfd poller = { listener, POLLIN, 0 };
+            if (poll(&poller, 1, 100) <= 0) { continue; }
+
+            int client = accept(listener, nullptr, nullptr);
+            if (client < 0) { continue; }
+
+            char request[1024];
+            pollfd reader = { client, POLLIN, 0 };
+            if (poll(&reader, 1, 100) > 0) { (void) !recv(client, request, sizeof(request), 0); } // Any request gets the metrics.
+
+            std::string body = LatestMetrics(exporter);
+            std::string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+                + std::to_string(body.size()) + "\r\n\r\n" + body;
+
+            for (size_t sent = 0; sent < response.size();)
+            {
+                ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+                if (n <= 0) { break; }
+                sent += n;
+            }
+
+            close(client);
+        }
+
+        close(listener);
+    }
+#endif
+
+    /*
+    * word: StartMetrics
+    *
+    * Start exporting the metrics of the machine on this thread.
+    *
+    * @param target A file to rewrite every interval, or unix:<path> for a socket to serve them on.
+    * @param interval Wall time between snapshots.
+    *
+    * @return OK, or E_FS_CANT_OPEN if the socket can't be opened.
+    *
+    */
+    word StartMetrics(const std::string& target, std::chrono::milliseconds interval)
+    {
+        MetricsExporter* exporter = new MetricsExporter();
+        exporter->target = target;
+        exporter->interval = interval;
+        exporter->next_publish = std::chrono::steady_clock::now();
+
+        if (target.compare(0, 5, "unix:") == 0)
+        {
+#ifndef _WIN32
+            std::string path = target.substr(5);
+            sockaddr_un address = {};
+            address.sun_family = AF_UNIX;
+
+            int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+            if (listener < 0 || path.empty() || path.size() >= sizeof(address.sun_path))
+            {
+                if (listener >= 0) { close(listener); }
+                std::cerr << "Can't open metrics socket [" + path + "]." << std::endl;
+                delete exporter;
+                return E_FS_CANT_OPEN;
+            }
+
+            memcpy(address.sun_path, path.c_str(), path.size());
+            unlink(path.c_str()); // A socket left by an earlier run.
+
+            if (bind(listener, (sockaddr*) &address, sizeof(address)) < 0 || listen(listener, 8) < 0)
+            {
+                close(listener);
+                std::cerr << "Can't open metrics socket [" + path + "]." << std::endl;
+                delete exporter;
+                return E_FS_CANT_OPEN;
+            }
+
+            exporter->thread = std::thread(MetricsSocketThread, exporter, listener);
+#else
+            std::cerr << "Metrics sockets are not supported on Windows." << std::endl;
+            delete exporter;
+            return E_FS_CANT_OPEN;
+#endif
+        }
+        else
+        {
+            exporter->thread = std::thread(MetricsFileThread, exporter);
+        }
+
+        mtops_metrics = exporter;
+        PublishMetrics(true);
+
+        return OK;
+    }
+
+    // Publish a last snapshot and stop the exporter.
+    void StopMetrics()
+    {
+        if (mtops_metrics == nullptr) { return; }
+
+        PublishMetrics(true);
+
+        {
+            std::lock_guard<std::mutex> guard(mtops_metrics->lock);
+            mtops_metrics->stopping = true;
+            mtops_metrics->wake.notify_one();
+        }
+
+        mtops_metrics->thread.join();
+
+        if (mtops_metrics->target.compare(0, 5, "unix:") == 0) { std::remove(mtops_metrics->target.substr(5).c_str()); }
+
+        delete mtops_metrics;
+        mtops_metrics = nullptr;
+    }
+
+    // A loop on a process' shadow call stack: the target of a backward branch and the furthest branch back to it.
+    struct ShadowFrame
+    {
+        word head;
+        word tail;
+    };
+
+    // Deepest shadow call stack the profiler keeps.
+    constexpr size_t H_SHADOW_DEPTH = 64;
+
+    // Clock ticks between profiler samples, 0 when the profiler is off.
+    thread_local word mtops_profile_period = 0;
+
+    // Clock of the next profiler sample.
+    thread_local word mtops_profile_next = std::numeric_limits<word>::max();
+
+    // Shadow call stacks of live processes, by PID, and the one of the running process.
+    thread_local std::unordered_map<word, std::vector<ShadowFrame>> mtops_shadow_stacks;
+    thread_local std::vector<ShadowFrame>* mtops_shadow = nullptr;
+
+    // Samples by stack: PID, loop heads from outermost to innermost, then the sampled PC.
+    thread_local std::map<std::vector<word>, uint64_t> mtops_profile_stacks;
+
+    // Samples by program address.
+    thread_local std::vector<uint64_t> mtops_profile_hits;
+
+    // Start sampling every period clock ticks, dropping earlier samples.
+    void StartProfiler(word period)
+    {
+        mtops_profile_period = period;
+        mtops_profile_next = clock + period;
+        mtops_profile_stacks.clear();
+        mtops_profile_hits.assign(H_MAX_PROGRAM_ADDR + 1, 0);
+    }
+
+    // Drop shadow call stacks and restart the sample countdown, for a machine that is booted, reset or restored.
+    void RebaseProfiler()
+    {
+        mtops_shadow_stacks.clear();
+        mtops_shadow = nullptr;
+
+        if (mtops_profile_period > 0) { mtops_profile_next = clock + mtops_profile_period; }
+    }
+
+    // Record a taken backward branch on the running process' shadow call stack. Loops that no longer contain the branch have been left.
+    void ProfileBranch(word from, word to)
+    {
+        std::vector<ShadowFrame>& stack = *mtops_shadow;
+
+        while (!stack.empty() && stack.back().head != to && (from < stack.back().head || from > stack.back().tail))
+        {
+            stack.pop_back();
+        }
+
+        if (!stack.empty() && stack.back().head == to) { stack.back().tail = std::max(stack.back().tail, from); }
+        else if (stack.size() < H_SHADOW_DEPTH) { stack.push_back({ to, from }); }
+    }
+
+    /*
+    * void: ProfileSample
+    *
+    * Attribute the sample points the clock has passed to the instruction that just ran, at r_mar.
+    * An instruction that spans several sample points gets one sample for each, so samples follow
+    * the clock cost of each instruction.
+    *
+    */
+    void ProfileSample()
+    {
+        word samples = 1 + (clock - mtops_profile_next) / mtops_profile_period;
+        mtops_profile_next += samples * mtops_profile_period;
+
+        word pc = r_mar;
+        std::vector<word> key(1, mtops_pcb_ptr == H_EOL ? H_EOL : memory[mtops_pcb_ptr + I_PID]);
+
+        if (mtops_shadow != nullptr)
+        {
+            std::vector<ShadowFrame>& stack = *mtops_shadow;
+
+            while (!stack.empty() && (pc < stack.back().head || pc > stack.back().tail))
+            {
+                stack.pop_back();
+            }
+
+            for (const ShadowFrame& frame : stack)
+            {
+                key.push_back(frame.head);
+            }
+        }
+
+        key.push_back(pc);
+        mtops_profile_stacks[key] += samples;
+
+        if (pc >= 0 && pc < (word) mtops_profile_hits.size()) { mtops_profile_hits[pc] += samples; }
+    }
+
+    // One instruction in the execution trace: where it was fetched, its raw word, the clock and
+    // process it was fetched at, and the operands it fetched.
+    struct TraceRecord
+    {
+        word pc;
+        word instruction;
+        word clock;
+        word pid;
+        word operands;
+        word op_addr[2];
+        word op_value[2];
+    };
+
+    // Records per trace chunk, and chunks in the ring between the CPU and the spill thread.
+    constexpr size_t H_TRACE_CHUNK = 4096;
+    constexpr size_t H_TRACE_RING = 4;
+
+    // Trace files start with this magic, followed by chunks of encoded records.
+    const char H_TRACE_MAGIC[8] = { 'H', 'Y', 'P', 'O', 'T', 'R', 'C', '1' };
+
+    // A trace being recorded. Full chunks go to the spill thread, which encodes them into the file and hands them back empty.
+    struct TraceSpill
+    {
+        std::ofstream out;
+        std::thread writer;
+        std::mutex lock;
+        std::condition_variable filled;
+        std::condition_variable drained;
+        std::deque<std::vector<TraceRecord>> full;
+        std::vector<std::vector<TraceRecord>> free;
+        bool stopping = false;
+    };
+
+    // Trace being recorded on this machine, nullptr when tracing is off.
+    thread_local TraceSpill* mtops_trace = nullptr;
+
+    // Chunk the CPU is filling, and the record of the running instruction, which takes its operands.
+    thread_local std::vector<TraceRecord> mtops_trace_chunk;
+    thread_local TraceRecord* mtops_trace_record = nullptr;
+
+    // Append an unsigned LEB128 varint.
+    void PutVarint(std::string& out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back((char) (value | 0x80));
+            value >>= 7;
+        }
+
+        out.push_back((char) value);
+    }
+
+    // Read an unsigned LEB128 varint, false if the bytes run out first.
+    bool GetVarint(const std::string& in, size_t* pos, uint64_t* value)
+    {
+        *value = 0;
+
+        for (int shift = 0; *pos < in.size() && shift < 64; shift += 7)
+        {
+            uint8_t byte = (uint8_t) in[(*pos)++];
+            *value |= (uint64_t) (byte & 0x7F) << shift;
+
+            if (!(byte & 0x80)) { return true; }
+        }
+
+        return false;
+    }
+
+    // Map small signed deltas to small unsigned varints and back.
+    uint64_t ZigZag(int64_t value) { return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63); }
+    int64_t UnZigZag(uint64_t value) { return (int64_t) (value >> 1) ^ -(int64_t) (value & 1); }
+
+    /*
+    * std::string: EncodeTraceChunk
+    *
+    * Encode a chunk of trace records. Each record is a flags byte (operand count, and bit 2 when the PID
+    * changed), then varints: the new PID, the PC relative to the word after the previous PC, the raw
+    * instruction, the clock delta, and for each operand its address relative to the same operand of the
+    * previous record and its value. Chunks start from a zero record so they decode on their own.
+    *
+    * @param chunk The records to encode.
+    *
+    * @return The chunk as count and byte length varints followed by the records.
+    *
+    */
+    std::string EncodeTraceChunk(const std::vector<TraceRecord>& chunk)
+    {
+        std::string body;
+        TraceRecord prev = {};
+
+        for (const TraceRecord& record : chunk)
+        {
+            bool new_pid = record.pid != prev.pid;
+            body.push_back((char) (record.operands | (new_pid ? 0x04 : 0)));
+
+            if (new_pid) { PutVarint(body, ZigZag(record.pid)); }
+
+            PutVarint(body, ZigZag(record.pc - (prev.pc + 1)));
+            PutVarint(body, ZigZag(record.instruction));
+            PutVarint(body, ZigZag(record.clock - prev.clock));
+
+            for (word op = 0; op < record.operands; op++)
+            {
+                PutVarint(body, ZigZag(record.op_addr[op] - prev.op_addr[op]));
+                PutVarint(body, ZigZag(record.op_value[op]));
+            }
+
+            prev = record;
+        }
+
+        std::string out;
+        PutVarint(out, chunk.size());
+        PutVarint(out, body.size());
+
+        return out + body;
+    }
+
+    // Spill thread of a trace: write full chunks until the trace stops and nothing is left.
+    void TraceSpillThread(TraceSpill* spill)
+    {
+        std::unique_lock<std::mutex> guard(spill->lock);
+
+        while (true)
+        {
+            spill->filled.wait(guard, [spill] { return !spill->full.empty() || spill->stopping; });
+            if (spill->full.empty()) { break; }
+
+            std::vector<TraceRecord> chunk = std::move(spill->full.front());
+            spill->full.pop_front();
+            guard.unlock();
+
+            std::string bytes = EncodeTraceChunk(chunk);
+            spill->out.write(bytes.data(), bytes.size());
+            chunk.clear();
+
+            guard.lock();
+            spill->free.push_back(std::move(chunk));
+            spill->drained.notify_one();
+        }
+    }
+
+    // Hand the full chunk to the spill thread and take an empty one, waiting if the spill thread is behind.
+    void SpillTraceChunk()
+    {
+        std::unique_lock<std::mutex> guard(mtops_trace->lock);
+
+        mtops_trace->full.push_back(std::move(mtops_trace_chunk));
+        mtops_trace->filled.notify_one();
+        mtops_trace->drained.wait(guard, [] { return !mtops_trace->free.empty(); });
+
+        mtops_trace_chunk = std::move(mtops_trace->free.back());
+        mtops_trace->free.pop_back();
+    }
+
+    // Start a record for the instruction just fetched into r_ir from r_mar.
+    void TraceFetch()
+    {
+        if (mtops_trace_chunk.size() == H_TRACE_CHUNK) { SpillTraceChunk(); }
+
+        mtops_trace_chunk.push_back({ r_mar, r_ir, clock, mtops_pcb_ptr == H_EOL ? H_EOL : memory[mtops_pcb_ptr + I_PID], 0, { 0, 0 }, { 0, 0 } });
+        mtops_trace_record = &mtops_trace_chunk.back();
+    }
+
+    // Add an operand the running instruction fetched to its record.
+    void TraceOperand(word op_addr, word op_value)
+    {
+        if (mtops_trace_record->operands < 2)
+        {
+            mtops_trace_record->op_addr[mtops_trace_record->operands] = op_addr;
+            mtops_trace_record->op_value[mtops_trace_record->operands] = op_value;
+            mtops_trace_record->operands++;
+        }
+    }
+
+    // Stop tracing, spilling what is left and closing the file.
+    void StopTrace()
+    {
+        if (mtops_trace == nullptr) { return; }
+
+        {
+            std::lock_guard<std::mutex> guard(mtops_trace->lock);
+
+            if (!mtops_trace_chunk.empty()) { mtops_trace->full.push_back(std::move(mtops_trace_chunk)); }
+
+            mtops_trace->stopping = true;
+            mtops_trace->filled.notify_one();
+        }
+
+        mtops_trace->writer.join();
+        delete mtops_trace;
+
+        mtops_trace = nullptr;
+        mtops_trace_record = nullptr;
+        mtops_trace_chunk = std::vector<TraceRecord>();
+    }
+
+    /*
+    * word: StartTrace
+    *
+    * Record every instruction the CPU runs from now on into a trace file, replacing any trace
+    * already being recorded.
+    *
+    * @param filename The trace file to write.
+    *
+    * @return OK, or E_FS_CANT_OPEN.
+    *
+    */
+    word StartTrace(const std::string& filename)
+    {
+        StopTrace();
+
+        TraceSpill* spill = new TraceSpill();
+        spill->out.open(filename, std::ios::binary | std::ios::trunc);
+
+        if (!spill->out.is_open())
+        {
+            Console() << "Failed to open trace file [" + filename + "].";
+            delete spill;
+            return E_FS_CANT_OPEN;
+        }
+
+        spill->out.write(H_TRACE_MAGIC, sizeof(H_TRACE_MAGIC));
+
+        for (size_t chunk = 1; chunk < H_TRACE_RING; chunk++)
+        {
+            spill->free.emplace_back();
+            spill->free.back().reserve(H_TRACE_CHUNK);
+        }
+
+        mtops_trace_chunk.clear();
+        mtops_trace_chunk.reserve(H_TRACE_CHUNK);
+
+        spill->writer = std::thread(TraceSpillThread, spill);
+        mtops_trace = spill;
+
+        return OK;
+    }
+
+    /*
+    * word: DecodeTrace
+    *
+    * Print a trace file one instruction per line: the clock it was fetched at and the delta from the
+    * previous one, the PID, the PC, the instruction and the operands it fetched.
+    *
+    * @param filename The trace file to read.
+    * @param out Where to print.
+    *
+    * @return OK, E_FS_CANT_OPEN, or E_MTOPS_BAD_TRACE if the file is not a complete trace.
+    *
+    */
+    word DecodeTrace(const std::string& filename, std::ostream& out)
+    {
+        std::ifstream in(filename, std::ios::binary);
+
+        if (!in.is_open())
+        {
+            std::cerr << "Failed to open trace file [" + filename + "]." << std::endl;
+            return E_FS_CANT_OPEN;
+        }
+
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        if (data.size() < sizeof(H_TRACE_MAGIC) || data.compare(0, sizeof(H_TRACE_MAGIC), H_TRACE_MAGIC, sizeof(H_TRACE_MAGIC)) != 0)
+        {
+            std::cerr << "[" + filename + "] is not a trace file." << std::endl;
+            return E_MTOPS_BAD_TRACE;
+        }
+
+        size_t pos = sizeof(H_TRACE_MAGIC);
+        word last_clock = 0;
+
+        while (pos < data.size())
+        {
+            uint64_t count, length, value;
+            if (!GetVarint(data, &pos, &count) || !GetVarint(data, &pos, &length) || length > data.size() - pos) { return E_MTOPS_BAD_TRACE; }
+
+            size_t end = pos + length;
+            TraceRecord prev = {};
+
+            for (uint64_t n = 0; n < count; n++)
+            {
+                if (pos >= end) { return E_MTOPS_BAD_TRACE; }
+
+                TraceRecord record = {};
+                record.pid = prev.pid;
+                uint8_t flags = (uint8_t) data[pos++];
+                record.operands = flags & 0x03;
+
+                if ((flags & 0x04) && GetVarint(data, &pos, &value)) { record.pid = UnZigZag(value); }
+
+                if (!GetVarint(data, &pos, &value)) { return E_MTOPS_BAD_TRACE; }
+                record.pc = prev.pc + 1 + UnZigZag(value);
+
+                if (!GetVarint(data, &pos, &value)) { return E_MTOPS_BAD_TRACE; }
+                record.instruction = UnZigZag(value);
+
+                if (!GetVarint(data, &pos, &value)) { return E_MTOPS_BAD_TRACE; }
+                record.clock = prev.clock + UnZigZag(value);
+
+                for (word op = 0; op < record.operands; op++)
+                {
+                    if (!GetVarint(data, &pos, &value)) { return E_MTOPS_BAD_TRACE; }
+                    record.op_addr[op] = prev.op_addr[op] + UnZigZag(value);
+
+                    if (!GetVarint(data, &pos, &value)) { return E_MTOPS_BAD_TRACE; }
+                    record.op_value[op] = UnZigZag(value);
+                }
+
+                word opcode = record.instruction / 10000;
+                word modes[2] = { record.instruction / 1000 % 10, record.instruction / 10 % 10 };
+                word gprs[2] = { record.instruction / 100 % 10, record.instruction % 10 };
+
+                out << "clock " << record.clock << " +" << record.clock - last_clock << " pid " << record.pid
+                    << " pc " << record.pc << ": " << std::setw(5) << std::setfill('0') << record.instruction << std::setfill(' ')
+                    << " " << (opcode >= 0 && opcode < H_OPCODE_COUNT ? debug_opcode_descs[opcode] : "invalid opcode");
+
+                for (word op = 0; op < record.operands; op++)
+                {
+                    out << (op == 0 ? " | " : ", ") << (modes[op] >= 0 && modes[op] <= 6 ? debug_opmode_descs[modes[op]] : "invalid opmode")
+                        << " r" << gprs[op] << " addr " << record.op_addr[op] << " = " << record.op_value[op];
+                }
+
+                out << "\n";
+
+                last_clock = record.clock;
+                prev = record;
+            }
+
+            if (pos != end) { return E_MTOPS_BAD_TRACE; }
+        }
+
+        return OK;
+    }
+
+    // Prototyping some methods.
+    long CreateProcess(std::string* filename, word priority);
+    struct ProgramImage;
+    long CreateProcessFromImage(const ProgramImage& image, word priority);
+    word InsertIntoRQ(word pcb_ptr);
+    void DetachAllSharedSegments(word pcb_ptr);
+    void CancelTimer(word pcb_ptr);
+    void ResetTimers();
+
+    // A set associative cache or TLB of the memory hierarchy model, keeping block numbers with LRU replacement.
+    struct CacheLevel
+    {
+        word set_mask = 0;
+        int ways = 0;
+        int line = 1;
+        std::vector<word> tags; // Block in each way of each set, or H_EOL.
+        std::vector<uint32_t> used; // When each way was last used.
+        uint32_t tick = 0;
+    };
+
+    // Memory hierarchy model of a machine: I-cache, D-cache and a unified TLB in front of the CPU's accesses to memory[].
+    struct CacheModel
+    {
+        CacheLevel icache;
+        CacheLevel dcache;
+        CacheLevel tlb;
+        word miss_ticks = 0;
+        word walk_ticks = 0;
+        word stall = 0; // Ticks added since the CPU last charged them to the burst.
+    };
+
+    // Memory hierarchy model of this machine, nullptr when it is off.
+    thread_local CacheModel mtops_cache_model;
+    thread_local CacheModel* mtops_cache = nullptr;
+
+    // Size a cache level and empty it.
+    void ShapeCacheLevel(CacheLevel& level, const CacheGeometry& geometry)
+    {
+        level.set_mask = geometry.sets - 1;
+        level.ways = geometry.ways;
+        level.line = geometry.line;
+        level.tags.assign((size_t) geometry.sets * geometry.ways, H_EOL);
+        level.used.assign(level.tags.size(), 0);
+        level.tick = 0;
+    }
+
+    // Empty a cache level, for a TLB on a context switch.
+    void FlushCacheLevel(CacheLevel& level)
+    {
+        level.tags.assign(level.tags.size(), H_EOL);
+        level.used.assign(level.used.size(), 0);
+    }
+
+    // Look a block up in a cache level, filling it over the least recently used way on a miss. Returns whether it hit.
+    inline bool CacheLookup(CacheLevel& level, word block)
+    {
+        size_t base = (size_t) (block & level.set_mask) * level.ways;
+        size_t victim = base;
+
+        for (size_t way = base; way < base + level.ways; way++)
+        {
+            if (level.tags[way] == block)
+            {
+                level.used[way] = ++level.tick;
+                return true;
+            }
+
+            if (level.used[way] < level.used[victim]) { victim = way; }
+        }
+
+        level.tags[victim] = block;
+        level.used[victim] = ++level.tick;
+
+        return false;
+    }
+
+    /*
+    * void: CacheAccess
+    *
+    * Run one CPU access to memory[] through the memory hierarchy model: the TLB, then the I-cache for
+    * code or the D-cache for data. Misses add their latency to the clock at once and to the stall
+    * the CPU charges to the burst; hits cost nothing beyond the instruction's own ticks. Stores
+    * allocate like loads and write-backs are not priced.
+    *
+    * @param code Whether the access reads the program area for the CPU.
+    * @param addr Physical address accessed.
+    *
+    */
+    void CacheAccess(bool code, word addr)
+    {
+        CacheModel* model = mtops_cache;
+        word ticks = 0;
+
+        if (CacheLookup(model->tlb, addr / model->tlb.line)) { H_PERF(mtops_perf->counts[P_CACHE_TLB_HITS]++); }
+        else { ticks += model->walk_ticks; H_PERF(mtops_perf->counts[P_CACHE_TLB_MISSES]++); }
+
+        CacheLevel& cache = code ? model->icache : model->dcache;
+
+        if (CacheLookup(cache, addr / cache.line)) { H_PERF(mtops_perf->counts[code ? P_ICACHE_HITS : P_DCACHE_HITS]++); }
+        else { ticks += model->miss_ticks; H_PERF(mtops_perf->counts[code ? P_ICACHE_MISSES : P_DCACHE_MISSES]++); }
+
+        if (ticks != 0)
+        {
+            clock += ticks;
+            model->stall += ticks;
+            H_PERF(mtops_perf->counts[P_MEMORY_STALL] += ticks);
+        }
+    }
+
+    // Read a word of data for the CPU.
+    inline word LoadData(word addr)
+    {
+        if (mtops_cache != nullptr) { CacheAccess(false, addr); }
+
+        return memory[addr];
+    }
+
+    // Write a word of data for the CPU.
+    inline void StoreData(word addr, word value)
+    {
+        if (mtops_cache != nullptr) { CacheAccess(false, addr); }
+
+        StoreWord(addr, value);
+    }
+
+    // Run every word of a block through the memory hierarchy model, for the block opcodes.
+    void CacheBlock(word addr, word count)
+    {
+        for (word i = 0; i < count; i++)
+        {
+            CacheAccess(false, addr + i);
+        }
+    }
+
+    // Build this machine's memory hierarchy model from h_cache_config, cold, or turn it off. Called when the machine is booted, reset or restored.
+    void ResetCacheModel()
+    {
+        if (!h_cache_config.enabled)
+        {
+            mtops_cache = nullptr;
+            return;
+        }
+
+        ShapeCacheLevel(mtops_cache_model.icache, h_cache_config.icache);
+        ShapeCacheLevel(mtops_cache_model.dcache, h_cache_config.dcache);
+        ShapeCacheLevel(mtops_cache_model.tlb, h_cache_config.tlb);
+        mtops_cache_model.miss_ticks = h_cache_config.miss_ticks;
+        mtops_cache_model.walk_ticks = h_cache_config.walk_ticks;
+        mtops_cache_model.stall = 0;
+        mtops_cache = &mtops_cache_model;
+    }
+
+    /*
+    * word: ConfigureCaches
+    *
+    * Turn the memory hierarchy model on from a spec: comma separated i=SETSxWAYSxLINE,
+    * d=SETSxWAYSxLINE, tlb=SETSxWAYS, miss=TICKS and walk=TICKS, each optional, or "on" for the
+    * defaults. Sets and ways must be powers of two. Machines pick it up when they next boot or reset.
+    *
+    * @param spec The spec.
+    *
+    * @return OK, or E_MTOPS_INVALID_SIZE for a spec that does not parse.
+    *
+    */
+    word ConfigureCaches(const std::string& spec)
+    {
+        CacheConfig config;
+        config.enabled = true;
+
+        auto power_of_two = [](int value) { return value > 0 && (value & (value - 1)) == 0; };
+
+        std::stringstream items(spec);
+        std::string item;
+
+        while (std::getline(items, item, ','))
+        {
+            size_t eq = item.find('=');
+            std::string key = item.substr(0, eq);
+            std::string value = eq == std::string::npos ? "" : item.substr(eq + 1);
+            char x1 = 0, x2 = 0;
+            bool ok = true;
+
+            if (key == "on" && eq == std::string::npos) { continue; }
+            else if (key == "i" || key == "d")
+            {
+                CacheGeometry& geometry = key == "i" ? config.icache : config.dcache;
+                std::istringstream in(value);
+                ok = (in >> geometry.sets >> x1 >> geometry.ways >> x2 >> geometry.line) && x1 == 'x' && x2 == 'x' && geometry.line > 0
+                    && power_of_two(geometry.sets) && power_of_two(geometry.ways) && (in >> std::ws).eof();
+            }
+            else if (key == "tlb")
+            {
+                std::istringstream in(value);
+                ok = (in >> config.tlb.sets >> x1 >> config.tlb.ways) && x1 == 'x'
+                    && power_of_two(config.tlb.sets) && power_of_two(config.tlb.ways) && (in >> std::ws).eof();
+            }
+            else if (key == "miss" || key == "walk")
+            {
+                std::istringstream in(value);
+                word& ticks = key == "miss" ? config.miss_ticks : config.walk_ticks;
+                ok = (in >> ticks) && ticks >= 0 && (in >> std::ws).eof();
+            }
+            else { ok = false; }
+
+            if (!ok)
+            {
+                std::cerr << "Invalid cache spec item: " << item << std::endl;
+                return E_MTOPS_INVALID_SIZE;
+            }
+        }
+
+        config.tlb.line = H_PAGE_SIZE;
+        h_cache_config = config;
+
+        return OK;
+    }
+
+    /*
+    * word: LoadCostTable
+    *
+    * Load instruction costs and scheduling limits from a config file. Each line is a name and a
+    * value: an opcode as debug_opcode_descs names it ("add", "branch on minus") with its cost in
+    * clock ticks, "block words per tick", "ttl", "quota" or "quota period". Blank lines and text
+    * after '#' are ignored, and anything not in the file keeps its value.
+    *
+    * @param filename The config file.
+    *
+    * @return OK, E_FS_CANT_OPEN, or E_MTOPS_INVALID_SIZE for a line that does not parse or a value below 1 (0 for quota).
+    *
+    */
+    word LoadCostTable(const std::string& filename)
+    {
+        std::ifstream in(filename);
+
+        if (!in)
+        {
+            std::cerr << "Cannot open file: " << filename;
+            return E_FS_CANT_OPEN;
+        }
+
+        std::string line;
+
+        for (int line_no = 1; std::getline(in, line); line_no++)
+        {
+            std::istringstream tokens(line.substr(0, line.find('#')));
+            std::vector<std::string> words;
+            std::string token;
+
+            while (tokens >> token) { words.push_back(token); }
+            if (words.empty()) { continue; }
+
+            // The last word is the value, the ones before it the name.
+            std::string key;
+            for (size_t i = 0; i + 1 < words.size(); i++) { key += (i > 0 ? " " : "") + words[i]; }
+
+            std::istringstream value_in(words.back());
+            word value = 0;
+            word* target = nullptr;
+
+            for (int opcode = 0; opcode < H_OPCODE_COUNT; opcode++)
+            {
+                if (key == debug_opcode_descs[opcode]) { target = &h_cycle_costs[opcode]; }
+            }
+
+            if (key == "block words per tick") { target = &h_block_words_per_tick; }
+            else if (key == "ttl") { target = &h_ttl; }
+            else if (key == "quota") { target = &h_quota; }
+            else if (key == "quota period") { target = &h_quota_period; }
+
+            if (target == nullptr || !(value_in >> value) || !(value_in >> std::ws).eof() || value < (target == &h_quota ? 0 : 1))
+            {
+                std::cerr << filename << ":" << line_no << ": invalid cost table line: " << line << std::endl;
+                return E_MTOPS_INVALID_SIZE;
+            }
+
+            *target = value;
+        }
+
+        return OK;
+    }
+
+    // A program page in a physical frame: the page table and page it belongs to, whether it was used
+    // since the clock hand last passed, and whether it is wired and never evicted.
+    struct PageFrame
+    {
+        word page_table = H_EOL;
+        word page = H_EOL;
+        bool referenced = false;
+        bool wired = false;
+    };
+
+    // A TLB entry: a page of the dispatched process' program area and the frame holding it.
+    struct TLBEntry
+    {
+        word page = H_EOL;
+        word frame = H_EOL;
+    };
+
+    // Paged program areas. Every process has a private program area kept in a slot of a swap file
+    // mapped into the host, and the physical program area is the page cache they run from.
+    struct VirtualMemory
+    {
+        word* swap = nullptr; // Swap slots of H_SWAP_SLOT_WORDS words.
+        size_t swap_bytes = 0;
+        std::vector<uint8_t> slot_used;
+        std::vector<PageFrame> frames; // One per page of the physical program area.
+        size_t hand = 0; // Clock hand of the replacement policy.
+        TLBEntry tlb[H_TLB_ENTRIES];
+        word page_table = H_EOL; // Page table of the dispatched process, the one the TLB maps.
+        word fault_page = H_EOL; // Page the last burst faulted on.
+#ifdef _WIN32
+        std::vector<word> host_swap; // Without mmap the swap stays in host memory.
+#endif
+    };
+
+    // Paging of this machine, nullptr when every process shares the flat program area.
+    thread_local VirtualMemory* mtops_vm = nullptr;
+
+    // First word of a swap slot.
+    inline word* SwapSlot(word slot)
+    {
+        return mtops_vm->swap + (size_t) slot * H_SWAP_SLOT_WORDS;
+    }
+
+    // Program area of a process as it sees it: its swap slot under paging, memory[] otherwise.
+    const word* ProcessCode(word pcb_ptr)
+    {
+        if (mtops_vm == nullptr) { return memory; }
+
+        return SwapSlot(memory[memory[pcb_ptr + I_PAGE_TABLE] + I_PT_SWAP_SLOT]);
+    }
+
+    // Frame holding a page of the dispatched process' program area, or H_EOL if the page is not resident. Misses walk the page table.
+    inline word TLBLookup(word page)
+    {
+        TLBEntry& entry = mtops_vm->tlb[page & (H_TLB_ENTRIES - 1)];
+        if (entry.page == page) { return entry.frame; }
+
+        H_PERF(mtops_perf->counts[P_TLB_MISSES]++);
+
+        word frame = memory[mtops_vm->page_table + I_PT_PAGES + page];
+        if (frame == H_EOL) { return H_EOL; }
+
+        entry.page = page;
+        entry.frame = frame;
+        mtops_vm->frames[frame].referenced = true; // The walk sets the accessed bit, as hardware would.
+
+        return frame;
+    }
+
+    /*
+    * bool: VMResident
+    *
+    * Check that every page the longest instruction at an address can reach is resident, so an
+    * instruction faults before it starts and never has to be undone halfway through its operands.
+    *
+    * @param addr Address of the instruction.
+    *
+    * @return true if the instruction can run, false with the missing page in fault_page if not.
+    *
+    */
+    bool VMResident(word addr)
+    {
+        word pages[2] = { addr / H_PAGE_SIZE, (addr + 2) / H_PAGE_SIZE };
+
+        for (word page : pages)
+        {
+            if (page < H_PROGRAM_PAGES && TLBLookup(page) == H_EOL)
+            {
+                mtops_vm->fault_page = page;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Physical address of a word of the dispatched process' program area. Under paging VMResident must have found it resident.
+    template <bool Paged>
+    inline word CodeAddress(word addr)
+    {
+        if (!Paged || addr > H_MAX_PROGRAM_ADDR) { return addr; }
+
+        return TLBLookup(addr / H_PAGE_SIZE) * H_PAGE_SIZE + addr % H_PAGE_SIZE;
+    }
+
+    // Read a word of the dispatched process' program area for the CPU.
+    template <bool Paged>
+    inline word CodeWord(word addr)
+    {
+        word physical = CodeAddress<Paged>(addr);
+
+        if (mtops_cache != nullptr) { CacheAccess(true, physical); }
+
+        return memory[physical];
+    }
+
+    // Read a word of the dispatched process' program area, for callers outside the CPU.
+    inline word ReadCode(word addr)
+    {
+        return memory[mtops_vm != nullptr ? CodeAddress<true>(addr) : addr];
+    }
+
+    // Point the TLB at a process' page table, dropping every entry of the previous one.
+    void SwitchAddressSpace(word page_table)
+    {
+        mtops_vm->page_table = page_table;
+
+        for (TLBEntry& entry : mtops_vm->tlb) { entry = TLBEntry(); }
+    }
+
+    // Free every frame and swap slot, for a machine that is booted.
+    void ResetPaging()
+    {
+        mtops_vm->slot_used.assign(mtops_vm->slot_used.size(), 0);
+        mtops_vm->frames.assign(mtops_vm->frames.size(), PageFrame());
+        mtops_vm->hand = 0;
+        mtops_vm->fault_page = H_EOL;
+
+        SwitchAddressSpace(H_EOL);
+    }
+
+    /*
+    * word: StartPaging
+    *
+    * Give every process created from now on a private, demand-paged program area. The swap file is
+    * created or truncated and mapped into the host. Must be called before the machine boots.
+    *
+    * @param filename The swap file.
+    * @param slots Program areas the swap file holds.
+    *
+    * @return OK, or E_FS_CANT_OPEN.
+    *
+    */
+    word StartPaging(const std::string& filename, word slots)
+    {
+        VirtualMemory* vm = new VirtualMemory();
+        vm->swap_bytes = (size_t) slots * H_SWAP_SLOT_WORDS * sizeof(word);
+
+#ifndef _WIN32
+        int fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+        if (fd < 0 || ftruncate(fd, (off_t) vm->swap_bytes) != 0)
+        {
+            if (fd >= 0) { close(fd); }
+            std::cerr << "Cannot open file: " << filename;
+            delete vm;
+            return E_FS_CANT_OPEN;
+        }
+
+        void* map = mmap(nullptr, vm->swap_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if (map == MAP_FAILED)
+        {
+            std::cerr << "Cannot map file: " << filename;
+            delete vm;
+            return E_FS_CANT_OPEN;
+        }
+
+        vm->swap = static_cast<word*>(map);
+#else
+        (void) filename;
+        vm->host_swap.assign(vm->swap_bytes / sizeof(word), 0);
+        vm->swap = vm->host_swap.data();
+#endif
+
+        vm->slot_used.assign((size_t) slots, 0);
+        vm->frames.assign(H_PROGRAM_FRAMES, PageFrame());
+        mtops_vm = vm;
+
+        ResetPaging();
+
+        return OK;
+    }
+
+    // Unmap the swap file and stop paging.
+    void StopPaging()
+    {
+        if (mtops_vm == nullptr) { return; }
+
+#ifndef _WIN32
+        munmap(mtops_vm->swap, mtops_vm->swap_bytes);
+#endif
+
+        delete mtops_vm;
+        mtops_vm = nullptr;
+    }
+
+    bool OSAddressInRange(int addr)
+    {
+        if (addr > H_MAX_USER_FREE_ADDR && addr <= H_MAX_MEM_ADDR)
+        {
+            return true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    /*
+    * bool: UserFreeAddressInRange
+    *
+    * Check if a given address in memory is in the range for the user-free list area.
+    *
+    * @param addr Address in memory.
+    * 
+    * @return true if in range, false if not in range.
+    * 
+    */
+    bool UserFreeAddressInRange(int addr)
+    {
+        if (addr > H_MAX_PROGRAM_ADDR && addr <= H_MAX_USER_FREE_ADDR)
+        {
+            return true;
+        }
+        else 
+        {
+            return false;
+        }
+    }
+
+    // Whether count words from addr lie in the user free area. An empty block always does.
+    bool BlockInRange(word addr, word count)
+    {
+        return count == 0 || (count > 0 && UserFreeAddressInRange(addr) && count <= H_MAX_USER_FREE_ADDR - addr + 1);
+    }
+
+    /*
+    * bool: ProgramAddressInRange
+    *
+    * Check if a given address in memory is in the range for the program area.
+    *
+    * @param addr Address in memory.
+    * 
+    * @return true if in range, false if not in range.
+    * 
+    */
+    bool ProgramAddressInRange(int addr)
+    {
+        if (addr > H_MAX_PROGRAM_ADDR || addr < H_PROGRAM_ADDR)
+        {
+            return false;
+        }
+        else
+        {
+            return true;
+        }
+    }
+
+    /*
+    * void: InitializeSystem
+    *
+    * Initialize the hypo machine. This will set all global Hypo fields to 0.
+    * 
+    */
+    void InitializeSystem()
+    {
+        // Initialize clock to 0.
+        clock = 0;
+
+        ResetPerfCounters();
+        RebaseProfiler();
+        ResetCacheModel();
+        mtops_verified_pids.clear();
+
+        if (mtops_vm != nullptr) { ResetPaging(); }
+
+        // Initalize memory to 0.
+        memset(memory, 0, sizeof(memory));
+        MarkAllPagesDirty();
+
+        // Initialize MAR and MBR to 0.
+        r_mar = 0;
+        r_mbr = 0;
+
+        // Initialize GPRs to 0.
+        memset(r_gpr, 0, sizeof(r_gpr));
+        
+        // Initialize IR, PSR, SP, PC to 0.
+        r_ir = 0;
+        r_psr = 0;
+        r_sp = 0;
+        r_pc = 0;
+
+        mtops_user_free_list = H_MAX_PROGRAM_ADDR + 1;
+        StoreWord(mtops_user_free_list + I_NEXT_POINTER, H_EOL);
+        StoreWord(mtops_user_free_list + 1, H_START_SIZE_USER_FREE);
+
+        mtops_os_free_list = H_MAX_USER_FREE_ADDR + 1;
+        StoreWord(mtops_os_free_list + I_NEXT_POINTER, H_EOL);
+        StoreWord(mtops_os_free_list + 1, H_START_SIZE_OS_FREE);
+
+        mtops_shm_list = H_EOL;
+
+        ResetTimers();
+
+        mtops_null_pid = mtops_pid; // The null process takes the next PID.
+
+        std::string nullf = h_null_program;
+        std::string* nullfp = &nullf;
+        CreateProcess(nullfp, 0);
+    }
+
+    // An EOM program parsed into host memory, so it can be committed to memory[] without reading the file again.
+    struct ProgramImage
+    {
+        std::vector<std::pair<word, word>> words; // Address and content pairs, in file order.
+        word entry = H_EOL; // First instruction to execute.
+    };
+
+    // One slice of a text EOM and the numbers parsed from it.
+    struct EOMChunk
+    {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        std::vector<int32_t> numbers; // Up to the first text that is not a number.
+        bool bad = false; // Whether it stopped at such text.
+        size_t first = 0; // Index of its first number in the whole file.
+        size_t stop = SIZE_MAX; // First pair from here whose address is H_EOF or outside the program area.
+    };
+
+    // Run fn(0) to fn(count - 1), all but the first on threads of their own.
+    template <typename Fn>
+    void ForEachChunk(size_t count, Fn fn)
+    {
+        std::vector<std::thread> threads;
+
+        for (size_t c = 1; c < count; c++) { threads.emplace_back(fn, c); }
+        fn(0);
+
+        for (std::thread& thread : threads) { thread.join(); }
+    }
+
+    // Parse a chunk's numbers the way ifstream >> int32_t would: skip blanks, take an optional sign and digits, and stop at anything else.
+    void ParseEOMChunk(EOMChunk* chunk)
+    {
+        const char* at = chunk->begin;
+
+        chunk->numbers.reserve((chunk->end - chunk->begin) / 4);
+
+        while (true)
+        {
+            while (at < chunk->end && isspace((unsigned char) *at)) { at++; }
+            if (at == chunk->end) { return; }
+
+            if (*at == '+' && at + 1 < chunk->end && at[1] != '-') { at++; } // from_chars takes no plus sign.
+
+            int32_t number;
+            auto parsed = std::from_chars(at, chunk->end, number);
+
+            if (parsed.ec != std::errc())
+            {
+                chunk->bad = true;
+                return;
+            }
+
+            chunk->numbers.push_back(number);
+            at = parsed.ptr;
+        }
+    }
+
+    /*
+    * int: ParseProgramImage
+    *
+    * Parses an EOM held in host memory into a program image. A text EOM is split at line breaks
+    * into one chunk per core, at most one per H_EOM_CHUNK_BYTES. The chunks are parsed in
+    * parallel and their addresses checked in parallel. The words are gathered only after the whole
+    * file is known to be valid.
+    *
+    * @param data The file's bytes.
+    * @param size The number of bytes.
+    * @param image The image to fill.
+    *
+    * @return The same status codes as AbsoluteLoader.
+    *
+    */
+    int ParseProgramImage(const char* data, size_t size, ProgramImage* image)
+    {
+        image->words.clear();
+
+        if (size >= sizeof(H_EOM_MAGIC) && memcmp(data, H_EOM_MAGIC, sizeof(H_EOM_MAGIC)) == 0)
+        {
+            size_t at = sizeof(H_EOM_MAGIC);
+            uint32_t count = 0;
+            int64_t pair[2];
+            int64_t entry;
+
+            auto take = [&](void* to, size_t bytes)
+            {
+                if (size - at < bytes) { return false; }
+
+                memcpy(to, data + at, bytes);
+                at += bytes;
+                return true;
+            };
+
+            if (!take(&count, sizeof(count))) { return E_NO_EOF; }
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                if (!take(pair, sizeof(pair))) { return E_NO_EOF; }
+
+                if (!ProgramAddressInRange((word) pair[0]))
+                {
+                    Console() << "Invalid address in program: " << pair[0];
+                    return E_INVALID_ADDR_IN_PROGRAM;
+                }
+
+                image->words.push_back(std::make_pair((word) pair[0], (word) pair[1]));
+            }
+
+            if (!take(&entry, sizeof(entry))) { return E_NO_EOF; }
+
+            if (!ProgramAddressInRange((word) entry))
+            {
+                Console() << "Invalid address for program counter: " << entry;
+                return E_INVALID_PC;
+            }
+
+            image->entry = (word) entry;
+            return image->entry;
+        }
+
+        size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<EOMChunk> chunks(std::max<size_t>(1, std::min(cores, size / H_EOM_CHUNK_BYTES)));
+        const char* from = data;
+
+        for (size_t c = 0; c < chunks.size(); c++)
+        {
+            const char* to = c + 1 == chunks.size() ? data + size : std::max(from, data + size * (c + 1) / chunks.size());
+
+            while (to > data && to < data + size && to[-1] != '\n') { to++; } // Numbers never straddle chunks.
+
+            chunks[c].begin = from;
+            chunks[c].end = to;
+            from = to;
+        }
+
+        ForEachChunk(chunks.size(), [&](size_t c) { ParseEOMChunk(&chunks[c]); });
+
+        // Number the chunks' numbers through the file; a stream would have stopped at the first bad one.
+        size_t total = 0;
+
+        for (size_t c = 0; c < chunks.size(); c++)
+        {
+            chunks[c].first = total;
+            total += chunks[c].numbers.size();
+
+            if (chunks[c].bad) { chunks.resize(c + 1); }
+        }
+
+        auto number = [&](size_t index)
+        {
+            size_t c = chunks.size() - 1;
+            while (chunks[c].first > index) { c--; }
+            return chunks[c].numbers[index - chunks[c].first];
+        };
+
+        // Each chunk finds its first pair that ends the program or breaks it. Pairs start at even indices,
+        // and one whose content is in the next chunk belongs to the chunk holding its address.
+        ForEachChunk(chunks.size(), [&](size_t c)
+        {
+            EOMChunk& chunk = chunks[c];
+
+            for (size_t index = chunk.first + chunk.first % 2; index + 1 < total && index < chunk.first + chunk.numbers.size(); index += 2)
+            {
+                int32_t addr = chunk.numbers[index - chunk.first];
+
+                if (addr == H_EOF || !ProgramAddressInRange(addr))
+                {
+                    chunk.stop = index / 2;
+                    break;
+                }
+            }
+        });
+
+        auto stopped = std::find_if(chunks.begin(), chunks.end(), [](const EOMChunk& chunk) { return chunk.stop != SIZE_MAX; });
+
+        if (stopped == chunks.end()) { return E_NO_EOF; }
+
+        size_t pairs = stopped->stop;
+        int32_t addr = number(pairs * 2);
+        int32_t content = number(pairs * 2 + 1);
+
+        if (addr != H_EOF)
+        {
+            Console() << "Invalid address in program: " << addr;
+            return E_INVALID_ADDR_IN_PROGRAM;
+        }
+
+        // The operand for opcode -1 is the first address to be executed from the EOM, so we should make
+        // sure it is pointing to a valid address.
+        if (!ProgramAddressInRange(content))
+        {
+            Console() << "Invalid address for program counter: " << content;
+            return E_INVALID_PC;
+        }
+
+        image->words.resize(pairs);
+
+        ForEachChunk(chunks.size(), [&](size_t c)
+        {
+            const EOMChunk& chunk = chunks[c];
+
+            for (size_t index = chunk.first + chunk.first % 2; index < pairs * 2 && index < chunk.first + chunk.numbers.size(); index += 2)
+            {
+                image->words[index / 2] = std::make_pair((word) chunk.numbers[index - chunk.first], (word) number(index + 1));
+            }
+        });
+
+        image->entry = content;
+
+        // Return the first instruction to execute.
+        return content;
+    }
+
+    /*
+    * int: ReadProgramImage
+    *
+    * Parses the given EOM file into a program image without touching memory. The file is mapped
+    * rather than read through a stream, see ParseProgramImage.
+    *
+    * @param filename The EOM file to read.
+    * @param image The image to fill.
+    *
+    * @return The same status codes as AbsoluteLoader.
+    *
+    */
+    int ReadProgramImage(std::string filename, ProgramImage* image)
+    {
+#ifndef _WIN32
+        int fd = open(filename.c_str(), O_RDONLY);
+
+        if (fd < 0)
+        {
+            std::cerr << "Cannot open file: " << filename;
+            return E_FS_CANT_OPEN;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            close(fd);
+            image->words.clear();
+            return E_NO_EOF;
+        }
+
+        void* map = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+
+        if (map == MAP_FAILED)
+        {
+            std::cerr << "Cannot map file: " << filename;
+            return E_FS_CANT_OPEN;
+        }
+
+        int status = ParseProgramImage(static_cast<const char*>(map), (size_t) st.st_size, image);
+        munmap(map, (size_t) st.st_size);
+
+        return status;
+#else
+        std::ifstream i_prog(filename, std::ios::binary);
+
+        if (!i_prog)
+        {
+            std::cerr << "Cannot open file: " << filename;
+            return E_FS_CANT_OPEN;
+        }
+
+        std::vector<char> data((std::istreambuf_iterator<char>(i_prog)), std::istreambuf_iterator<char>());
+
+        return ParseProgramImage(data.data(), data.size(), image);
+#endif
+    }
+
+    /*
+    * bool: VerifyProgram
+    *
+    * Check the code reachable from an entry point once, so CPU can run it without the checks it
+    * would otherwise repeat on every instruction. Follows every path from the entry and requires of
+    * each instruction on them: a valid opcode, valid modes and GPRs in all four fields, a mode for
+    * every operand it fetches, DIRECT operands in the user free area, no IMMEDIATE destination,
+    * and operand words and branch targets within the program area.
+    *
+    * A RETURN goes wherever its stack word says, so it is followed through the instruction after
+    * each CALL instead, and those return sites are handed back for CPU to hold RETURN to.
+    *
+    * Code in the program area can only change through the loader or a restore, which re-verify.
+    *
+    * @param code The program area the code runs from.
+    * @param entry Address of the first instruction.
+    * @param reason Why verification failed, if it did.
+    * @param at Address of the instruction that failed, if one did.
+    * @param return_sites Set for every address a verified CALL returns to.
+    *
+    * @return true if the code is verified.
+    *
+    */
+    bool VerifyProgram(const word* code, word entry, std::string* reason, word* at, std::vector<bool>* return_sites)
+    {
+        return_sites->assign(H_MAX_PROGRAM_ADDR + 1, false);
+
+        std::vector<uint8_t> seen(H_MAX_PROGRAM_ADDR + 1, 0);
+        std::vector<word> work(1, entry);
+
+        auto fail = [reason, at](const char* why, word pc) { *reason = why; *at = pc; return false; };
+
+        while (!work.empty())
+        {
+            word pc = work.back();
+            work.pop_back();
+
+            if (!ProgramAddressInRange(pc)) { return fail("branch target outside the program area", pc); }
+            if (seen[pc]) { continue; }
+            seen[pc] = 1;
+
+            word ir = code[pc];
+            word opcode = ir / 10000;
+            word modes[2] = { ir / 1000 % 10, ir / 10 % 10 };
+            word gprs[2] = { ir / 100 % 10, ir % 10 };
+
+            if (ir < 0 || opcode >= H_OPCODE_COUNT) { return fail("invalid opcode", pc); }
+            if (modes[0] > H_OPMODE::IMMEDIATE || modes[1] > H_OPMODE::IMMEDIATE) { return fail("invalid operand mode", pc); }
+            if (gprs[0] > 7 || gprs[1] > 7) { return fail("invalid GPR", pc); }
+
+            // Operands FetchOperand is called for, and whether the instruction is followed by a branch target.
+            int operands = OpcodeOperands(opcode);
+            bool branches = OpcodeBranches(opcode);
+            bool stores = (opcode >= H_OPCODE::ADD && opcode <= H_OPCODE::MOVE) || opcode == H_OPCODE::POP || opcode == H_OPCODE::BLOCK_SUM;
+
+            if (stores && modes[0] == H_OPMODE::IMMEDIATE) { return fail("immediate destination", pc); }
+
+            word next = pc + 1;
+
+            for (int op = 0; op < operands; op++)
+            {
+                if (modes[op] == H_OPMODE::NO_OP) { return fail("missing operand mode", pc); }
+
+                if (modes[op] == H_OPMODE::DIRECT || modes[op] == H_OPMODE::IMMEDIATE)
+                {
+                    if (!ProgramAddressInRange(next)) { return fail("operand outside the program area", pc); }
+                    if (modes[op] == H_OPMODE::DIRECT && !UserFreeAddressInRange(code[next])) { return fail("direct address outside the user free area", pc); }
+
+                    next++;
+                }
+            }
+
+            if (branches)
+            {
+                if (!ProgramAddressInRange(next)) { return fail("branch target word outside the program area", pc); }
+
+                work.push_back(code[next]);
+                next++;
+            }
+
+            if (opcode == H_OPCODE::CALL && ProgramAddressInRange(next)) { (*return_sites)[next] = true; }
+
+            if (opcode != H_OPCODE::HALT && opcode != H_OPCODE::BRANCH && opcode != H_OPCODE::RETURN) { work.push_back(next); }
+        }
+
+        return true;
+    }
+
+    // Verify the code a process can run from its saved PC on, and let CPU skip checks for it if that passes.
+    bool VerifyProcess(word pcb_ptr, bool report)
+    {
+        std::string reason;
+        word at = H_EOL;
+        word pid = memory[pcb_ptr + I_PID];
+        std::vector<bool> return_sites;
+
+        if (!VerifyProgram(ProcessCode(pcb_ptr), memory[pcb_ptr + I_R_PC], &reason, &at, &return_sites))
+        {
+            mtops_verified_pids.erase(pid);
+
+            if (report) { Console() << "\nProcess " << pid << " could not be verified (" << reason << " at " << at << "), it runs with every check."; }
+
+            return false;
+        }
+
+        mtops_verified_pids[pid] = std::move(return_sites);
+
+        return true;
+    }
+
+    // Verify every process again, after code in the program area was replaced.
+    void ReverifyProcesses()
+    {
+        mtops_verified_pids.clear();
+
+        word queues[2] = { RQ, WQ };
+
+        for (word ptr : queues)
+        {
+            for (word steps = 0; ptr != H_EOL && steps <= H_MAX_MEM_ADDR; steps++) // Bounded, in case the queue is stale.
+            {
+                VerifyProcess(ptr, false);
+                ptr = memory[ptr + I_NEXT_POINTER];
+            }
+        }
+
+        if (mtops_pcb_ptr != H_EOL) { VerifyProcess(mtops_pcb_ptr, false); }
+    }
+
+    // Store a program image's instructions into memory, then verify the processes whose code it may have replaced.
+    void CommitProgramImage(const ProgramImage& image)
+    {
+        for (const auto& entry : image.words)
+        {
+            StoreWord(entry.first, entry.second);
+        }
+
+        ReverifyProcesses();
+    }
+
+    /*
+    * int: AbsoluteLoader
+    *
+    * Loads the given EOM file and loads it into memory. Memory is only written once the whole
+    * file has been read and validated.
+    * 
+    * @param filename The EOM file to load.
+    * 
+    * @return One of the following status codes:
+    *   -1 = Cannot open file.
+    *   -2 = Invalid address in EOM.
+    *   -4 = Invalid PC.
+    *   -8 = No end-of-file marker in EOM.
+    * 
+    *   OR
+    * 
+    *   Any value over 0, which is to be the first instruction to be executed.
+    * 
+    */
+    int AbsoluteLoader(std::string filename)
+    {
+        ProgramImage image;
+
+        int status = ReadProgramImage(filename, &image);
+        if (status < 0) { return status; } // Error code.
+
+        CommitProgramImage(image);
+
+        Console() << "Program [" + filename + "] successfully loaded into memory.";
+
+        return status;
+    }
+
+    // Take the current memory contents as the baseline for diff-mode dumps.
+    void ResetDumpBaseline()
+    {
+        memcpy(mtops_dump_shadow, memory, sizeof(memory));
+        ClearDirtyPages(H_DIRTY_DUMP);
+    }
+
+    /*
+    * void: DumpChangedMemory
+    *
+    * Print the words in a range that changed since the previous diff-mode dump. Only pages written
+    * since then are compared, so the cost follows how much the machine did rather than the range.
+    *
+    * @param start_addr First address of the range.
+    * @param end_addr Last address of the range (inclusive).
+    *
+    */
+    void DumpChangedMemory(word start_addr, word end_addr)
+    {
+        using namespace std;
+
+        int changed = 0;
+
+        Console() << left << setw(11) << "\nAddress: " << setw(9) << "Old" << setw(9) << "New" << endl;
+
+        for (word page = start_addr / H_PAGE_SIZE; page <= end_addr / H_PAGE_SIZE; page++)
+        {
+            if ((mtops_dirty_pages[page] & H_DIRTY_DUMP) == 0)
+            {
+                continue; // Nothing written to this page since the last dump.
+            }
+
+            word first = page * H_PAGE_SIZE;
+            word last = first + H_PAGE_SIZE - 1;
+
+            for (word addr = (first > start_addr ? first : start_addr); addr <= (last < end_addr ? last : end_addr); addr++)
+            {
+                if (memory[addr] != mtops_dump_shadow[addr])
+                {
+                    Console() << left << setw(11) << addr << setw(9) << mtops_dump_shadow[addr] << setw(9) << memory[addr] << endl;
+                    mtops_dump_shadow[addr] = memory[addr];
+                    changed++;
+                }
+            }
+
+            if (first >= start_addr && last <= end_addr)
+            {
+                mtops_dirty_pages[page] &= ~H_DIRTY_DUMP; // Only forget pages this dump fully covered.
+            }
+        }
+
+        Console() << changed << " word(s) changed." << endl;
+    }
+
+    /*
+    * void: DumpMemory
+    *
+    * Dumps the running memory to the screen.
+    *
+    * @param str The header string to display.
+    * @param start_addr The address to start dumping from
+    * @param size How many values should be displayed past the start address.
+    * 
+    */
+    void DumpMemory(std::string str, word start_addr, word size)
+    {
+        using namespace std;
+
+        Console() << endl << str << endl;
+
+        // Checks for invalid starting location, ending location, or size. Checks for valid memory dump range between 0 and H_MAX_MEM_ADDR.
+        if (start_addr < 0 || start_addr > H_MAX_MEM_ADDR || size < 1 || start_addr + size > H_MAX_MEM_ADDR)
+        {
+            Console() << "Invalid parameter.";
+        }
+        else
+        {
+            Console() << setw(12) << "\nGPRs: " << setw(7) << "G0" << setw(7) << "G1" << setw(7) << "G2" << setw(7) << "G3" << setw(7) << "G4" << setw(7) << "G5" << setw(7) << "G6" << setw(7) << "G7" << setw(7) << "SP" << setw(7) << "PC" << endl; //Display GPR header.
+            Console() << left << setfill(' ') << setw(11) << " " << setw(7) << r_gpr[0] << setw(7) << r_gpr[1] << setw(7) << r_gpr[2] << setw(7) << r_gpr[3] << setw(7) << r_gpr[4] << setw(7) << r_gpr[5] << setw(7) << r_gpr[6] << setw(7) << r_gpr[7] << setw(7) << r_sp << setw(7) << r_pc << endl; //Display GPR, SP, and PC.
+
+            if (h_dump_diff)
+            {
+                DumpChangedMemory(start_addr, start_addr + size);
+
+                Console() << "Clock: " << clock << endl;
+                Console() << "PSR: " << r_psr << endl;
+                return;
+            }
+
+            Console() << left << setw(12) << "\nAddress: " << setw(7) << "+0" << setw(7) << "+1" << setw(7) << "+2" << setw(7) << "+3" << setw(7) << "+4" << setw(7) << "+5" << setw(7) << "+6" << setw(7) << "+7" << setw(7) << "+8" << setw(7) << "+9" << endl; //Display memory header.
+
+            int addr = start_addr;
+            int end_address = start_addr + size;
+
+            while (addr <= end_address)
+            {
+                // Print starting memory location in the row.
+                Console() << left << setw(11) << addr;
+
+                // Prints all values at the desired memory location until the end address is reached.
+                for (int i = 0; i < 10; i++)
+                {
+                    if (addr <= end_address)
+                    {
+                        Console() << setw(7) << memory[addr];
+                        addr++;
+                    }
+                    else
+                    {
+                        // No more values to print, break out of the loop.
+                        break;
+                    }
+                }
+                Console() << "\n";
+            }
+
+            Console() << "Clock: " << clock << endl;
+            Console() << "PSR: " << r_psr << endl;
+        }
+    }
+
+    /*
+    * word: FetchOperand
+    *
+    * Gets the operand from a given sliced EOM instruction from memory. Without Checked, the operand
+    * words are taken to be verified: DIRECT addresses and IMMEDIATE words are not range checked.
+    *
+    * @param op_mode The operand mode to process the operand with.
+    * @param op_reg The operand register for modes that access the GPRs.
+    * @param op_addr The address in memory to fetch.
+    * @param op_value The final value fetched from the instruction.
+    *
+    * @return A status code corresponding to H_ERROR_CODE.
+    * 
+    */
+    template <bool Checked = true, bool Paged = false>
+    word FetchOperand(word op_mode, word op_reg, word* op_addr, word* op_value)
+    {
+        switch (op_mode)
+        {
+
+        // ------ Register mode ------ Operand value is in the GPR.
+        case H_OPMODE::REGISTER:
+
+            // Set the address to a negative value, since our value is in a GPR.
+            *op_addr = -2;
+
+            *op_value = r_gpr[op_reg];
+
+            break;
+
+        // ------ Register deferred mode ------ Operand address is in a GPR & value is in memory.
+        case H_OPMODE::REGISTER_DEF:
+            *op_addr = r_gpr[op_reg];
+
+            if (UserFreeAddressInRange(*op_addr))
+            {
+                *op_value = LoadData(*op_addr);
+            }
+            else
+            {
+                Console() << "Invalid address in GPR: " << op_reg;
+                Console() << "\n-- Address: " << *op_addr;
+                Console() << "\n-- PC: " << r_pc;
+                return E_INVALID_ADDR_IN_GPR;
+            }
+
+            break;
+
+        // ------ Auto-increment mode ------ Operand address is in a GPR & operand value is in memory; auto-increment the register value.
+        case H_OPMODE::AUTO_INC:
+            *op_addr = r_gpr[op_reg];
+
+            if (UserFreeAddressInRange(*op_addr))
+            {
+                *op_value = LoadData(*op_addr);
+            }
+            else
+            {
+                Console() << "Invalid address in GPR: " << op_reg;
+                Console() << "\n-- Address: " << *op_addr;
+                Console() << "\n-- PC: " << r_pc;
+                return E_INVALID_ADDR_IN_GPR;
+            }
+
+            r_gpr[op_reg]++; // Increment register value +1.
+
+            break;
+
+        // ------ Auto-decrement mode ------ Operand address is in a GPR & operand value is in memory; auto-decrement the register value.
+        case H_OPMODE::AUTO_DEC:
+
+            // Decrement register value -1.
+            --r_gpr[op_reg];
+
+            *op_addr = r_gpr[op_reg];
+
+            if (UserFreeAddressInRange(*op_addr))
+            {
+                *op_value = LoadData(*op_addr);
+            }
+            else
+            {
+                Console() << "Invalid address in GPR: " << op_reg;
+                Console() << "\n-- Address: " << *op_addr;
+                Console() << "\n-- PC: " << r_pc;
+                return E_INVALID_ADDR_IN_GPR;
+            }
+
+            break;
+
+        // ------ Direct mode ------ Operand address is in the instruction, pointed to by r_pc.
+        case H_OPMODE::DIRECT:
+
+            // Get address from r_pc.
+            *op_addr = CodeWord<Paged>(r_pc++);
+
+            if (!Checked || UserFreeAddressInRange(*op_addr))
+            {
+                *op_value = LoadData(*op_addr);
+            }
+            else
+            {
+                Console() << "Invalid address in GPR: " << op_reg;
+                Console() << "\n-- Address: " << *op_addr;
+                Console() << "\n-- PC: " << r_pc;
+
+                return E_INVALID_ADDR_IN_GPR;
+            }
+
+            break;
+
+        // ------ Immediate mode ------ Operand value is in the instruction.
+        case H_OPMODE::IMMEDIATE:
+            if (!Checked || ProgramAddressInRange(r_pc))
+            {
+                // Set the address to a negative value, since our value is in a GPR.
+                *op_addr = -2;
+
+                *op_value = CodeWord<Paged>(r_pc++);
+            }
+            else
+            {
+                Console() << "Invalid address in PC: " << op_reg;
+                return E_INVALID_ADDR_IN_GPR;
+            }
+
+            break;
+        // ------ Invalid opmode ------
+        default:
+            Console() << "Invalid opmode: " << op_mode;
+            return E_INVALID_MODE;
+        }
+
+        if (mtops_trace_record != nullptr) { TraceOperand(*op_addr, *op_value); }
+
+        return OK;
+    }
+
+    /*
+    * void: InitializePCB
+    * 
+    * Initializes the simulated hardware for our PCB.
+    * 
+    * @param pcb_ptr The address in memory for the PCB.
+    * 
+    */
+    void InitializePCB(word pcb_ptr)
+    {
+        for (int pcb_idx = 0; pcb_idx < H_PCBSIZE; pcb_idx++)
+        {
+            StoreWord(pcb_ptr + pcb_idx, 0);
+        }
+
+        StoreWord(pcb_ptr + I_NEXT_POINTER, H_EOL);
+        StoreWord(pcb_ptr + I_PID, mtops_pid++);
+        StoreWord(pcb_ptr + I_STATE, H_READY_STATE);
+        StoreWord(pcb_ptr + I_PRIORITY, H_DEFAULT_PRIORITY);
+        StoreWord(pcb_ptr + I_SHM_LIST, H_EOL);
+        StoreWord(pcb_ptr + I_PREV_POINTER, H_EOL);
+        StoreWord(pcb_ptr + I_TIMER_SLOT, H_EOL);
+        StoreWord(pcb_ptr + I_PARENT_PID, H_EOL);
+        StoreWord(pcb_ptr + I_PAGE_TABLE, H_EOL);
+        StoreWord(pcb_ptr + I_QUOTA, h_quota);
+    }
+
+    // Allocate memory for the OS.
+    word AllocateOSMemory(word size)
+    {
+        if (mtops_os_free_list == H_EOL) // If there is no free memory (-1)
+        {
+            Console() << "No memory available to allocate.";
+            return E_MTOPS_INSUFFICIENT_MEM;
+        }
+
+        if (size <= 1) // If size is 1 or less, return, since 2 at minimum are required.
+        {
+            Console() << "Requested memory is too small. Must be >= 2.";
+            return E_MTOPS_REQ_MEM_TOO_SMALL;
+        }
+
+        word c_ptr = mtops_os_free_list; // c_ptr = free OS block
+        word p_ptr = H_EOL; // previous pointer = end of list
+
+        while (c_ptr != H_EOL)
+        {
+            if (memory[c_ptr + 1] == size) // If the size of the block = requested size, use this block
+            {
+                if (c_ptr == mtops_os_free_list) // First block is correct size
+                {
+                    mtops_os_free_list = memory[c_ptr]; // Adjust OS block pointer.
+                    StoreWord(c_ptr, H_EOL);
+                    return c_ptr; // Return block starting pointer
+                }
+                else // Size is exact but not the first block.
+                {
+                    StoreWord(p_ptr, memory[c_ptr]); 
+                    StoreWord(c_ptr, H_EOL);
+                    return c_ptr; // Return starting block pointer.
+                }
+            }
+            else if (memory[c_ptr + 1] >= size + 2) // Block is larger than requested, and the rest is big enough to stay a free block.
+            {
+                if (c_ptr == mtops_os_free_list) // First block 
+                {
+                    StoreWord(c_ptr + size, memory[c_ptr]); // Move next block pointer up until requested size is matched
+                    StoreWord(c_ptr + size + 1, memory[c_ptr + 1] - size); // Adjust block so it is the size it was - requested size.
+                    mtops_os_free_list = c_ptr + size;
+                    return c_ptr; // Return starting block pointer
+                }
+                else // Block was found but it was not the first block.
+                {
+                    StoreWord(c_ptr + size, memory[c_ptr]); // Move next block pointer up until requested size is matched
+                    StoreWord(c_ptr + size + 1, memory[c_ptr + 1] - size); // Adjust block so it is the size it was - requested size.
+                    StoreWord(p_ptr, c_ptr + size); // Adjust next pointer.
+                    StoreWord(c_ptr, H_EOL);
+                    return c_ptr; // Return starting block pointer.
+                }
+            }
+            else // Block is too small, continue iteration.
+            {
+                p_ptr = c_ptr;
+                c_ptr = memory[c_ptr];
+            }
+        }
+
+        Console() << "No memory blocks were large enough for the requested allocation size.";
+        return E_MTOPS_INSUFFICIENT_MEM;
+    }
+
+    // Allocate memory for the user.
+    word AllocateUserMemory(word size)
+    {
+        if (mtops_user_free_list == H_EOL)
+        {
+            Console() << "No memory available to allocate.";
+            return E_MTOPS_INSUFFICIENT_MEM;
+        }
+
+        if (size <= 1)
+        {
+            Console() << "Requested memory is too small. Must be >= 2.";
+            return E_MTOPS_REQ_MEM_TOO_SMALL;
+        }
+
+        word c_ptr = mtops_user_free_list;
+        word p_ptr = H_EOL;
+
+        while (c_ptr != H_EOL)
+        {
+            if (memory[c_ptr + 1] == size) // Block found of requested size.
+            {
+                if (c_ptr == mtops_user_free_list) // First block is the correct size.
+                {
+                    mtops_user_free_list = memory[c_ptr]; // Adjust user free list pointer to match the next user block pointer.
+                    StoreWord(c_ptr, H_EOL);
+                    if (h_debug) { Console() << "\nPointer returned [1]: " + c_ptr << std::endl; }
+                    return c_ptr;
+                }
+                else // Block found is correct size, but is not the first block.
+                {
+                    StoreWord(p_ptr, memory[c_ptr]); // Set pointer of previous block to pointer of current block
+                    StoreWord(c_ptr, H_EOL);
+                    if (h_debug) { Console() << "\nPointer returned [2]: " + c_ptr << std::endl; }
+                    return c_ptr; 
+                }
+            }
+            else if (memory[c_ptr + 1] >= size + 2) // Size is greater than requested, and the rest is big enough to stay a free block.
+            {
+                if (c_ptr == mtops_user_free_list) // First block meets requested size.
+                {
+                    StoreWord(c_ptr + size, memory[c_ptr]); // Move next block pointer up to the requested size.
+                    StoreWord(c_ptr + size + 1, memory[c_ptr + 1] - size); // Set block size to original block size - requested block size.
+                    mtops_user_free_list = c_ptr + size; // Adjust beginning of user free list to adjusted block.
+                    if (h_debug) { Console() << "\nPointer returned [3]: " + c_ptr << std::endl; }
+                    return c_ptr;
+                }
+                else // Block meets requested size but it is not the first block.
+                {
+                    StoreWord(c_ptr + size, memory[c_ptr]); // Move next block pointer up to request size.
+                    StoreWord(c_ptr + size + 1, memory[c_ptr + 1] - size); // Set block size to original block size - requested block size.
+                    StoreWord(p_ptr, c_ptr + size); // Set previous pointer block to current pointer + size.
+                    StoreWord(c_ptr, H_EOL);
+                    if (h_debug) { Console() << "\nPointer returned [4]: " + c_ptr << std::endl; }
+                    return c_ptr;
+                }
+            }
+            else // Current block is too small, move to next iteration.
+            {
+                p_ptr = c_ptr;
+                c_ptr = memory[c_ptr];
+            }
+        }
+
+        Console() << "No memory blocks were large enough for the requested allocation size.";
+        return E_MTOPS_INSUFFICIENT_MEM;
+    }
+
+    // Take location in memory and free it to OS free list. May error based on requested size and memory freed out of range.
+    word FreeOSMemory(word ptr, word size)
+    {
+        if (OSAddressInRange(ptr))
+        {
+            if (size <= 1)
+            {
+                Console() << "Requested memory is too small. Must be >= 2."; // Minimum alloc is 2, so return error if < 2.
+                return E_MTOPS_REQ_MEM_TOO_SMALL;
+            }
+            else // Size is correct.
+            {
+                if ((ptr + size) > H_MAX_MEM_ADDR) // The size would take pointer out of bounds, so error.
+                {
+                    Console() << "The requested memory size was too large.";
+                    return E_MTOPS_INVALID_MEM_RANGE;
+                }
+                else
+                {
+                    StoreWord(ptr, mtops_os_free_list); // Set pointer of free block to the leading address in OS free list.
+                    StoreWord(ptr + 1, size); // Set size of block to given size.
+                    mtops_os_free_list = ptr; // Set given pointer to be the leading address in OS free list.
+                    return OK;
+                }
+            }
+        }
+        else
+        {
+            Console() << "Pointer address is outside of the OS memory.";
+            return E_MTOPS_NOT_MEM_BLOCK;
+        }
+    }
+
+    word FreeUserMemory(word ptr, word size)
+    {
+        if (!UserFreeAddressInRange(ptr))
+        {
+            Console() << "Memory address out of bounds for user free memory.";
+            return E_MTOPS_NOT_MEM_BLOCK;
+        }
+        
+        if (size < 2) //Size to User memory to free is too small, return error.
+        {
+            Console() << "Memory size is too small, must be >= 2.";
+            return E_MTOPS_REQ_MEM_TOO_SMALL;
+        }
+        else if ((ptr + size) > H_MAX_MEM_ADDR) //Trying to free elements in memory that pass its' limit, return error.
+        {
+            Console() << "Requested size is too large and is out of bounds.";
+            return E_MTOPS_INVALID_MEM_RANGE;
+        }
+
+        StoreWord(ptr, mtops_user_free_list); //Set the pointer of the released free block to point to the 'front' of the UserFreeList (the newly released block is taking it's place at the front).
+        StoreWord(ptr + 1, size); //Set the size of this block in UserFreeList to the size given.
+        mtops_user_free_list = ptr; //Set the pointer given to be the new front of the UserFreeList.
+        return OK;
+    }
+
+    /*
+    * word: CreateAddressSpace
+    *
+    * Give a program image a private program area: a swap slot holding the image and a page table in
+    * OS memory with no page resident. Pages are read in when the process first runs from them.
+    *
+    * @param image The program to load.
+    *
+    * @return The page table address, or E_MTOPS_INSUFFICIENT_MEM if the swap or the OS area is full.
+    *
+    */
+    word CreateAddressSpace(const ProgramImage& image)
+    {
+        word slot = 0;
+        while (slot < (word) mtops_vm->slot_used.size() && mtops_vm->slot_used[slot]) { slot++; }
+
+        if (slot == (word) mtops_vm->slot_used.size())
+        {
+            Console() << "Swap is full, no program area for the process.";
+            return E_MTOPS_INSUFFICIENT_MEM;
+        }
+
+        word page_table = AllocateOSMemory(H_PAGE_TABLE_SIZE);
+        if (page_table < 0) { return page_table; } // Error code.
+
+        mtops_vm->slot_used[slot] = 1;
+
+        word* code = SwapSlot(slot);
+        memset(code, 0, H_SWAP_SLOT_WORDS * sizeof(word));
+
+        for (const auto& entry : image.words)
+        {
+            code[entry.first] = entry.second;
+        }
+
+        StoreWord(page_table + I_PT_REFS, 1);
+        StoreWord(page_table + I_PT_SWAP_SLOT, slot);
+
+        for (word page = 0; page < H_PROGRAM_PAGES; page++)
+        {
+            StoreWord(page_table + I_PT_PAGES + page, H_EOL);
+        }
+
+        return page_table;
+    }
+
+    // Drop a process' reference to its program area, freeing its frames, swap slot and page table with the last one.
+    void ReleaseAddressSpace(word page_table)
+    {
+        word refs = memory[page_table + I_PT_REFS] - 1;
+        StoreWord(page_table + I_PT_REFS, refs);
+
+        if (refs > 0) { return; } // A forked child still runs from it.
+
+        for (word page = 0; page < H_PROGRAM_PAGES; page++)
+        {
+            word frame = memory[page_table + I_PT_PAGES + page];
+            if (frame != H_EOL) { mtops_vm->frames[frame] = PageFrame(); }
+        }
+
+        if (mtops_vm->page_table == page_table) { SwitchAddressSpace(H_EOL); }
+
+        mtops_vm->slot_used[memory[page_table + I_PT_SWAP_SLOT]] = 0;
+        FreeOSMemory(page_table, H_PAGE_TABLE_SIZE);
+    }
+
+    // Take a page out of its frame. Processes cannot write their program area, so the swap copy is current and nothing is written back.
+    void EvictFrame(word frame)
+    {
+        PageFrame& victim = mtops_vm->frames[frame];
+        TLBEntry& entry = mtops_vm->tlb[victim.page & (H_TLB_ENTRIES - 1)];
+
+        StoreWord(victim.page_table + I_PT_PAGES + victim.page, H_EOL);
+
+        if (mtops_vm->page_table == victim.page_table && entry.page == victim.page) { entry = TLBEntry(); }
+
+        victim = PageFrame();
+    }
+
+    /*
+    * word: ClaimFrame
+    *
+    * Find a frame for a page with the clock policy: the hand takes the first free frame it reaches,
+    * or else the first one not referenced since it last passed, clearing referenced bits on the way.
+    *
+    * @return The frame, or E_MTOPS_INSUFFICIENT_MEM if every frame is wired.
+    *
+    */
+    word ClaimFrame()
+    {
+        size_t count = mtops_vm->frames.size();
+
+        for (size_t step = 0; step < 2 * count; step++)
+        {
+            word frame = (word) mtops_vm->hand;
+            PageFrame& candidate = mtops_vm->frames[frame];
+            mtops_vm->hand = (mtops_vm->hand + 1) % count;
+
+            if (candidate.page_table == H_EOL) { return frame; }
+            if (candidate.wired) { continue; }
+            if (candidate.referenced) { candidate.referenced = false; continue; }
+
+            EvictFrame(frame);
+
+            return frame;
+        }
+
+        return E_MTOPS_INSUFFICIENT_MEM;
+    }
+
+    // Read a page of a program area in from swap. Returns the frame, or an error code.
+    word PageIn(word page_table, word page, bool wired)
+    {
+        word frame = ClaimFrame();
+        if (frame < 0) { return frame; } // Error code.
+
+        memcpy(&memory[frame * H_PAGE_SIZE], SwapSlot(memory[page_table + I_PT_SWAP_SLOT]) + (size_t) page * H_PAGE_SIZE, H_PAGE_SIZE * sizeof(word));
+        mtops_dirty_pages[frame] = H_DIRTY_ALL;
+
+        PageFrame& claimed = mtops_vm->frames[frame];
+        claimed.page_table = page_table;
+        claimed.page = page;
+        claimed.referenced = true;
+        claimed.wired = wired;
+
+        StoreWord(page_table + I_PT_PAGES + page, frame);
+
+        return frame;
+    }
+
+    void TerminateProcess(word pcb_ptr)
+    {
+        H_PERF(RetirePerfCounters(memory[pcb_ptr + I_PID]));
+        mtops_verified_pids.erase(memory[pcb_ptr + I_PID]);
+
+        if (mtops_profile_period > 0)
+        {
+            if (mtops_shadow == &mtops_shadow_stacks[memory[pcb_ptr + I_PID]]) { mtops_shadow = nullptr; }
+            mtops_shadow_stacks.erase(memory[pcb_ptr + I_PID]);
+        }
+
+        DetachAllSharedSegments(pcb_ptr); // Drop this process' references to any shared segments.
+        CancelTimer(pcb_ptr); // Disarm the sleep timer, if any.
+
+        FreeUserMemory(memory[pcb_ptr + I_STACK_START], memory[pcb_ptr + I_STACK_SIZE]); // Return stack memory using stack start address and stack size in the given PCB.
+
+        if (mtops_vm != nullptr) { ReleaseAddressSpace(memory[pcb_ptr + I_PAGE_TABLE]); }
+
+        FreeOSMemory(pcb_ptr, H_PCBSIZE); // Return PCB memory using the pcb_ptr.
+    }
+
+    void PrintPCB(word pcb_ptr)
+    {
+        using namespace std;
+
+        Console() << "\nPCB @ " << pcb_ptr << ":" << endl;
+
+        //Prints PCB address, Next Pointer Address, PID, State, Priority, PC, and SP values of the PCB.
+        Console() << "PCB address = " << pcb_ptr << ", Next PCB Ptr = " << memory[pcb_ptr + I_NEXT_POINTER] << ", PID = " << memory[pcb_ptr + I_PID] << ", State = " << memory[pcb_ptr + I_STATE] << ", Reason for Waiting = " << memory[pcb_ptr + I_WAIT_REASON] << ", PC = " << memory[pcb_ptr + I_R_PC] << ", SP = " << memory[pcb_ptr + I_R_SP] << ", Priority = " << memory[pcb_ptr + I_PRIORITY] << ", STACK INFO: Starting Stack Address " << memory[pcb_ptr + I_STACK_START] << ", Stack Size = " << memory[pcb_ptr + I_STACK_SIZE] << endl;
+
+        //Prints the GPR values of the PCB.
+        Console() << "GPRs:   GPR0: " << memory[pcb_ptr + I_GPR0] << "   GPR1: " << memory[pcb_ptr + I_GPR1] << "   GPR2: " << memory[pcb_ptr + I_GPR2] << "   GPR3: " << memory[pcb_ptr + I_GPR3] << "   GPR4: " << memory[pcb_ptr + I_GPR4] << "   GPR5: " << memory[pcb_ptr + I_GPR5] << "   GPR6: " << memory[pcb_ptr + I_GPR6] << "   GPR7: " << memory[pcb_ptr + I_GPR7] << "\n" << endl;
+    }
+
+    // Create process given a filename and allocated a PCB for it. Also defines stack space for the program and dumps user program locations and memory addresses + contents.
+    // May error based on memory size given and file I/O errors.
+    //
+    //     Errors if: 
+    // requested size is too small.
+    // can't open file.
+    // not enough memory available.
+    // invalid PC.
+    // invalid mem address.
+    long CreateProcess(std::string *filename, word priority)
+    {
+        ProgramImage image;
+
+        word status = ReadProgramImage(*filename, &image); // Parse the file.
+        if (status < 0) { return status; } // Error code.
+
+        word pcb_ptr = CreateProcessFromImage(image, priority);
+        if (pcb_ptr < 0) { return pcb_ptr; } // Error code.
+
+        Console() << "Program [" + *filename + "] successfully loaded into memory.";
+
+        DumpMemory("\n User Program Area \n", H_PROGRAM_ADDR, H_TOTAL_USER_PROG);
+
+        PrintPCB(pcb_ptr);
+        InsertIntoRQ(pcb_ptr);
+
+        return OK;
+    }
+
+    /*
+    * long: CreateProcessFromImage
+    *
+    * Builds a process around an already parsed program image. The PCB is not queued
+    * and nothing is printed, so callers decide both.
+    *
+    * @param image The program to load.
+    * @param priority The priority of the process.
+    *
+    * @return The PCB address, or an error code.
+    *
+    */
+    long CreateProcessFromImage(const ProgramImage& image, word priority)
+    {
+        word pcb_ptr = AllocateOSMemory(H_PCBSIZE); // Allocate space for the PCB, returns leading address.
+        if (pcb_ptr < 0) { return pcb_ptr; } // Error code.
+
+        word u_ptr = AllocateUserMemory(h_stack_words); // Allocate user memory.
+        if (u_ptr < 0) { FreeOSMemory(pcb_ptr, H_PCBSIZE); return u_ptr; } // Error code.
+
+        InitializePCB(pcb_ptr); // Init the PCB.
+
+        if (mtops_vm != nullptr) // Load the program into a private program area.
+        {
+            word page_table = CreateAddressSpace(image);
+            if (page_table < 0) { FreeUserMemory(u_ptr, h_stack_words); FreeOSMemory(pcb_ptr, H_PCBSIZE); return page_table; } // Error code.
+
+            StoreWord(pcb_ptr + I_PAGE_TABLE, page_table);
+
+            if (memory[pcb_ptr + I_PID] == mtops_null_pid) // The null process must always be able to run, so its pages never leave.
+            {
+                for (const auto& entry : image.words)
+                {
+                    word page = entry.first / H_PAGE_SIZE;
+                    if (memory[page_table + I_PT_PAGES + page] == H_EOL) { PageIn(page_table, page, true); }
+                }
+            }
+        }
+        else
+        {
+            CommitProgramImage(image); // Load the program into memory.
+        }
+
+        StoreWord(pcb_ptr + I_R_PC, image.entry); // Set PC value in PCB.
+        StoreWord(pcb_ptr + I_STACK_START, u_ptr); // Set beginning stack addr in PCB.
+        StoreWord(pcb_ptr + I_R_SP, u_ptr - 1); // Set stack pointer.
+        StoreWord(pcb_ptr + I_STACK_SIZE, h_stack_words); // Set stack size.
+        StoreWord(pcb_ptr + I_PRIORITY, priority); // Set prioerity.
+
+        if (memory[pcb_ptr + I_PID] == mtops_null_pid) { StoreWord(pcb_ptr + I_QUOTA, 0); } // The null process runs whenever nothing else can.
+
+        VerifyProcess(pcb_ptr, true);
+
+        return pcb_ptr;
+    }
+
+    // Print data from the queue given a pointer.
+    long PrintQueue(long queue_ptr)
+    {
+        long c_pcb_ptr = queue_ptr;
+
+        if (c_pcb_ptr == H_EOL) //If the initial address is EndOfList, then the list itself is empty.
+        {
+            Console() << "Empty list."; 
+            return OK;
+        }
+
+        // Walk thru the queue.
+        while (c_pcb_ptr != H_EOL)
+        {
+            PrintPCB(c_pcb_ptr);
+            c_pcb_ptr = memory[c_pcb_ptr + I_NEXT_POINTER]; // Next pointer.
+        }
+
+        return OK;
+
+    }
+
+    // Insert into the waiting queue given a pcb pointer.
+    word InsertIntoWQ(word pcb_ptr)
+    {
+        if (pcb_ptr < 0 || pcb_ptr > H_MAX_MEM_ADDR)
+        {
+            Console() << "Invalid memory range.";
+            return E_MTOPS_INVALID_MEM_RANGE;
+        }
+
+        StoreWord(pcb_ptr + I_STATE, H_WAITING_STATE); //Set the PCB's state to "waiting."
+        H_PERF(StoreWord(pcb_ptr + I_QUEUED_CLOCK, clock));
+        StoreWord(pcb_ptr + I_NEXT_POINTER, WQ);
+        StoreWord(pcb_ptr + I_PREV_POINTER, H_EOL); // WQ is doubly linked so timers can unlink a PCB without a search.
+        if (WQ != H_EOL) { StoreWord(WQ + I_PREV_POINTER, pcb_ptr); }
+        WQ = pcb_ptr;
+
+        return OK;
+
+    }
+
+    // Unlink a PCB that is known to be in the WQ.
+    void RemovePCBfromWQ(word pcb_ptr)
+    {
+        word next_ptr = memory[pcb_ptr + I_NEXT_POINTER];
+        word prev_ptr = memory[pcb_ptr + I_PREV_POINTER];
+
+        if (prev_ptr == H_EOL) { WQ = next_ptr; } // First PCB in WQ.
+        else { StoreWord(prev_ptr + I_NEXT_POINTER, next_ptr); }
+
+        if (next_ptr != H_EOL) { StoreWord(next_ptr + I_PREV_POINTER, prev_ptr); }
+
+        StoreWord(pcb_ptr + I_NEXT_POINTER, H_EOL);
+        StoreWord(pcb_ptr + I_PREV_POINTER, H_EOL);
+
+        H_PERF(PerfCounters& perf = mtops_process_perf[memory[pcb_ptr + I_PID]];
+               perf.counts[P_WQ_WAIT] += clock - memory[pcb_ptr + I_QUEUED_CLOCK];
+               RecordLatency(perf.latency[L_WQ_WAIT], clock - memory[pcb_ptr + I_QUEUED_CLOCK]));
+    }
+
+    // Insert into the ready queue given a PCB pointer.
+    word InsertIntoRQ(word pcb_ptr)
+    {
+        word p_ptr = H_EOL;
+        word c_ptr = RQ;
+
+        if (pcb_ptr < 0 || pcb_ptr > H_MAX_MEM_ADDR)
+        {
+            Console() << "Invalid memory range.";
+            return E_MTOPS_INVALID_MEM_RANGE;
+        }
+
+        StoreWord(pcb_ptr + I_STATE, H_READY_STATE); //Set the PCB's state to "ready."
+        StoreWord(pcb_ptr + I_NEXT_POINTER, H_EOL); //Set the PCB's Next Pointer value to EndOfList.
+        H_PERF(StoreWord(pcb_ptr + I_QUEUED_CLOCK, clock));
+
+        if (RQ == H_EOL) //If RQ is equal to the value of EndOfList (-1), then RQ is empty.
+        {
+            RQ = pcb_ptr;
+            return OK;
+        }
+
+        while (c_ptr != H_EOL)
+        {
+            if (memory[pcb_ptr + I_PRIORITY] > memory[c_ptr + I_PRIORITY]) //If the priority of the PCB we want to insert is higher than the priority of the current PCB...
+            {
+                if (p_ptr == H_EOL) //If p_ptr is EndOfList, then the priority of the PCB that we want to insert is higher than the highest priority PCB.
+                {
+                    StoreWord(pcb_ptr + I_NEXT_POINTER, RQ); //Change the current PCB's next pointer from EOL to the first PCB in the ready queue.
+                    RQ = pcb_ptr; //Change the RQ value to the address of the PCB that we want to insert (because it is now the head of the queue).
+                    return OK;
+                }
+
+                //If it isn't at the start of the RQ, then we're inserting this PCB into the middle of the list.
+                StoreWord(pcb_ptr + I_NEXT_POINTER, memory[p_ptr + I_NEXT_POINTER]); //Set pcb_ptr's next pointer index to the previous pointer's next pointer index, because pcb_ptr is taking over the previous pointer's slot.
+                StoreWord(p_ptr + I_NEXT_POINTER, pcb_ptr); //Set the previous pointer's next pointer index to the PCB address, completing the insertion.
+                return OK;
+            }
+
+            else //PCB to be inserted has lower or equal priority as the current PCB in RQ, move on to the next PCB.
+            {
+                p_ptr = c_ptr;
+                c_ptr = memory[c_ptr + I_NEXT_POINTER];
+            }
+        }
+
+        //If it gets to this point in the InsertIntoRQ() function, than the PCB we want to insert has the lowest priority in the RQ. Insert the new PCB into the end of the RQ.
+        StoreWord(p_ptr + I_NEXT_POINTER, pcb_ptr); //Change the previous pointer's next pointer index from EOL to the new PCB address. Note that the new PCB has a next pointer address of EOL.
+        return OK;
+
+    }
+
+    // Get the PCB for a PID from the WQ.
+    word SearchAndRemovePCBfromWQ(word this_pid)
+    {
+        word currentpcb_ptr = WQ;
+
+        if (this_pid < 1) //PID cannot be zero or less than zero. Check for an incorrect PID.
+        {
+            Console() << "Invalid PID.";
+            return E_MTOPS_INVALID_PID;
+        }
+
+        //Search WQ for a PCB that has the given pid. If a match is found, remove it from WQ and return the PCB pointer
+        while (currentpcb_ptr != H_EOL)
+        {
+            if (memory[currentpcb_ptr + I_PID] == this_pid) //If the current pointer's PID matches the PID we're looking for, then a match is found. Remove that process from WQ.
+            {
+                RemovePCBfromWQ(currentpcb_ptr); //Unlink the PCB, its next pointer index is reset to 'EndOfList'.
+                CancelTimer(currentpcb_ptr); //An event that completes the wait also disarms any sleep timer.
+                return currentpcb_ptr; //Return matching PCB.
+            }
+
+            currentpcb_ptr = memory[currentpcb_ptr + I_NEXT_POINTER];
+        }
+
+        Console() << "No process with ID " << this_pid << " could be found.";
+        return E_MTOPS_INVALID_PID; // TODO: Replace with new error.
+    }
+
+    // Index of the lowest set bit of a non-zero timer bitmap.
+    int LowestTimerSlot(uint64_t bits)
+    {
+#ifdef _MSC_VER
+        unsigned long idx;
+        _BitScanForward64(&idx, bits);
+        return (int) idx;
+#else
+        return __builtin_ctzll(bits);
+#endif
+    }
+
+    // Disarm every timer and restart the wheel at the current clock.
+    void ResetTimers()
+    {
+        for (int level = 0; level < H_TIMER_LEVELS; level++)
+        {
+            for (int slot = 0; slot < H_TIMER_SLOTS; slot++)
+            {
+                mtops_timer_wheel[level][slot] = H_EOL;
+            }
+
+            mtops_timer_bitmap[level] = 0;
+        }
+
+        mtops_timer_time = clock;
+        mtops_timer_count = 0;
+    }
+
+    // Link a PCB into the wheel slot for its wake time, relative to the time the wheel has been advanced to.
+    void LinkTimer(word pcb_ptr)
+    {
+        word delta = memory[pcb_ptr + I_WAKE_TIME] - mtops_timer_time;
+        word expires = memory[pcb_ptr + I_WAKE_TIME];
+        int level = 0;
+
+        if (delta < 0) { expires = mtops_timer_time; } // Already due, fire on the next advance.
+
+        while (level < H_TIMER_LEVELS - 1 && delta >= ((word) 1 << (H_TIMER_BITS * (level + 1))))
+        {
+            level++;
+        }
+
+        if (delta >= ((word) 1 << (H_TIMER_BITS * H_TIMER_LEVELS)))
+        {
+            expires = mtops_timer_time + ((word) 1 << (H_TIMER_BITS * H_TIMER_LEVELS)) - 1; // Past the top level, park in its furthest slot and cascade again later.
+        }
+
+        int slot = (int) ((expires >> (H_TIMER_BITS * level)) & (H_TIMER_SLOTS - 1));
+        word head = mtops_timer_wheel[level][slot];
+
+        StoreWord(pcb_ptr + I_TIMER_NEXT, head);
+        StoreWord(pcb_ptr + I_TIMER_PREV, H_EOL);
+        if (head != H_EOL) { StoreWord(head + I_TIMER_PREV, pcb_ptr); }
+
+        mtops_timer_wheel[level][slot] = pcb_ptr;
+        mtops_timer_bitmap[level] |= (uint64_t) 1 << slot;
+        StoreWord(pcb_ptr + I_TIMER_SLOT, level * H_TIMER_SLOTS + slot);
+    }
+
+    // Unlink a PCB from its wheel slot.
+    void UnlinkTimer(word pcb_ptr)
+    {
+        int level = (int) (memory[pcb_ptr + I_TIMER_SLOT] / H_TIMER_SLOTS);
+        int slot = (int) (memory[pcb_ptr + I_TIMER_SLOT] % H_TIMER_SLOTS);
+        word next_ptr = memory[pcb_ptr + I_TIMER_NEXT];
+        word prev_ptr = memory[pcb_ptr + I_TIMER_PREV];
+
+        if (prev_ptr == H_EOL) { mtops_timer_wheel[level][slot] = next_ptr; }
+        else { StoreWord(prev_ptr + I_TIMER_NEXT, next_ptr); }
+
+        if (next_ptr != H_EOL) { StoreWord(next_ptr + I_TIMER_PREV, prev_ptr); }
+
+        if (mtops_timer_wheel[level][slot] == H_EOL)
+        {
+            mtops_timer_bitmap[level] &= ~((uint64_t) 1 << slot);
+        }
+
+        StoreWord(pcb_ptr + I_TIMER_SLOT, H_EOL);
+    }
+
+    // Arm a timer that moves the PCB from the WQ to the RQ once the clock reaches wake_time. O(1).
+    void AddTimer(word pcb_ptr, word wake_time)
+    {
+        StoreWord(pcb_ptr + I_WAKE_TIME, wake_time);
+        LinkTimer(pcb_ptr);
+        mtops_timer_count++;
+    }
+
+    // Disarm the PCB's timer, if it has one. O(1).
+    void CancelTimer(word pcb_ptr)
+    {
+        if (memory[pcb_ptr + I_TIMER_SLOT] == H_EOL)
+        {
+            return;
+        }
+
+        UnlinkTimer(pcb_ptr);
+        mtops_timer_count--;
+    }
+
+    /*
+    * word: NextTimerEvent
+    *
+    * Find the next clock time at which the wheel has work to do, either firing a level 0 slot or
+    * cascading a higher level slot down. Uses the slot bitmaps, so the cost does not depend on how
+    * many processes are sleeping.
+    *
+    * @return The clock time of the next event, or H_EOL if no timer is armed.
+    *
+    */
+    word NextTimerEvent()
+    {
+        word next = H_EOL;
+
+        for (int level = 0; level < H_TIMER_LEVELS; level++)
+        {
+            uint64_t bits = mtops_timer_bitmap[level];
+            if (bits == 0) { continue; }
+
+            int shift = H_TIMER_BITS * level;
+            word span = (word) 1 << (shift + H_TIMER_BITS); // Ticks covered by one turn of this level.
+            int current = (int) ((mtops_timer_time >> shift) & (H_TIMER_SLOTS - 1));
+            int first = (level == 0) ? current : current + 1; // Level 0's current slot is due now, higher levels' current slot is a full turn away.
+
+            uint64_t ahead = (first < H_TIMER_SLOTS) ? bits & (~(uint64_t) 0 << first) : 0;
+            word base = mtops_timer_time & ~(span - 1);
+            word event;
+
+            if (ahead != 0) { event = base + ((word) LowestTimerSlot(ahead) << shift); }
+            else { event = base + span + ((word) LowestTimerSlot(bits) << shift); }
+
+            if (next == H_EOL || event < next) { next = event; }
+        }
+
+        return next;
+    }
+
+    /*
+    * void: AdvanceTimers
+    *
+    * Advance the timer wheel to the given clock time, moving every PCB whose wake time has passed
+    * from the WQ to the RQ. Jumps straight between occupied slots, so each timer costs O(1) to expire
+    * (plus at most one cascade per level).
+    *
+    * @param now The clock time to advance to.
+    *
+    */
+    void AdvanceTimers(word now)
+    {
+        while (mtops_timer_count > 0)
+        {
+            word event = NextTimerEvent();
+            if (event > now) { break; }
+
+            mtops_timer_time = event;
+
+            // Cascade higher level slots that start at this tick down into lower levels.
+            for (int level = H_TIMER_LEVELS - 1; level > 0; level--)
+            {
+                int shift = H_TIMER_BITS * level;
+                if ((event & (((word) 1 << shift) - 1)) != 0) { continue; }
+
+                int slot = (int) ((event >> shift) & (H_TIMER_SLOTS - 1));
+                word pcb_ptr = mtops_timer_wheel[level][slot];
+
+                mtops_timer_wheel[level][slot] = H_EOL;
+                mtops_timer_bitmap[level] &= ~((uint64_t) 1 << slot);
+
+                while (pcb_ptr != H_EOL)
+                {
+                    word next_ptr = memory[pcb_ptr + I_TIMER_NEXT];
+                    LinkTimer(pcb_ptr);
+                    pcb_ptr = next_ptr;
+                }
+            }
+
+            // Fire everything in the level 0 slot for this tick.
+            int slot = (int) (event & (H_TIMER_SLOTS - 1));
+            word pcb_ptr = mtops_timer_wheel[0][slot];
+
+            mtops_timer_wheel[0][slot] = H_EOL;
+            mtops_timer_bitmap[0] &= ~((uint64_t) 1 << slot);
+
+            while (pcb_ptr != H_EOL)
+            {
+                word next_ptr = memory[pcb_ptr + I_TIMER_NEXT];
+
+                StoreWord(pcb_ptr + I_TIMER_SLOT, H_EOL);
+                mtops_timer_count--;
+
+                RemovePCBfromWQ(pcb_ptr);
+                InsertIntoRQ(pcb_ptr);
+
+                pcb_ptr = next_ptr;
+            }
+        }
+
+        if (now > mtops_timer_time)
+        {
+            mtops_timer_time = now;
+        }
+    }
+
+    // Re-anchor the wheel at the current clock after TIME_SET moved it backwards. Wake times stay absolute.
+    void RebaseTimers()
+    {
+        std::vector<word> armed;
+
+        for (int level = 0; level < H_TIMER_LEVELS; level++)
+        {
+            for (int slot = 0; slot < H_TIMER_SLOTS; slot++)
+            {
+                for (word pcb_ptr = mtops_timer_wheel[level][slot]; pcb_ptr != H_EOL; pcb_ptr = memory[pcb_ptr + I_TIMER_NEXT])
+                {
+                    armed.push_back(pcb_ptr);
+                }
+
+                mtops_timer_wheel[level][slot] = H_EOL;
+            }
+
+            mtops_timer_bitmap[level] = 0;
+        }
+
+        mtops_timer_time = clock;
+
+        for (word pcb_ptr : armed)
+        {
+            LinkTimer(pcb_ptr);
+        }
+    }
+
+    // Find the PCB of a ready or waiting process by PID. Returns H_EOL if there is none.
+    word FindPCB(word pid)
+    {
+        for (word c_ptr = RQ; c_ptr != H_EOL; c_ptr = memory[c_ptr + I_NEXT_POINTER])
+        {
+            if (memory[c_ptr + I_PID] == pid) { return c_ptr; }
+        }
+
+        for (word c_ptr = WQ; c_ptr != H_EOL; c_ptr = memory[c_ptr + I_NEXT_POINTER])
+        {
+            if (memory[c_ptr + I_PID] == pid) { return c_ptr; }
+        }
+
+        return H_EOL;
+    }
+
+    // Unlink a PCB that is known to be in the RQ.
+    void RemovePCBfromRQ(word pcb_ptr)
+    {
+        word c_ptr = RQ;
+        word p_ptr = H_EOL;
+
+        while (c_ptr != pcb_ptr)
+        {
+            p_ptr = c_ptr;
+            c_ptr = memory[c_ptr + I_NEXT_POINTER];
+        }
+
+        if (p_ptr == H_EOL) { RQ = memory[pcb_ptr + I_NEXT_POINTER]; } // First PCB in RQ.
+        else { StoreWord(p_ptr + I_NEXT_POINTER, memory[pcb_ptr + I_NEXT_POINTER]); }
+
+        StoreWord(pcb_ptr + I_NEXT_POINTER, H_EOL);
+    }
+
+    // Get a process from the RQ.
+    long SelectProcessFromRQ()
+    {
+        long pcb_ptr = RQ;
+
+        if (RQ != H_EOL)
+        {
+            RQ = memory[RQ + I_NEXT_POINTER];
+            StoreWord(pcb_ptr + I_NEXT_POINTER, H_EOL);
+        }
+
+        return pcb_ptr;
+    }
+
+    // Cache the bounds of a process' stack in the stack registers.
+    void LoadStackBounds(word pcb_ptr)
+    {
+        r_stack_base = memory[pcb_ptr + I_STACK_START];
+        r_stack_limit = r_stack_base + memory[pcb_ptr + I_STACK_SIZE];
+    }
+
+    /*
+    * word: GrowStack
+    *
+    * Move the running process' full stack to a segment twice its size, up to H_MAX_STACK_SIZE.
+    * The words in use are copied, the old segment is freed, and SP, the PCB and the stack
+    * registers follow the stack to its new place. Guests cannot read SP, so the move is invisible.
+    *
+    * @return OK, or E_STACK_OVERFLOW if the stack is at its limit or user memory has no room.
+    *
+    */
+    word GrowStack()
+    {
+        word old_start = r_stack_base;
+        word old_size = r_stack_limit - r_stack_base;
+        word new_size = std::min<word>(old_size * 2, H_MAX_STACK_SIZE);
+
+        if (new_size <= old_size)
+        {
+            Console() << "Stack is full at " << old_size << " words.";
+            return E_STACK_OVERFLOW;
+        }
+
+        word new_start = AllocateUserMemory(new_size);
+
+        if (new_start < 0)
+        {
+            Console() << "\nNo user memory to grow the stack to " << new_size << " words.";
+            return E_STACK_OVERFLOW;
+        }
+
+        for (word addr = old_start; addr <= r_sp; addr++)
+        {
+            StoreWord(new_start + (addr - old_start), memory[addr]);
+        }
+
+        FreeUserMemory(old_start, old_size);
+
+        r_sp = new_start + (r_sp - old_start);
+        StoreWord(mtops_pcb_ptr + I_STACK_START, new_start);
+        StoreWord(mtops_pcb_ptr + I_STACK_SIZE, new_size);
+        LoadStackBounds(mtops_pcb_ptr);
+
+        return OK;
+    }
+
+    // Save the context of the GPRs when control is switched for the CPU.
+    void SaveContext(long pcb_ptr)
+    {
+        StoreWord(pcb_ptr + I_GPR0, r_gpr[0]);
+        StoreWord(pcb_ptr + I_GPR1, r_gpr[1]);
+        StoreWord(pcb_ptr + I_GPR2, r_gpr[2]);
+        StoreWord(pcb_ptr + I_GPR3, r_gpr[3]);
+        StoreWord(pcb_ptr + I_GPR4, r_gpr[4]);
+        StoreWord(pcb_ptr + I_GPR5, r_gpr[5]);
+        StoreWord(pcb_ptr + I_GPR6, r_gpr[6]);
+        StoreWord(pcb_ptr + I_GPR7, r_gpr[7]);
+
+        StoreWord(pcb_ptr + I_R_SP, r_sp);
+        StoreWord(pcb_ptr + I_R_PC, r_pc);
+        StoreWord(pcb_ptr + I_R_PSR, r_psr);
+    }
+
+    // Restore saved GPR values.
+    void Dispatcher(long pcb_ptr)
+    {
+        r_gpr[0] = memory[pcb_ptr + I_GPR0];
+        r_gpr[1] = memory[pcb_ptr + I_GPR1];
+        r_gpr[2] = memory[pcb_ptr + I_GPR2];
+        r_gpr[3] = memory[pcb_ptr + I_GPR3];
+        r_gpr[4] = memory[pcb_ptr + I_GPR4];
+        r_gpr[5] = memory[pcb_ptr + I_GPR5];
+        r_gpr[6] = memory[pcb_ptr + I_GPR6];
+        r_gpr[7] = memory[pcb_ptr + I_GPR7];
+        r_sp = memory[pcb_ptr + I_R_SP];
+        r_pc = memory[pcb_ptr + I_R_PC];
+        r_psr = H_USER_MODE | (memory[pcb_ptr + I_R_PSR] & H_PSR_FLAGS); // The flags of the last COMPARE survive a context switch.
+        LoadStackBounds(pcb_ptr);
+
+        if (mtops_vm != nullptr) { SwitchAddressSpace(memory[pcb_ptr + I_PAGE_TABLE]); }
+        if (mtops_cache != nullptr) { FlushCacheLevel(mtops_cache->tlb); } // The model's TLB has no address space IDs either.
+
+        if (mtops_profile_period > 0) { mtops_shadow = &mtops_shadow_stacks[memory[pcb_ptr + I_PID]]; }
+
+        H_PERF(mtops_perf = &mtops_process_perf[memory[pcb_ptr + I_PID]];
+               mtops_perf->counts[P_CONTEXT_SWITCHES]++;
+               mtops_perf->counts[P_RQ_WAIT] += clock - memory[pcb_ptr + I_QUEUED_CLOCK];
+               RecordLatency(mtops_perf->latency[L_RQ_WAIT], clock - memory[pcb_ptr + I_QUEUED_CLOCK]);
+               mtops_burst_start = clock);
+    }
+
+    // Run the interrupt for loading an EOM program.
+    void ISRrunProgramInterrupt()
+    {
+        std::string programToRun;
+        Console() << "\nEnter filename: ";
+        ReadInput(&programToRun); //Prompt and read filename.
+
+        std::string* fptr = &programToRun;
+        CreateProcess(fptr, H_DEFAULT_PRIORITY); //Call Create Process passing filename and Default Priority as arguments.
+
+    }
+
+    // Run the interrupt for handing input characters.
+    void ISRinputCompletionInterrupt()
+    {
+        word PID;
+        char i_char;
+
+        Console() << "ISR designed for input completion has begun running, please specify the PID of the process that the input is being completed for: ";
+        ReadInput(&PID); //Read the PID of the process we're completing input for.
+
+        PID = (int) PID;
+
+        word pcb_ptr = SearchAndRemovePCBfromWQ(PID); //Search WQ to find the PCB that has the given PID, return value is stored in pcb_ptr.
+        if (pcb_ptr > 0) //Only performs this section with a valid PCB address.
+        {
+            Console() << "Please enter a character to store: ";
+            ReadInput(&i_char); //Read one character from standard input device keyboard.
+            StoreWord(pcb_ptr + I_GPR1, (int) i_char); //Store the character in the GPR in the PCB. Use typecasting from char to word data types.
+            StoreWord(pcb_ptr + I_STATE, H_READY_STATE); //Set process state to Ready in the PCB.
+            Console() << "The character " << i_char << " was successfully INPUTTED.";
+            InsertIntoRQ(pcb_ptr); //Insert PCB into ready queue.
+        }
+    } 
+
+    // Run the interrupt for handling output.
+    void ISRoutputCompletionInterrupt()
+    {
+        word PID;
+        char o_char;
+
+        Console() << "ISR designed for output completion has begun running, please specify the PID of the process that the output is being completed for: ";
+        ReadInput(&PID); //Read the PID of the process we're completing input for.
+
+        PID = (int) PID;
+
+        word pcb_ptr = SearchAndRemovePCBfromWQ(PID); //Search WQ to find the PCB that has the given PID, return value is stored in pcb_ptr.
+        if (pcb_ptr > 0) //Only performs this section with a valid PCB address.
+        {
+            o_char = (char) memory[pcb_ptr + I_GPR1]; //Typecast the ascii code for the output character back into a character value. Store in output character.
+            Console() << "\nOUTPUT COMPLETED, CHARACTER DISPLAYED: " << o_char << std::endl; //Print the character that was in the PCB's GPR1 slot.
+            StoreWord(pcb_ptr + I_STATE, H_READY_STATE); //Set process state to Ready in the PCB.
+            InsertIntoRQ(pcb_ptr); //Insert PCB into ready queue.
+        }
+
+    }
+
+    // Gracefully shutdown the machine.
+    void ISRshutdownSystem()
+    {
+        //Terminate all processes in RQ one by one.
+        word ptr = RQ; //Set ptr to first PCB pointed by RQ.
+
+        while (ptr != H_EOL) //While there are still PCBs in the RQ...
+        {
+            RQ = memory[ptr + I_NEXT_POINTER]; //Set RQ to equal the next PCB in RQ.
+            TerminateProcess(ptr); //Terminate the current process in the list.
+            ptr = RQ; //Set ptr to the next PCB in RQ.
+        }
+
+        //Terminate all processes in WQ one by one.	
+        ptr = WQ; //Set ptr to first PCB pointed by WQ.
+
+        while (ptr != H_EOL) //While there are still PCBs in the WQ...
+        {
+            WQ = memory[ptr + I_NEXT_POINTER]; //Set RQ to equal the next PCB in RQ.
+            TerminateProcess(ptr); //Terminate the current process in the list.
+            ptr = WQ; //Set ptr to the next PCB in WQ.
+        }
+
+        H_PERF(PrintPerfCounters();
+               PrintLatencyReports());
+    }
+
+    // Fixed-size header of a snapshot file. Holds every register and OS list head; memory[] follows it.
+    struct SnapshotHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t kind;
+        uint32_t word_size;
+        uint32_t memory_words;
+        uint64_t chain;
+        uint32_t sequence;
+        uint32_t page_count;
+
+        word clock, r_mar, r_mbr, r_gpr[8], r_ir, r_psr, r_sp, r_pc;
+        word pcb_ptr, rq, wq, pid, null_pid, os_free_list, user_free_list, shm_list;
+        word timer_time, timer_count;
+        word timer_wheel[H_TIMER_LEVELS][H_TIMER_SLOTS];
+        uint64_t timer_bitmap[H_TIMER_LEVELS];
+    };
+
+    // Fill a snapshot header from the running machine.
+    void CaptureSnapshotHeader(SnapshotHeader* header, uint32_t kind)
+    {
+        memset(header, 0, sizeof(*header));
+        memcpy(header->magic, H_SNAPSHOT_MAGIC, sizeof(header->magic));
+        header->version = H_SNAPSHOT_VERSION;
+        header->kind = kind;
+        header->word_size = sizeof(word);
+        header->memory_words = sizeof(memory) / sizeof(memory[0]);
+        header->chain = mtops_checkpoint_chain;
+        header->sequence = mtops_checkpoint_seq;
+
+        header->clock = clock;
+        header->r_mar = r_mar;
+        header->r_mbr = r_mbr;
+        memcpy(header->r_gpr, r_gpr, sizeof(r_gpr));
+        header->r_ir = r_ir;
+        header->r_psr = r_psr;
+        header->r_sp = r_sp;
+        header->r_pc = r_pc;
+
+        header->pcb_ptr = mtops_pcb_ptr;
+        header->rq = RQ;
+        header->wq = WQ;
+        header->pid = mtops_pid;
+        header->null_pid = mtops_null_pid;
+        header->os_free_list = mtops_os_free_list;
+        header->user_free_list = mtops_user_free_list;
+        header->shm_list = mtops_shm_list;
+
+        header->timer_time = mtops_timer_time;
+        header->timer_count = mtops_timer_count;
+        memcpy(header->timer_wheel, mtops_timer_wheel, sizeof(mtops_timer_wheel));
+        memcpy(header->timer_bitmap, mtops_timer_bitmap, sizeof(mtops_timer_bitmap));
+    }
+
+    // Reload registers and OS list heads from a snapshot header.
+    void ApplySnapshotHeader(const SnapshotHeader* header)
+    {
+        ResetPerfCounters(); // Counters are not part of snapshots, the restored machine starts counting afresh.
+        ResetCacheModel(); // So are caches, which start cold.
+
+        clock = header->clock;
+        r_mar = header->r_mar;
+        r_mbr = header->r_mbr;
+        memcpy(r_gpr, header->r_gpr, sizeof(r_gpr));
+        r_ir = header->r_ir;
+        r_psr = header->r_psr;
+        r_sp = header->r_sp;
+        r_pc = header->r_pc;
+
+        mtops_pcb_ptr = header->pcb_ptr;
+        if (mtops_pcb_ptr != H_EOL) { LoadStackBounds(mtops_pcb_ptr); }
+        RQ = header->rq;
+        WQ = header->wq;
+        mtops_pid = header->pid;
+        mtops_null_pid = header->null_pid;
+        mtops_os_free_list = header->os_free_list;
+        mtops_user_free_list = header->user_free_list;
+        mtops_shm_list = header->shm_list;
+
+        mtops_checkpoint_seq = header->sequence;
+
+        mtops_timer_time = header->timer_time;
+        mtops_timer_count = header->timer_count;
+        memcpy(mtops_timer_wheel, header->timer_wheel, sizeof(mtops_timer_wheel));
+        memcpy(mtops_timer_bitmap, header->timer_bitmap, sizeof(mtops_timer_bitmap));
+
+        RebaseProfiler(); // Shadow call stacks belong to the processes that were running.
+        ReverifyProcesses(); // So does the code, and the PIDs are another machine's.
+    }
+
+    // Check that a header was written by this build of the machine.
+    bool SnapshotHeaderValid(const SnapshotHeader* header, uint32_t kind)
+    {
+        return memcmp(header->magic, H_SNAPSHOT_MAGIC, sizeof(header->magic)) == 0
+            && header->version == H_SNAPSHOT_VERSION
+            && header->kind == kind
+            && header->word_size == sizeof(word)
+            && header->memory_words == sizeof(memory) / sizeof(memory[0]);
+    }
+
+    /*
+    * word: SaveSnapshot
+    *
+    * Write the full machine state (registers, clock, queue and free list heads, timers and all of
+    * memory) to a versioned snapshot file. Must be called between CPU bursts.
+    *
+    * @param filename The snapshot file to write.
+    *
+    * @return A status code corresponding to H_ERROR_CODE.
+    *
+    */
+    word SaveSnapshot(std::string filename)
+    {
+        if (mtops_vm != nullptr) // Checkpoints build on a snapshot, so this turns both away.
+        {
+            Console() << "Snapshots do not cover paged program areas.";
+            return E_MTOPS_BAD_SNAPSHOT;
+        }
+
+        std::ofstream o_snap(filename, std::ios::binary | std::ios::trunc);
+
+        if (!o_snap)
+        {
+            std::cerr << "Cannot open file: " << filename;
+            return E_FS_CANT_OPEN;
+        }
+
+        // A full snapshot starts a new checkpoint chain.
+        mtops_checkpoint_chain = (uint64_t) std::chrono::system_clock::now().time_since_epoch().count() ^ ((uint64_t) clock << 32);
+        mtops_checkpoint_seq = 0;
+
+        SnapshotHeader header;
+        CaptureSnapshotHeader(&header, H_SNAPSHOT_FULL);
+        header.page_count = H_PAGE_COUNT;
+
+        o_snap.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        o_snap.write(reinterpret_cast<const char*>(memory), sizeof(memory));
+
+        if (!o_snap)
+        {
+            std::cerr << "Cannot write file: " << filename;
+            return E_FS_CANT_OPEN;
+        }
+
+        ClearDirtyPages(H_DIRTY_CHECKPOINT);
+
+        return OK;
+    }
+
+    /*
+    * word: SaveCheckpoint
+    *
+    * Write an incremental checkpoint holding the registers and only the pages written since the
+    * previous snapshot or checkpoint. Restoring the full snapshot and then each checkpoint of its
+    * chain in order reproduces the machine state.
+    *
+    * @param filename The checkpoint file to write.
+    *
+    * @return A status code corresponding to H_ERROR_CODE.
+    *
+    */
+    word SaveCheckpoint(std::string filename)
+    {
+        if (mtops_checkpoint_chain == 0)
+        {
+            Console() << "No full snapshot to build a checkpoint on, save a snapshot first.";
+            return E_MTOPS_BAD_SNAPSHOT;
+        }
+
+        std::ofstream o_snap(filename, std::ios::binary | std::ios::trunc);
+
+        if (!o_snap)
+        {
+            std::cerr << "Cannot open file: " << filename;
+            return E_FS_CANT_OPEN;
+        }
+
+        std::vector<uint32_t> pages;
+
+        for (int page = 0; page < H_PAGE_COUNT; page++)
+        {
+            if (mtops_dirty_pages[page] & H_DIRTY_CHECKPOINT) { pages.push_back(page); }
+        }
+
+        mtops_checkpoint_seq++;
+
+        SnapshotHeader header;
+        CaptureSnapshotHeader(&header, H_SNAPSHOT_INCREMENTAL);
+        header.page_count = (uint32_t) pages.size();
+
+        o_snap.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        for (uint32_t page : pages)
+        {
+            o_snap.write(reinterpret_cast<const char*>(&page), sizeof(page));
+            o_snap.write(reinterpret_cast<const char*>(&memory[page * H_PAGE_SIZE]), H_PAGE_SIZE * sizeof(word));
+        }
+
+        if (!o_snap)
+        {
+            std::cerr << "Cannot write file: " << filename;
+            return E_FS_CANT_OPEN;
+        }
+
+        ClearDirtyPages(H_DIRTY_CHECKPOINT);
+
+        Console() << "Checkpoint " << header.sequence << " wrote " << pages.size() << " of " << H_PAGE_COUNT << " pages.";
+
+        return OK;
+    }
+
+    // Apply the pages of an incremental checkpoint that is already in host memory.
+    word ApplyCheckpoint(const SnapshotHeader* header, const char* data, size_t length)
+    {
+        const size_t record_size = sizeof(uint32_t) + H_PAGE_SIZE * sizeof(word);
+
+        if (length != sizeof(SnapshotHeader) + header->page_count * record_size)
+        {
+            Console() << "Checkpoint has the wrong size for this machine.";
+            return E_MTOPS_BAD_SNAPSHOT;
+        }
+
+        if (header->chain != mtops_checkpoint_chain || header->sequence != mtops_checkpoint_seq + 1)
+        {
+            Console() << "Checkpoint " << header->sequence << " does not follow the current machine state.";
+            return E_MTOPS_BAD_SNAPSHOT;
+        }
+
+        const char* record = data + sizeof(SnapshotHeader);
+
+        for (uint32_t i = 0; i < header->page_count; i++, record += record_size)
+        {
+            uint32_t page;
+            memcpy(&page, record, sizeof(page));
+
+            if (page >= (uint32_t) H_PAGE_COUNT)
+            {
+                Console() << "Checkpoint page out of range: " << page;
+                return E_MTOPS_BAD_SNAPSHOT;
+            }
+
+            memcpy(&memory[page * H_PAGE_SIZE], record + sizeof(page), H_PAGE_SIZE * sizeof(word));
+            mtops_dirty_pages[page] = H_DIRTY_ALL & ~H_DIRTY_CHECKPOINT; // Already part of this checkpoint chain.
+        }
+
+        ApplySnapshotHeader(header);
+
+        return OK;
+    }
+
+    // Load a full snapshot or incremental checkpoint image that is already in host memory.
+    word ApplySnapshot(const char* data, size_t length)
+    {
+        if (length < sizeof(SnapshotHeader))
+        {
+            Console() << "Snapshot has the wrong size for this machine.";
+            return E_MTOPS_BAD_SNAPSHOT;
+        }
+
+        SnapshotHeader header;
+        memcpy(&header, data, sizeof(header));
+
+        if (SnapshotHeaderValid(&header, H_SNAPSHOT_INCREMENTAL))
+        {
+            return ApplyCheckpoint(&header, data, length);
+        }
+
+        if (!SnapshotHeaderValid(&header, H_SNAPSHOT_FULL))
+        {
+            Console() << "Snapshot was written by an incompatible machine.";
+            return E_MTOPS_BAD_SNAPSHOT;
+        }
+
+        if (length != sizeof(SnapshotHeader) + sizeof(memory))
+        {
+            Console() << "Snapshot has the wrong size for this machine.";
+            return E_MTOPS_BAD_SNAPSHOT;
+        }
+
+        memcpy(memory, data + sizeof(header), sizeof(memory));
+        MarkAllPagesDirty();
+        ClearDirtyPages(H_DIRTY_CHECKPOINT); // Memory now matches the start of the snapshot's chain.
+
+        ApplySnapshotHeader(&header);
+        mtops_checkpoint_chain = header.chain;
+        mtops_checkpoint_seq = header.sequence;
+
+        return OK;
+    }
+
+    /*
+    * word: RestoreSnapshot
+    *
+    * Restore the machine from a snapshot written by SaveSnapshot. The file is mapped rather than
+    * read through a stream, so a warm start costs one copy of memory[] plus a register reload.
+    *
+    * @param filename The snapshot file to restore.
+    *
+    * @return A status code corresponding to H_ERROR_CODE.
+    *
+    */
+    word RestoreSnapshot(std::string filename)
+    {
+        if (mtops_vm != nullptr)
+        {
+            Console() << "Snapshots do not cover paged program areas.";
+            return E_MTOPS_BAD_SNAPSHOT;
+        }
+
+#ifndef _WIN32
+        int fd = open(filename.c_str(), O_RDONLY);
+
+        if (fd < 0)
+        {
+            std::cerr << "Cannot open file: " << filename;
+            return E_FS_CANT_OPEN;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            close(fd);
+            Console() << "Snapshot has the wrong size for this machine.";
+            return E_MTOPS_BAD_SNAPSHOT;
+        }
+
+        void* map = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+
+        if (map == MAP_FAILED)
+        {
+            std::cerr << "Cannot map file: " << filename;
+            return E_FS_CANT_OPEN;
+        }
+
+        word status = ApplySnapshot(static_cast<const char*>(map), (size_t) st.st_size);
+        munmap(map, (size_t) st.st_size);
+
+        return status;
+#else
+        std::ifstream i_snap(filename, std::ios::binary);
+
+        if (!i_snap)
+        {
+            std::cerr << "Cannot open file: " << filename;
+            return E_FS_CANT_OPEN;
+        }
+
+        std::vector<char> data((std::istreambuf_iterator<char>(i_snap)), std::istreambuf_iterator<char>());
+
+        return ApplySnapshot(data.data(), data.size());
+#endif
+    }
+
+    // Run the interrupt for saving a machine snapshot.
+    void ISRsaveSnapshotInterrupt()
+    {
+        std::string filename;
+        Console() << "\nEnter snapshot filename: ";
+        ReadInput(&filename);
+
+        if (SaveSnapshot(filename) == OK)
+        {
+            Console() << "Snapshot [" + filename + "] saved.";
+        }
+    }
+
+    // Run the interrupt for saving an incremental checkpoint.
+    void ISRsaveCheckpointInterrupt()
+    {
+        std::string filename;
+        Console() << "\nEnter checkpoint filename: ";
+        ReadInput(&filename);
+
+        if (SaveCheckpoint(filename) == OK)
+        {
+            Console() << "\nCheckpoint [" + filename + "] saved.";
+        }
+    }
+
+    // Run the interrupt for restoring a machine snapshot or checkpoint.
+    void ISRrestoreSnapshotInterrupt()
+    {
+        std::string filename;
+        Console() << "\nEnter snapshot filename: ";
+        ReadInput(&filename);
+
+        if (RestoreSnapshot(filename) == OK)
+        {
+            Console() << "Snapshot [" + filename + "] restored.";
+        }
+    }
+
+    // Run the interrupt for starting or stopping the execution trace.
+    void ISRtraceInterrupt()
+    {
+        if (mtops_trace != nullptr)
+        {
+            StopTrace();
+            Console() << "\nTrace stopped.";
+            return;
+        }
+
+        std::string filename;
+        Console() << "\nEnter trace filename: ";
+        ReadInput(&filename);
+
+        if (StartTrace(filename) == OK)
+        {
+            Console() << "\nTracing into [" + filename + "].";
+        }
+    }
+
+    // Run the interrupt for printing the latency histograms of the machine and its live processes.
+    void ISRlatencyReportInterrupt()
+    {
+#ifdef HYPO_PERF_COUNTERS
+        PrintLatencyReports();
+#else
+        Console() << "\nPerformance counters are not compiled in.";
+#endif
+    }
+
+    // Handle an interrupt and process the input.
+    word CheckAndProcessInterrupt()
+    {
+        word i_id;
+
+        Console() << "\n Interrupts: \n 0: No interrupt. \n 1: Run program. \n 2: Shutdown system. \n 3: io_getc \n 4: io_putc \n 5: Save snapshot. \n 6: Restore snapshot or checkpoint. \n 7: Save checkpoint. \n 8: Start or stop trace. \n 9: Print latency report. \n Interrupt ID:";
+
+        mtops_sched_point++;
+
+        if (mtops_metrics != nullptr) { PublishMetrics(true); } // The machine is idle until the operator answers.
+
+        if (!ReadInput(&i_id)) // Blocks until the operator enters an interrupt.
+        {
+            Console() << "Interrupt source closed, shutting down.";
+            i_id = INT_SHUTDOWN; // Nothing can ever arrive again, so don't spin on a closed stream.
+        }
+
+        switch (i_id)
+        {
+        case INT_NO_OP: // Interrupt 0 is a no-op.
+            break;
+        case INT_RUN_PROG: // Interrupt 1 is to load and run a program.
+            ISRrunProgramInterrupt();
+            break;
+        case INT_SHUTDOWN: // Interrupt 2 is to shut down the system.
+            ISRshutdownSystem();
+            shutdown_status = true;
+            break;
+        case INT_IO_GETC: // Interrupt 3 is to get input.
+            ISRinputCompletionInterrupt();
+            break;
+        case INT_IO_PUTC: // Interrupt 4 is to get output.
+            ISRoutputCompletionInterrupt();
+            break;
+        case INT_SNAPSHOT_SAVE: // Interrupt 5 is to save a machine snapshot.
+            ISRsaveSnapshotInterrupt();
+            break;
+        case INT_SNAPSHOT_RESTORE: // Interrupt 6 is to restore a machine snapshot or checkpoint.
+            ISRrestoreSnapshotInterrupt();
+            break;
+        case INT_CHECKPOINT_SAVE: // Interrupt 7 is to save an incremental checkpoint.
+            ISRsaveCheckpointInterrupt();
+            break;
+        case INT_TRACE_TOGGLE: // Interrupt 8 is to start or stop the execution trace.
+            ISRtraceInterrupt();
+            break;
+        case INT_LATENCY_REPORT: // Interrupt 9 is to print the latency histograms.
+            ISRlatencyReportInterrupt();
+            break;
+        default: // All other interrupts are invalid, so no-op.
+            Console() << "Invalid interrupt signal. This is a no-op...";
+            return INT_NO_OP;
+        }
+
+        return i_id;
+    }
+
+    /*
+    * word: ProcessCreateSystemCall
+    *
+    * Create a child of the running process. The child shares the program image the parent already
+    * has loaded, so no file is read; it only gets a fresh PCB and a stack the size the parent's has
+    * grown to.
+    *
+    * GPR1 = start address in the program area, or H_EOL to continue from the parent's next instruction
+    * (the parent's stack is copied in that case). GPR2 = priority, or <= 0 to inherit the parent's.
+    *
+    * @return 0 in GPR0 and the child PID in GPR1 for the parent. The child starts with the parent's
+    * GPRs and 0 in GPR0 and GPR1.
+    *
+    */
+    word ProcessCreateSystemCall()
+    {
+        word start_pc = r_gpr[1];
+        word priority = r_gpr[2] > 0 ? r_gpr[2] : memory[mtops_pcb_ptr + I_PRIORITY];
+
+        if (start_pc == H_EOL)
+        {
+            start_pc = r_pc; // Fork, the child resumes after this syscall.
+        }
+
+        if (!ProgramAddressInRange(start_pc))
+        {
+            Console() << "Invalid address for program counter: " << start_pc;
+            r_gpr[0] = E_INVALID_PC;
+            return r_gpr[0];
+        }
+
+        word pcb_ptr = AllocateOSMemory(H_PCBSIZE);
+        if (pcb_ptr < 0) { r_gpr[0] = pcb_ptr; return r_gpr[0]; } // Error code.
+
+        InitializePCB(pcb_ptr);
+
+        word stack_words = memory[mtops_pcb_ptr + I_STACK_SIZE]; // As deep as the parent's, so a fork's copy fits.
+        word u_ptr = AllocateUserMemory(stack_words);
+        if (u_ptr < 0) { FreeOSMemory(pcb_ptr, H_PCBSIZE); r_gpr[0] = u_ptr; return r_gpr[0]; } // Error code.
+
+        StoreWord(pcb_ptr + I_STACK_START, u_ptr);
+        StoreWord(pcb_ptr + I_STACK_SIZE, stack_words);
+        StoreWord(pcb_ptr + I_R_SP, u_ptr - 1); // Empty stack.
+        StoreWord(pcb_ptr + I_PRIORITY, priority);
+        StoreWord(pcb_ptr + I_PARENT_PID, memory[mtops_pcb_ptr + I_PID]);
+        StoreWord(pcb_ptr + I_QUOTA, memory[mtops_pcb_ptr + I_QUOTA]); // A child cannot escape its parent's quota.
+
+        if (mtops_vm != nullptr) // The child runs from the parent's program area.
+        {
+            word page_table = memory[mtops_pcb_ptr + I_PAGE_TABLE];
+            StoreWord(page_table + I_PT_REFS, memory[page_table + I_PT_REFS] + 1);
+            StoreWord(pcb_ptr + I_PAGE_TABLE, page_table);
+        }
+
+        if (start_pc == r_pc)
+        {
+            // A forked child continues with the parent's stack contents at the same depth.
+            word p_stack = memory[mtops_pcb_ptr + I_STACK_START];
+
+            for (word addr = p_stack; addr <= r_sp; addr++)
+            {
+                StoreWord(u_ptr + (addr - p_stack), memory[addr]);
+            }
+
+            StoreWord(pcb_ptr + I_R_SP, u_ptr + (r_sp - p_stack));
+            StoreWord(pcb_ptr + I_R_PSR, r_psr & H_PSR_FLAGS);
+        }
+
+        for (int gpr = 0; gpr < 8; gpr++)
+        {
+            StoreWord(pcb_ptr + I_GPR0 + gpr, r_gpr[gpr]);
+        }
+
+        StoreWord(pcb_ptr + I_GPR0, 0);
+        StoreWord(pcb_ptr + I_GPR1, 0);
+        StoreWord(pcb_ptr + I_R_PC, start_pc);
+        VerifyProcess(pcb_ptr, false);
+
+        InsertIntoRQ(pcb_ptr);
+
+        r_gpr[0] = 0; // BranchOnZero = OK
+        r_gpr[1] = memory[pcb_ptr + I_PID];
+
+        Console() << "ProcessCreateSystemCall => GPR0: " << r_gpr[0] << " GPR1: " << r_gpr[1] << " GPR2: " << r_gpr[2] << std::endl;
+
+        return r_gpr[0];
+    }
+
+    // Delete the process with the PID in GPR1. Deleting the caller ends it like HALT.
+    word ProcessDeleteSystemCall()
+    {
+        word pid = r_gpr[1];
+
+        if (pid == memory[mtops_pcb_ptr + I_PID])
+        {
+            r_gpr[0] = 0; // BranchOnZero = OK
+            return H_EXIT;
+        }
+
+        word pcb_ptr = FindPCB(pid);
+
+        if (pcb_ptr == H_EOL || pid == mtops_null_pid) // The null process must stay runnable.
+        {
+            Console() << "No process with ID " << pid << " can be deleted.";
+            r_gpr[0] = E_MTOPS_INVALID_PID;
+            return r_gpr[0];
+        }
+
+        if (memory[pcb_ptr + I_STATE] == H_WAITING_STATE)
+        {
+            RemovePCBfromWQ(pcb_ptr);
+        }
+        else
+        {
+            RemovePCBfromRQ(pcb_ptr);
+        }
+
+        TerminateProcess(pcb_ptr); // Also disarms its sleep timer and detaches shared segments.
+
+        r_gpr[0] = 0; // BranchOnZero = OK
+
+        Console() << "ProcessDeleteSystemCall => GPR0: " << r_gpr[0] << " GPR1: " << r_gpr[1] << std::endl;
+
+        return r_gpr[0];
+    }
+
+    // Inquire about the process with the PID in GPR1 (0 for the caller). Returns state in GPR1, priority in GPR2 and parent PID in GPR3.
+    word ProcessInquirySystemCall()
+    {
+        word pid = r_gpr[1];
+        word pcb_ptr;
+        word state;
+
+        if (pid == 0 || pid == memory[mtops_pcb_ptr + I_PID])
+        {
+            pcb_ptr = mtops_pcb_ptr;
+            state = H_RUNNING_STATE;
+        }
+        else
+        {
+            pcb_ptr = FindPCB(pid);
+
+            if (pcb_ptr == H_EOL)
+            {
+                Console() << "No process with ID " << pid << " could be found.";
+                r_gpr[0] = E_MTOPS_INVALID_PID;
+                return r_gpr[0];
+            }
+
+            state = memory[pcb_ptr + I_STATE];
+        }
+
+        r_gpr[0] = 0; // BranchOnZero = OK
+        r_gpr[1] = state;
+        r_gpr[2] = memory[pcb_ptr + I_PRIORITY];
+        r_gpr[3] = memory[pcb_ptr + I_PARENT_PID];
+
+        Console() << "ProcessInquirySystemCall => GPR0: " << r_gpr[0] << " GPR1: " << r_gpr[1] << " GPR2: " << r_gpr[2] << " GPR3: " << r_gpr[3] << std::endl;
+
+        return r_gpr[0];
+    }
+
+    /*
+    * word: PerfReadSystemCall
+    *
+    * Read a performance counter. GPR1 = counter index (H_PERF_IDX), GPR2 = PID, 0 for the caller or
+    * H_EOL for the whole machine.
+    *
+    * @return The counter in GPR1. E_MTOPS_INVALID_SYSCALL in GPR0 if counters are compiled out.
+    *
+    */
+    word PerfReadSystemCall()
+    {
+#ifdef HYPO_PERF_COUNTERS
+        word counter = r_gpr[1];
+        word pid = r_gpr[2];
+
+        if (counter < 0 || counter >= P_COUNT)
+        {
+            Console() << "Invalid performance counter: " << counter;
+            r_gpr[0] = E_MTOPS_INVALID_COUNTER;
+            return r_gpr[0];
+        }
+
+        if (pid == H_EOL)
+        {
+            r_gpr[1] = (word) MachinePerfCounter(counter);
+        }
+        else
+        {
+            if (pid == 0) { pid = memory[mtops_pcb_ptr + I_PID]; }
+
+            if (pid != memory[mtops_pcb_ptr + I_PID] && FindPCB(pid) == H_EOL)
+            {
+                Console() << "No process with ID " << pid << " could be found.";
+                r_gpr[0] = E_MTOPS_INVALID_PID;
+                return r_gpr[0];
+            }
+
+            r_gpr[1] = (word) PerfCounterValue(mtops_process_perf[pid], counter);
+        }
+
+        r_gpr[0] = 0; // BranchOnZero = OK
+
+        Console() << "PerfReadSystemCall => GPR0: " << r_gpr[0] << " GPR1: " << r_gpr[1] << std::endl;
+#else
+        Console() << "Performance counters are not compiled in.";
+        r_gpr[0] = E_MTOPS_INVALID_SYSCALL;
+#endif
+
+        return r_gpr[0];
+    }
+
+    // Run the memory allocation syscall. May return errors based on invalid size.
+    word MemAllocSystemCall()
+    {
+        long size = r_gpr[2];
+
+        if (size < 2 || size > H_START_SIZE_USER_FREE) // Size must be 2 at minimum.
+        {
+            Console() << "The size of memory requested was out of range.";
+            return E_MTOPS_INVALID_SIZE;
+        }
+
+        r_gpr[1] = AllocateUserMemory(size); // Allocate user memory and put starting pointer addr in GPR1.
+
+        if (r_gpr[1] < 0) // GPR1 reached an error status.
+        {
+            r_gpr[0] = r_gpr[1];
+        }
+        else
+        {
+            r_gpr[0] = 0; // BranchOnZero = OK
+        }
+
+        Console() << "MemAllocSystemCall => GPR0: " << r_gpr[0] << " GPR1: " << r_gpr[1] << " GPR2: " << r_gpr[2] << std::endl;
+
+        return r_gpr[0];
+    }
+
+    // Run the free memory system call. May return erorrs if memory requested was out of range.
+    word MemFreeSystemCall()
+    {
+        long size = r_gpr[2];
+
+        if (size < 2 || size > H_START_SIZE_USER_FREE) // Minimum size is two, maximum size is the user free area.
+        {
+            Console() << "The size of memory requested was out of range.";
+            return E_MTOPS_INVALID_SIZE;
+        }
+
+        r_gpr[0] = FreeUserMemory(r_gpr[1], size); // Free user memory and place pointer addr into GPR0.
+
+        Console() << "MemFreeSystemCall => GPR0: " << r_gpr[0] << " GPR1: " << r_gpr[1] << " GPR2: " << r_gpr[2] << std::endl;
+    
+        return r_gpr[0];
+    }
+
+    word io_getcSystemCall()
+    {
+        return INT_IO_GETC;
+    }
+
+    word io_putcSystemCall()
+    {
+        return INT_IO_PUTC;
+    }
+
+    // Find a named shared memory segment by key. Returns H_EOL if no live segment has the key.
+    word FindSharedSegment(word key)
+    {
+        word c_ptr = mtops_shm_list;
+
+        while (c_ptr != H_EOL)
+        {
+            if (memory[c_ptr + I_SHM_KEY] == key)
+            {
+                return c_ptr;
+            }
+
+            c_ptr = memory[c_ptr + I_SHM_NEXT];
+        }
+
+        return H_EOL;
+    }
+
+    // Find the segment attached to a process that contains the given address. Returns H_EOL if none does.
+    word FindAttachedSegmentByAddress(word pcb_ptr, word addr)
+    {
+        word a_ptr = memory[pcb_ptr + I_SHM_LIST];
+
+        while (a_ptr != H_EOL)
+        {
+            word shm_ptr = memory[a_ptr + I_ATTACH_SHM];
+
+            if (addr >= memory[shm_ptr + I_SHM_START] && addr < memory[shm_ptr + I_SHM_START] + memory[shm_ptr + I_SHM_SIZE])
+            {
+                return shm_ptr;
+            }
+
+            a_ptr = memory[a_ptr + I_NEXT_POINTER];
+        }
+
+        return H_EOL;
+    }
+
+    // Return a segment's user memory and descriptor once it has been destroyed and no process is attached.
+    void ReleaseSharedSegment(word shm_ptr)
+    {
+        if (memory[shm_ptr + I_SHM_REFS] > 0 || memory[shm_ptr + I_SHM_DESTROYED] == 0)
+        {
+            return; // Still in use or still named, keep it.
+        }
+
+        FreeUserMemory(memory[shm_ptr + I_SHM_START], memory[shm_ptr + I_SHM_SIZE]);
+        FreeOSMemory(shm_ptr, H_SHMSIZE);
+    }
+
+    // Attach a segment to a process and take a reference on it. Attaching twice is a no-op.
+    word AttachSharedSegment(word pcb_ptr, word shm_ptr)
+    {
+        word a_ptr = memory[pcb_ptr + I_SHM_LIST];
+
+        while (a_ptr != H_EOL)
+        {
+            if (memory[a_ptr + I_ATTACH_SHM] == shm_ptr) { return OK; } // Already attached.
+            a_ptr = memory[a_ptr + I_NEXT_POINTER];
+        }
+
+        a_ptr = AllocateOSMemory(H_SHM_ATTACH_SIZE); // Attachment records live in OS memory like PCBs.
+        if (a_ptr < 0) { return a_ptr; } // Error code.
+
+        StoreWord(a_ptr + I_NEXT_POINTER, memory[pcb_ptr + I_SHM_LIST]); // Push the record onto the process' attachment list.
+        StoreWord(a_ptr + I_ATTACH_SHM, shm_ptr);
+        StoreWord(pcb_ptr + I_SHM_LIST, a_ptr);
+
+        StoreWord(shm_ptr + I_SHM_REFS, memory[shm_ptr + I_SHM_REFS] + 1);
+
+        return OK;
+    }
+
+    // Detach a process from the segment with the given key, dropping its reference.
+    word DetachSharedSegment(word pcb_ptr, word key)
+    {
+        word c_ptr = memory[pcb_ptr + I_SHM_LIST];
+        word p_ptr = H_EOL;
+
+        while (c_ptr != H_EOL)
+        {
+            word shm_ptr = memory[c_ptr + I_ATTACH_SHM];
+
+            if (memory[shm_ptr + I_SHM_KEY] == key)
+            {
+                if (p_ptr == H_EOL) { StoreWord(pcb_ptr + I_SHM_LIST, memory[c_ptr + I_NEXT_POINTER]); } // First record matched.
+                else { StoreWord(p_ptr + I_NEXT_POINTER, memory[c_ptr + I_NEXT_POINTER]); } // Record in the middle of the list.
+
+                FreeOSMemory(c_ptr, H_SHM_ATTACH_SIZE);
+
+                StoreWord(shm_ptr + I_SHM_REFS, memory[shm_ptr + I_SHM_REFS] - 1);
+                ReleaseSharedSegment(shm_ptr);
+
+                return OK;
+            }
+
+            p_ptr = c_ptr;
+            c_ptr = memory[c_ptr + I_NEXT_POINTER];
+        }
+
+        Console() << "Process is not attached to shared segment " << key << ".";
+        return E_MTOPS_SHM_NOT_FOUND;
+    }
+
+    // Drop every shared segment reference held by a process. Called from TerminateProcess.
+    void DetachAllSharedSegments(word pcb_ptr)
+    {
+        word a_ptr = memory[pcb_ptr + I_SHM_LIST];
+
+        while (a_ptr != H_EOL)
+        {
+            word shm_ptr = memory[a_ptr + I_ATTACH_SHM];
+            word next_ptr = memory[a_ptr + I_NEXT_POINTER];
+
+            FreeOSMemory(a_ptr, H_SHM_ATTACH_SIZE);
+
+            StoreWord(shm_ptr + I_SHM_REFS, memory[shm_ptr + I_SHM_REFS] - 1);
+            ReleaseSharedSegment(shm_ptr);
+
+            a_ptr = next_ptr;
+        }
+
+        StoreWord(pcb_ptr + I_SHM_LIST, H_EOL);
+    }
+
+    // Create a named shared segment. GPR1 = key, GPR2 = size. Returns segment address in GPR1; the creator is attached.
+    word SharedMemCreateSystemCall()
+    {
+        word key = r_gpr[1];
+        word size = r_gpr[2];
+
+        if (size < 2 || size > H_START_SIZE_USER_FREE) // Same limits as MEM_ALLOC.
+        {
+            Console() << "The size of memory requested was out of range.";
+            r_gpr[0] = E_MTOPS_INVALID_SIZE;
+            return r_gpr[0];
+        }
+
+        if (FindSharedSegment(key) != H_EOL)
+        {
+            Console() << "Shared segment " << key << " already exists.";
+            r_gpr[0] = E_MTOPS_SHM_EXISTS;
+            return r_gpr[0];
+        }
+
+        word shm_ptr = AllocateOSMemory(H_SHMSIZE); // Descriptor.
+        if (shm_ptr < 0) { r_gpr[0] = shm_ptr; return r_gpr[0]; } // Error code.
+
+        word u_ptr = AllocateUserMemory(size); // Segment body, carved from the user free list.
+        if (u_ptr < 0) { FreeOSMemory(shm_ptr, H_SHMSIZE); r_gpr[0] = u_ptr; return r_gpr[0]; } // Error code.
+
+        for (word addr = u_ptr; addr < u_ptr + size; addr++)
+        {
+            StoreWord(addr, 0); // Segments start zeroed so both sides agree on the initial contents.
+        }
+
+        StoreWord(shm_ptr + I_SHM_KEY, key);
+        StoreWord(shm_ptr + I_SHM_START, u_ptr);
+        StoreWord(shm_ptr + I_SHM_SIZE, size);
+        StoreWord(shm_ptr + I_SHM_REFS, 0);
+        StoreWord(shm_ptr + I_SHM_DESTROYED, 0);
+        StoreWord(shm_ptr + I_SHM_NEXT, mtops_shm_list);
+        mtops_shm_list = shm_ptr;
+
+        r_gpr[0] = AttachSharedSegment(mtops_pcb_ptr, shm_ptr);
+
+        if (r_gpr[0] < 0) // Could not record the attachment, so undo the segment.
+        {
+            StoreWord(shm_ptr + I_SHM_DESTROYED, 1);
+            mtops_shm_list = memory[shm_ptr + I_SHM_NEXT];
+            ReleaseSharedSegment(shm_ptr);
+        }
+        else
+        {
+            r_gpr[0] = 0; // BranchOnZero = OK
+            r_gpr[1] = u_ptr;
+        }
+
+        Console() << "SharedMemCreateSystemCall => GPR0: " << r_gpr[0] << " GPR1: " << r_gpr[1] << " GPR2: " << r_gpr[2] << std::endl;
+
+        return r_gpr[0];
+    }
+
+    // Attach to a named shared segment. GPR1 = key. Returns segment address in GPR1 and size in GPR2.
+    word SharedMemAttachSystemCall()
+    {
+        word shm_ptr = FindSharedSegment(r_gpr[1]);
+
+        if (shm_ptr == H_EOL)
+        {
+            Console() << "No shared segment with key " << r_gpr[1] << ".";
+            r_gpr[0] = E_MTOPS_SHM_NOT_FOUND;
+            return r_gpr[0];
+        }
+
+        r_gpr[0] = AttachSharedSegment(mtops_pcb_ptr, shm_ptr);
+
+        if (r_gpr[0] >= 0)
+        {
+            r_gpr[0] = 0; // BranchOnZero = OK
+            r_gpr[1] = memory[shm_ptr + I_SHM_START];
+            r_gpr[2] = memory[shm_ptr + I_SHM_SIZE];
+        }
+
+        Console() << "SharedMemAttachSystemCall => GPR0: " << r_gpr[0] << " GPR1: " << r_gpr[1] << " GPR2: " << r_gpr[2] << std::endl;
+
+        return r_gpr[0];
+    }
+
+    // Detach from a named shared segment. GPR1 = key.
+    word SharedMemDetachSystemCall()
+    {
+        r_gpr[0] = DetachSharedSegment(mtops_pcb_ptr, r_gpr[1]);
+        if (r_gpr[0] >= 0) { r_gpr[0] = 0; } // BranchOnZero = OK
+
+        Console() << "SharedMemDetachSystemCall => GPR0: " << r_gpr[0] << " GPR1: " << r_gpr[1] << std::endl;
+
+        return r_gpr[0];
+    }
+
+    // Destroy a named shared segment. GPR1 = key. The name is removed at once; the memory is freed when the last process detaches.
+    word SharedMemDestroySystemCall()
+    {
+        word shm_ptr = FindSharedSegment(r_gpr[1]);
+
+        if (shm_ptr == H_EOL)
+        {
+            Console() << "No shared segment with key " << r_gpr[1] << ".";
+            r_gpr[0] = E_MTOPS_SHM_NOT_FOUND;
+            return r_gpr[0];
+        }
+
+        // Unlink the descriptor so the key can no longer be attached.
+        if (mtops_shm_list == shm_ptr)
+        {
+            mtops_shm_list = memory[shm_ptr + I_SHM_NEXT];
+        }
+        else
+        {
+            word p_ptr = mtops_shm_list;
+            while (memory[p_ptr + I_SHM_NEXT] != shm_ptr) { p_ptr = memory[p_ptr + I_SHM_NEXT]; }
+            StoreWord(p_ptr + I_SHM_NEXT, memory[shm_ptr + I_SHM_NEXT]);
+        }
+
+        StoreWord(shm_ptr + I_SHM_NEXT, H_EOL);
+        StoreWord(shm_ptr + I_SHM_DESTROYED, 1);
+        ReleaseSharedSegment(shm_ptr);
+
+        r_gpr[0] = 0; // BranchOnZero = OK
+
+        Console() << "SharedMemDestroySystemCall => GPR0: " << r_gpr[0] << " GPR1: " << r_gpr[1] << std::endl;
+
+        return r_gpr[0];
+    }
+
+    // Block until woken if the word at GPR1 still holds the value in GPR2. The word must be inside an attached segment.
+    word FutexWaitSystemCall()
+    {
+        word addr = r_gpr[1];
+
+        if (FindAttachedSegmentByAddress(mtops_pcb_ptr, addr) == H_EOL)
+        {
+            Console() << "Futex address " << addr << " is not in an attached shared segment.";
+            r_gpr[0] = E_MTOPS_INVALID_MEM_ADDR;
+            return r_gpr[0];
+        }
+
+        r_gpr[0] = 0; // BranchOnZero = OK, both when the value already changed and after being woken.
+
+        if (memory[addr] != r_gpr[2])
+        {
+            return r_gpr[0]; // Value changed before we could sleep, return straight away.
+        }
+
+        StoreWord(mtops_pcb_ptr + I_WAIT_ADDR, addr);
+
+        return H_FUTEX_WAIT;
+    }
+
+    // Wake up to GPR2 processes blocked on the word at GPR1. Returns the number woken in GPR1.
+    word FutexWakeSystemCall()
+    {
+        word addr = r_gpr[1];
+        word max_count = r_gpr[2];
+        word woken = 0;
+
+        word c_ptr = WQ;
+
+        while (c_ptr != H_EOL && woken < max_count)
+        {
+            word next_ptr = memory[c_ptr + I_NEXT_POINTER];
+
+            if (memory[c_ptr + I_WAIT_REASON] == H_FUTEX_WAIT && memory[c_ptr + I_WAIT_ADDR] == addr)
+            {
+                RemovePCBfromWQ(c_ptr);
+                InsertIntoRQ(c_ptr);
+                woken++;
+            }
+
+            c_ptr = next_ptr;
+        }
+
+        r_gpr[0] = 0; // BranchOnZero = OK
+        r_gpr[1] = woken;
+
+        Console() << "FutexWakeSystemCall => GPR0: " << r_gpr[0] << " GPR1: " << r_gpr[1] << std::endl;
+
+        return r_gpr[0];
+    }
+
+    // Read the clock into GPR1.
+    word TimeGetSystemCall()
+    {
+        r_gpr[0] = 0; // BranchOnZero = OK
+        r_gpr[1] = clock;
+
+        Console() << "TimeGetSystemCall => GPR0: " << r_gpr[0] << " GPR1: " << r_gpr[1] << std::endl;
+
+        return r_gpr[0];
+    }
+
+    // Set the clock from GPR1. Sleep timers are absolute, so they fire once the new clock reaches them.
+    word TimeSetSystemCall()
+    {
+        if (r_gpr[1] < 0)
+        {
+            Console() << "Clock time cannot be negative.";
+            r_gpr[0] = E_MTOPS_INVALID_TIME;
+            return r_gpr[0];
+        }
+
+        word previous = clock;
+        clock = r_gpr[1];
+
+        if (mtops_profile_period > 0) { mtops_profile_next += clock - previous; } // Profiler samples CPU time, not the clock setting.
+
+        if (clock < previous)
+        {
+            RebaseTimers(); // Wheel slots are relative to the wheel time, which is now in the future.
+        }
+
+        r_gpr[0] = 0; // BranchOnZero = OK
+
+        Console() << "TimeSetSystemCall => GPR0: " << r_gpr[0] << " GPR1: " << r_gpr[1] << std::endl;
+
+        return r_gpr[0];
+    }
+
+    // Sleep until the clock reaches the time in GPR1. Returns at once if that time has already passed.
+    word TimeSleepSystemCall()
+    {
+        r_gpr[0] = 0; // BranchOnZero = OK
+
+        if (r_gpr[1] <= clock)
+        {
+            return r_gpr[0];
+        }
+
+        StoreWord(mtops_pcb_ptr + I_WAKE_TIME, r_gpr[1]);
+
+        return H_SLEEP;
+    }
+
+    /*
+    * word: SystemCall
+    *
+    * Performs a system call (unimplemented).
+    *
+    * @param id The syscall ID to execute.
+    *
+    * @return OK
+    * 
+    */
+    word SystemCall(word id)
+    {
+        r_psr = (r_psr & H_PSR_FLAGS) | H_OS_MODE;
+
+        word status = OK;
+
+        H_PERF(if ((unsigned long) id < P_CONTEXT_SWITCHES - P_SYSCALL) { mtops_perf->counts[P_SYSCALL + id]++; });
+
+        switch (id)
+        {
+        case PROCESS_CREATE:
+        {
+            status = ProcessCreateSystemCall();
+            break;
+        }
+        case PROCESS_DELETE:
+        {
+            status = ProcessDeleteSystemCall();
+            break;
+        }
+        case PROCESS_INQ:
+        {
+            status = ProcessInquirySystemCall();
+            break;
+        }
+        case MEM_ALLOC:
+        {
+            status = MemAllocSystemCall();
+            break;
+        }
+        case MEM_FREE:
+        {
+            status = MemFreeSystemCall();
+            break;
+        }
+        case MSG_SEND:
+        {
+            Console() << "MSG_SEND not implemented.";
+            break;
+        }
+        case MSG_RECV:
+        {
+            Console() << "MSG_RECV not implemented.";
+            break;
+        }
+        case IO_GETC:
+        {
+            status = io_getcSystemCall();
+            break;
+        }
+        case IO_PUTC:
+        {
+            status = io_putcSystemCall();
+            break;
+        }
+        case TIME_GET:
+        {
+            status = TimeGetSystemCall();
+            break;
+        }
+        case TIME_SET:
+        {
+            status = TimeSetSystemCall();
+            break;
+        }
+        case TIME_SLEEP:
+        {
+            status = TimeSleepSystemCall();
+            break;
+        }
+        case PERF_READ:
+        {
+            status = PerfReadSystemCall();
+            break;
+        }
+        case SHM_CREATE:
+        {
+            status = SharedMemCreateSystemCall();
+            break;
+        }
+        case SHM_ATTACH:
+        {
+            status = SharedMemAttachSystemCall();
+            break;
+        }
+        case SHM_DETACH:
+        {
+            status = SharedMemDetachSystemCall();
+            break;
+        }
+        case SHM_DESTROY:
+        {
+            status = SharedMemDestroySystemCall();
+            break;
+        }
+        case FUTEX_WAIT:
+        {
+            status = FutexWaitSystemCall();
+            break;
+        }
+        case FUTEX_WAKE:
+        {
+            status = FutexWakeSystemCall();
+            break;
+        }
+        default:
+        {
+            Console() << "Invalid syscall ID.";
+            CountError(E_MTOPS_INVALID_SYSCALL);
+            return E_MTOPS_INVALID_SYSCALL;
+        }
+        }
+
+        CountError(status);
+        r_psr = (r_psr & H_PSR_FLAGS) | H_USER_MODE; // Set PSR to user mode.
+
+        return status;
+    }
+
+    /*
+    * bool: IdleSpinning
+    *
+    * Check whether the dispatched process is the null process with nothing else runnable, parked on
+    * a branch to itself. A burst of that loop changes nothing but the clock.
+    *
+    * @param pcb_ptr The dispatched PCB, with its context already restored.
+    *
+    * @return true if the burst can be accounted for with IdleBurst instead of CPU.
+    *
+    */
+    bool IdleSpinning(word pcb_ptr)
+    {
+        if (memory[pcb_ptr + I_PID] != mtops_null_pid || RQ != H_EOL || mtops_cache != nullptr) // The shortcut cannot price the spin's cache accesses.
+        {
+            return false;
+        }
+
+        if (!ProgramAddressInRange(r_pc) || !ProgramAddressInRange(r_pc + 1))
+        {
+            return false;
+        }
+
+        if (mtops_vm != nullptr && !VMResident(r_pc))
+        {
+            return false;
+        }
+
+        return ReadCode(r_pc) == H_OPCODE::BRANCH * 10000 && ReadCode(r_pc + 1) == r_pc;
+    }
+
+    /*
+    * word: IdleBurst
+    *
+    * Account for one TTL of the null process spinning without interpreting it. The clock advances by
+    * exactly what CPU would have charged, so timers and interrupts are seen at the same clock values,
+    * and the host thread goes straight back to blocking on the interrupt source.
+    *
+    * @return H_TTL_EXP, as CPU would.
+    *
+    */
+    word IdleBurst()
+    {
+        word cost = h_cycle_costs[H_OPCODE::BRANCH];
+        word branches = (h_ttl + cost - 1) / cost; // CPU runs branches until time_left is used up.
+
+        r_mar = r_pc;
+        r_mbr = ReadCode(r_mar);
+        r_ir = r_mbr;
+
+        clock += branches * cost;
+        mtops_instructions += branches;
+
+        H_PERF(mtops_perf->decoded[H_OPCODE::BRANCH][H_OPMODE::NO_OP][H_OPMODE::NO_OP] += branches);
+
+        if (clock >= mtops_profile_next) { ProfileSample(); } // All of the burst is spent on the branch at r_pc.
+
+        return H_TTL_EXP;
+    }
+
+    // Whether the PSR flags a COMPARE set meet the condition of a branch on condition opcode.
+    bool ConditionHolds(word opcode, word psr)
+    {
+        bool less = (psr & H_PSR_NEGATIVE) != 0;
+        bool equal = (psr & H_PSR_ZERO) != 0;
+
+        switch (opcode)
+        {
+        case H_OPCODE::BRANCH_ON_EQUAL: return equal;
+        case H_OPCODE::BRANCH_ON_NOT_EQUAL: return !equal;
+        case H_OPCODE::BRANCH_ON_LESS: return less;
+        case H_OPCODE::BRANCH_ON_LESS_EQUAL: return less || equal;
+        case H_OPCODE::BRANCH_ON_GREATER: return !less && !equal;
+        default: return !less; // BRANCH_ON_GREATER_EQUAL.
+        }
+    }
+
+    // Unsigned word, so the block kernels wrap on overflow like the CPU's ADD instead of being undefined.
+    typedef std::make_unsigned<word>::type uword;
+
+    // Lanes the block kernels work in. The loops over them have a fixed trip count and no dependency
+    // between lanes, so the compiler maps them onto the host's vector unit.
+    constexpr int H_BLOCK_LANES = 8;
+
+    // Sum of a block of words.
+    word BlockSumKernel(const word* block, word count)
+    {
+        uword lanes[H_BLOCK_LANES] = {};
+        word i = 0;
+
+        for (; i + H_BLOCK_LANES <= count; i += H_BLOCK_LANES)
+        {
+            for (int lane = 0; lane < H_BLOCK_LANES; lane++) { lanes[lane] += (uword) block[i + lane]; }
+        }
+
+        uword sum = 0;
+
+        for (; i < count; i++) { sum += (uword) block[i]; }
+        for (int lane = 0; lane < H_BLOCK_LANES; lane++) { sum += lanes[lane]; }
+
+        return (word) sum;
+    }
+
+    // Index of the first word two blocks differ in, or count if they are equal.
+    word BlockMismatchKernel(const word* a, const word* b, word count)
+    {
+        word i = 0;
+
+        for (; i + H_BLOCK_LANES <= count; i += H_BLOCK_LANES) // Whole chunks compare without a branch per word.
+        {
+            uword diff = 0;
+
+            for (int lane = 0; lane < H_BLOCK_LANES; lane++) { diff |= (uword) (a[i + lane] ^ b[i + lane]); }
+            if (diff != 0) { break; }
+        }
+
+        while (i < count && a[i] == b[i]) { i++; }
+
+        return i;
+    }
+
+    // Set a block of words to one value.
+    void BlockFillKernel(word* block, word count, word value)
+    {
+        for (word i = 0; i < count; i++) { block[i] = value; }
+    }
+
+    /*
+    * word: BlockOpcode
+    *
+    * Run a block opcode over the GPR0 words from its operands' addresses. Each block is bounds
+    * checked once, before any word is touched, and the words are charged h_block_words_per_tick at
+    * a time on top of the opcode's own cost. BLOCK_MOVE copies the block at operand 2 to operand 1,
+    * BLOCK_FILL sets the block at operand 1 to the value of operand 2, BLOCK_SUM stores the sum of
+    * the block at operand 2 in operand 1, and BLOCK_COMPARE sets the PSR flags as COMPARE would for
+    * the first words the blocks at operands 1 and 2 differ in and leaves their index in GPR0.
+    *
+    * @param opcode One of BLOCK_MOVE to BLOCK_COMPARE.
+    * @param op1_mode Mode of operand 1, which BLOCK_SUM stores to.
+    * @param op1_gpr GPR of operand 1.
+    * @param op1_addr Address FetchOperand found for operand 1.
+    * @param op2_addr Address FetchOperand found for operand 2.
+    * @param op2_value Value FetchOperand found for operand 2.
+    * @param time_left Clock ticks left in the burst, less the ticks of the words.
+    *
+    * @return OK, E_INVALID_MODE, E_MTOPS_INVALID_SIZE or E_MTOPS_INVALID_MEM_RANGE.
+    *
+    */
+    word BlockOpcode(word opcode, word op1_mode, word op1_gpr, word op1_addr, word op2_addr, word op2_value, word& time_left)
+    {
+        word count = r_gpr[0];
+        bool op1_block = opcode != H_OPCODE::BLOCK_SUM;
+        bool op2_block = opcode != H_OPCODE::BLOCK_FILL;
+
+        if (count < 0)
+        {
+            Console() << "Invalid block length in GPR0: " << count;
+            return E_MTOPS_INVALID_SIZE;
+        }
+
+        if ((op1_block && !BlockInRange(op1_addr, count)) || (op2_block && !BlockInRange(op2_addr, count)))
+        {
+            Console() << "Block outside the user free area.\n-- Addresses: " << op1_addr << ", " << op2_addr << "\n-- Words: " << count;
+            return E_MTOPS_INVALID_MEM_RANGE;
+        }
+
+        if (opcode == H_OPCODE::BLOCK_SUM && op1_mode == H_OPMODE::IMMEDIATE) { Console() << "Cannot store value in immediate mode."; return E_INVALID_MODE; }
+
+        if (mtops_cache != nullptr)
+        {
+            if (op2_block) { CacheBlock(op2_addr, count); }
+            if (op1_block) { CacheBlock(op1_addr, count); }
+        }
+
+        switch (opcode)
+        {
+        case H_OPCODE::BLOCK_MOVE:
+            if (count > 0)
+            {
+                memmove(&memory[op1_addr], &memory[op2_addr], count * sizeof(word)); // Overlapping blocks copy as if through a buffer.
+                MarkRangeDirty(op1_addr, count);
+            }
+            break;
+        case H_OPCODE::BLOCK_FILL:
+            if (count > 0)
+            {
+                BlockFillKernel(&memory[op1_addr], count, op2_value);
+                MarkRangeDirty(op1_addr, count);
+            }
+            break;
+        case H_OPCODE::BLOCK_SUM:
+        {
+            word sum = count > 0 ? BlockSumKernel(&memory[op2_addr], count) : 0;
+
+            if (op1_mode == H_OPMODE::REGISTER) { r_gpr[op1_gpr] = sum; }
+            else { StoreData(op1_addr, sum); }
+            break;
+        }
+        default: // BLOCK_COMPARE.
+        {
+            word at = count > 0 ? BlockMismatchKernel(&memory[op1_addr], &memory[op2_addr], count) : 0;
+            word a = at < count ? memory[op1_addr + at] : 0;
+            word b = at < count ? memory[op2_addr + at] : 0;
+
+            r_psr = (r_psr & H_PSR_MODE) | (a < b ? H_PSR_NEGATIVE : 0) | (a == b ? H_PSR_ZERO : 0);
+            r_gpr[0] = at;
+            break;
+        }
+        }
+
+        word ticks = (count + h_block_words_per_tick - 1) / h_block_words_per_tick;
+        clock += ticks;
+        time_left -= ticks;
+
+        return OK;
+    }
+
+    /*
+    * word: Interpret
+    *
+    * Simulate the Hypo CPU. Without Checked, the running process' code is taken to be verified and
+    * the checks VerifyProgram has made are skipped; the ones that depend on registers remain, and a
+    * RETURN to anywhere but a verified return site ends the burst with H_UNVERIFIED. With Paged,
+    * code is read through the TLB and a missing page ends the burst with H_PAGE_FAULT.
+    *
+    * @param time_left Clock ticks the burst may run for, left with what remains of them.
+    *
+    * @return A status code corresponding to H_ERROR_CODE.
+    * 
+    */
+    template <bool Checked, bool Paged>
+    word Interpret(word& time_left)
+    {
+        // Instruction parameters.
+        word opcode, op1_mode, op1_gpr, op2_mode, op2_gpr, op1_addr, op1_value, op2_addr, op2_value, result;
+
+        // Whether or not the CPU should halt execution.
+        bool should_halt = false;
+
+        // Whether a RETURN left the verified code, so the instructions from here on need their checks.
+        bool left_verified = false;
+
+        // The status of execution based on FetchOperand.
+        word status;
+
+        // Takes the profiler sample for the last instruction of the burst, whichever way the burst ends.
+        struct ProfileOnExit { ~ProfileOnExit() { if (clock >= mtops_profile_next) { ProfileSample(); } } } profile_on_exit;
+
+        while (!should_halt && !left_verified && time_left > 0)
+        {
+            if (clock >= mtops_profile_next) { ProfileSample(); } // The previous instruction passed a sample point.
+
+            if (!Checked || ProgramAddressInRange(r_pc))
+            {
+                if (Paged && !VMResident(r_pc)) { return H_PAGE_FAULT; } // Nothing has run yet, the instruction is retried once the page is in.
+
+                // Set r_mar to r_pc and increment r_pc to get the next word.
+                r_mar = r_pc++;
+
+                r_mbr = CodeWord<Paged>(r_mar);
+            }
+            else
+            {
+                Console() << "Invalid address for program counter: " << r_pc;
+                return E_INVALID_PC;
+            }
+
+            // Copy r_mbr to r_ir to process instruction.
+            r_ir = r_mbr;
+            mtops_instructions++;
+
+            if (mtops_trace != nullptr) { TraceFetch(); }
+
+            word _rem;
+            
+            // Slice EOM instruction down into opcodes, operand modes, and GPR dests.
+            opcode = r_ir / 10000;
+            _rem = r_ir % 10000;
+
+            if (h_debug) { Console() << std::endl << "instruction: " << r_ir << std::endl; }
+            if (h_debug) { Console() << "opcode: " << opcode << " = " << debug_opcode_descs[opcode] << std::endl; }
+
+            op1_mode = _rem / 1000;
+            _rem = _rem % 1000;
+
+            if (h_debug) { Console() << "op1 mode: " << op1_mode << " = " << debug_opmode_descs[op1_mode] << std::endl; }
+
+            op1_gpr = _rem / 100;
+            _rem = _rem % 100;
+
+            if (h_debug) { Console() << "op1 gpr: " << op1_gpr << std::endl; }
+
+            op2_mode = _rem / 10;
+            _rem = _rem % 10;
+
+            if (h_debug) { Console() << "op2 mode: " << op2_mode << " = " << debug_opmode_descs[op2_mode] << std::endl; }
+
+            op2_gpr = _rem;
+
+            if (h_debug) { Console() << "op2 gpr: " << op2_gpr << std::endl; }
+
+            if (Checked)
+            {
+                // Check validity of operand mode.
+                if (op1_mode < H_OPMODE::NO_OP || op1_mode > H_OPMODE::IMMEDIATE || op2_mode < H_OPMODE::NO_OP || op2_mode > H_OPMODE::IMMEDIATE)
+                {
+                    Console() << "Invalid mode for operand.\n" << "-- First operand mode: " << op1_mode << "\n-- Second operand mode: " << op2_mode;
+                    return E_INVALID_MODE;
+                }
+
+                size_t _gpr_len = (sizeof(r_gpr) / sizeof(r_gpr[0])) - 1;
+
+                // Check if the GPR exists (0 to sizeof(gprs)).
+                if (op1_gpr < 0 || op1_gpr > _gpr_len || op2_gpr < 0 || op2_gpr > _gpr_len)
+                {
+                    Console() << "Invalid GPR for operand.\n" << "-- First operand GPR: " << op1_gpr << "\n-- Second operand GPR: " << op2_gpr;
+                    return E_INVALID_GPR;
+                }
+            }
+
+            H_PERF(if ((unsigned long) opcode < H_OPCODE_COUNT) { mtops_perf->decoded[opcode][op1_mode][op2_mode]++; });
+
+            switch (opcode)
+            {
+            case H_OPCODE::HALT: // Opcode 0, halt execution.
+
+                // Halt execution.
+                should_halt = true;
+
+                break;
+
+            case H_OPCODE::ADD: // Opcode 1, add operands.
+                
+                status = FetchOperand<Checked, Paged>(op1_mode, op1_gpr, &op1_addr, &op1_value);
+                if (status < 0) { return status; }
+
+                status = FetchOperand<Checked, Paged>(op2_mode, op2_gpr, &op2_addr, &op2_value);
+                if (status < 0) { return status; }
+
+                // Add the values.
+                result = op1_value + op2_value;
+
+                if (Checked && op1_mode == H_OPMODE::IMMEDIATE) { Console() << "Cannot store value in immediate mode."; return H_ERROR_CODE::E_INVALID_MODE; }
+                if (op1_mode == H_OPMODE::REGISTER) { r_gpr[op1_gpr] = result; }
+                else { StoreData(op1_addr, result); }
+
+                break;
+            case H_OPCODE::SUBTRACT: // Opcode 2, subtract operands.
+                
+                status = FetchOperand<Checked, Paged>(op1_mode, op1_gpr, &op1_addr, &op1_value);
+                if (status < 0) { return status; }
+
+                status = FetchOperand<Checked, Paged>(op2_mode, op2_gpr, &op2_addr, &op2_value);
+                if (status < 0) { return status; }
+
+                // Subtract the values.
+                result = op1_value - op2_value;
+
+                if (Checked && op1_mode == H_OPMODE::IMMEDIATE) { Console() << "Cannot store value in immediate mode."; return H_ERROR_CODE::E_INVALID_MODE; }
+                if (op1_mode == H_OPMODE::REGISTER) { r_gpr[op1_gpr] = result; }
+                else { StoreData(op1_addr, result); }
+
+                break;
+            case H_OPCODE::MULTIPLY: // Opcode 3, multiply operands.
+                
+                status = FetchOperand<Checked, Paged>(op1_mode, op1_gpr, &op1_addr, &op1_value);
+                if (status < 0) { return status; }
+
+                status = FetchOperand<Checked, Paged>(op2_mode, op2_gpr, &op2_addr, &op2_value);
+                if (status < 0) { return status; }
+
+                // Multiply the values.
+                result = op1_value * op2_value;
+
+                if (Checked && op1_mode == H_OPMODE::IMMEDIATE) { Console() << "Cannot store value in immediate mode."; return H_ERROR_CODE::E_INVALID_MODE; }
+                if (op1_mode == H_OPMODE::REGISTER) { r_gpr[op1_gpr] = result; }
+                else { StoreData(op1_addr, result); }
+
+                break;
+            case H_OPCODE::DIVIDE: // Opcode 4, divide operands.
+                
+                status = FetchOperand<Checked, Paged>(op1_mode, op1_gpr, &op1_addr, &op1_value);
+                if (status < 0) { return status; }
+
+                status = FetchOperand<Checked, Paged>(op2_mode, op2_gpr, &op2_addr, &op2_value);
+                if (status < 0) { return status; }
+
+                // x/0 is undefined.
+                if (op2_value == 0)
+                {
+                    Console() << "Cannot divide by zero.";
+                    return E_DIVIDE_BY_ZERO;
+                }
+
+                // Divide the values.
+                result = op1_value / op2_value;
+
+                if (Checked && op1_mode == H_OPMODE::IMMEDIATE) { Console() << "Cannot store value in immediate mode."; return H_ERROR_CODE::E_INVALID_MODE; }
+                if (op1_mode == H_OPMODE::REGISTER) { r_gpr[op1_gpr] = result; }
+                else { StoreData(op1_addr, result); }
+
+                break;
+            case H_OPCODE::MOVE: // Opcode 5, move/reassign memory address to value.
+                
+                status = FetchOperand<Checked, Paged>(op1_mode, op1_gpr, &op1_addr, &op1_value);
+                if (status < 0) { return status; }
+
+                status = FetchOperand<Checked, Paged>(op2_mode, op2_gpr, &op2_addr, &op2_value);
+                if (status < 0) { return status; }
+
+                // Get result from operand 2.
+                result = op2_value;
+
+                if (Checked && op1_mode == H_OPMODE::IMMEDIATE) { Console() << "Cannot store value in immediate mode."; return H_ERROR_CODE::E_INVALID_MODE; }
+                if (op1_mode == H_OPMODE::REGISTER) { r_gpr[op1_gpr] = result; }
+                else { StoreData(op1_addr, result); } // Move result to memory address from operand 1.
+
+                break;
+            case H_OPCODE::BRANCH: // Opcode 6, branch/`goto` another memory address to continue execution.
+                
+                if (!Checked || ProgramAddressInRange(r_pc))
+                {
+                    // Get next instruction from current instruction.
+                    r_pc = CodeWord<Paged>(r_pc);
+                    if (mtops_shadow != nullptr && r_pc <= r_mar) { ProfileBranch(r_mar, r_pc); } // Loop back-edge.
+                }
+                else
+                {
+                    Console() << "Invalid address for program counter on BRANCH: " << r_pc;
+                    return E_INVALID_PC;
+                }
+
+                break;
+            case H_OPCODE::BRANCH_ON_MINUS: // Opcode 7, branch if the value in operand 0 is negative.
+                
+                status = FetchOperand<Checked, Paged>(op1_mode, op1_gpr, &op1_addr, &op1_value);
+                if (status < 0) { return status; }
+
+                // Check if operand 1 is negative.
+                if (op1_value < 0)
+                {
+                    if (!Checked || ProgramAddressInRange(r_pc))
+                    {
+                        // Get next instruction from current instruction.
+                        r_pc = CodeWord<Paged>(r_pc);
+                        if (mtops_shadow != nullptr && r_pc <= r_mar) { ProfileBranch(r_mar, r_pc); } // Loop back-edge.
+                    }
+                    else
+                    {
+                        Console() << "\nInvalid address for program counter on BRANCH_ON_MINUS: " << r_pc << std::endl;
+                        return E_INVALID_PC;
+                    }
+                }
+                else
+                {
+                    r_pc++; // Skip branch instruction.
+                    H_PERF(mtops_perf->counts[P_BRANCH_NOT_TAKEN]++);
+                }
+
+                break;
+            case H_OPCODE::BRANCH_ON_PLUS: // Opcode 8, branch if the value in operand 0 is positive.
+
+                status = FetchOperand<Checked, Paged>(op1_mode, op1_gpr, &op1_addr, &op1_value);
+                if (status < 0) { return status; }
+
+                // Check if operand 1 is positive.
+                if (op1_value > 0)
+                {
+                    if (!Checked || ProgramAddressInRange(r_pc))
+                    {
+                        // Get next instruction from current instruction.
+                        r_pc = CodeWord<Paged>(r_pc);
+                        if (mtops_shadow != nullptr && r_pc <= r_mar) { ProfileBranch(r_mar, r_pc); } // Loop back-edge.
+                    }
+                    else
+                    {
+                        Console() << "Invalid address for program counter on BRANCH_ON_PLUS: " << r_pc;
+                        return E_INVALID_PC;
+                    }
+                }
+                else
+                {
+                    r_pc++; // Skip branch instruction.
+                    H_PERF(mtops_perf->counts[P_BRANCH_NOT_TAKEN]++);
+                }
+
+                break;
+            case H_OPCODE::BRANCH_ON_ZERO: // Opcode 9, branch if the value in operand 0 is equal to zero.
+                
+                status = FetchOperand<Checked, Paged>(op1_mode, op1_gpr, &op1_addr, &op1_value);
+                if (status < 0) { return status; }
+
+                // Check if operand 1 is zero.
+                if (op1_value == 0)
+                {
+                    if (!Checked || ProgramAddressInRange(r_pc))
+                    {
+                        // Get next instruction from current instruction.
+                        r_pc = CodeWord<Paged>(r_pc);
+                        if (mtops_shadow != nullptr && r_pc <= r_mar) { ProfileBranch(r_mar, r_pc); } // Loop back-edge.
+                    }
+                    else
+                    {
+                        Console() << "Invalid address for program counter on BRANCH_ON_ZERO: " << r_pc;
+                        return E_INVALID_PC;
+                    }
+                }
+                else
+                {
+                    r_pc++; // Skip branch instruction.
+                    H_PERF(mtops_perf->counts[P_BRANCH_NOT_TAKEN]++);
+                }
+
+                break;
+            case H_OPCODE::PUSH: // Opcode 10, push the value of operand 1 to the stack.
+                
+                status = FetchOperand<Checked, Paged>(op1_mode, op1_gpr, &op1_addr, &op1_value);
+                if (status < 0) { return status; }
+
+                if (r_sp + 1 >= r_stack_limit) // Full, move the stack somewhere larger.
+                {
+                    status = GrowStack();
+                    if (status < 0) { return status; }
+                }
+
+                r_sp++;
+                StoreData(r_sp, op1_value);
+
+                break;
+            case H_OPCODE::POP: // Opcode 11, pop the latest value from the stack into operand 1.
+                
+                status = FetchOperand<Checked, Paged>(op1_mode, op1_gpr, &op1_addr, &op1_value);
+                if (status < 0) { return status; }
+
+                if (Checked && op1_mode == H_OPMODE::IMMEDIATE) { Console() << "Cannot store value in immediate mode."; return H_ERROR_CODE::E_INVALID_MODE; }
+
+                if (r_sp < r_stack_base)
+                {
+                    Console() << "Stack is empty, cannot pop.";
+                    return E_STACK_UNDERFLOW;
+                }
+                else
+                {
+                    result = LoadData(r_sp);
+                    r_sp--;
+
+                    if (op1_mode == H_OPMODE::REGISTER) { r_gpr[op1_gpr] = result; }
+                    else { StoreData(op1_addr, result); }
+                }
+
+                break;
+            case H_OPCODE::SYSCALL: // Opcode 12, perform a system function call.
+                
+                if (!Checked || ProgramAddressInRange(r_pc))
+                {
+                    status = FetchOperand<Checked, Paged>(op1_mode, op1_gpr, &op1_addr, &op1_value);
+                    if (status < 0) { return status; }
+
+                    // Execute the system call.
+                    status = SystemCall(op1_value);
+                    if (status == INT_IO_GETC || status == INT_IO_PUTC || status == H_FUTEX_WAIT || status == H_SLEEP || status == H_EXIT) { return status; }
+                }
+                else
+                {
+                    Console() << "Invalid address for program counter on SYSCALL: " << r_pc;
+                    return E_INVALID_PC;
+                }
+
+                break;
+            case H_OPCODE::CALL: // Opcode 13, push the return address and branch to the subroutine.
+
+                if (r_sp + 1 >= r_stack_limit) // Full, move the stack somewhere larger.
+                {
+                    status = GrowStack();
+                    if (status < 0) { return status; }
+                }
+
+                if (!Checked || ProgramAddressInRange(r_pc))
+                {
+                    r_sp++;
+                    StoreData(r_sp, r_pc + 1); // Return past the target word.
+                    r_pc = CodeWord<Paged>(r_pc);
+                }
+                else
+                {
+                    Console() << "Invalid address for program counter on CALL: " << r_pc;
+                    return E_INVALID_PC;
+                }
+
+                break;
+            case H_OPCODE::RETURN: // Opcode 14, pop the return address into the PC.
+
+                if (r_sp < r_stack_base)
+                {
+                    Console() << "Stack is empty, cannot return.";
+                    return E_STACK_UNDERFLOW;
+                }
+
+                r_pc = LoadData(r_sp);
+                r_sp--;
+
+                // The stack word may have been overwritten, only a return site the verifier followed is known good.
+                if (!Checked && ((size_t) r_pc >= mtops_return_sites->size() || !(*mtops_return_sites)[r_pc])) { left_verified = true; }
+
+                break;
+            case H_OPCODE::COMPARE: // Opcode 15, set the PSR flags from operand 1 compared with operand 2.
+
+                status = FetchOperand<Checked, Paged>(op1_mode, op1_gpr, &op1_addr, &op1_value);
+                if (status < 0) { return status; }
+
+                status = FetchOperand<Checked, Paged>(op2_mode, op2_gpr, &op2_addr, &op2_value);
+                if (status < 0) { return status; }
+
+                r_psr = (r_psr & H_PSR_MODE) | (op1_value < op2_value ? H_PSR_NEGATIVE : 0) | (op1_value == op2_value ? H_PSR_ZERO : 0);
+
+                break;
+            case H_OPCODE::BRANCH_ON_EQUAL: // Opcodes 16 to 21, branch if the PSR flags meet the opcode's condition.
+            case H_OPCODE::BRANCH_ON_NOT_EQUAL:
+            case H_OPCODE::BRANCH_ON_LESS:
+            case H_OPCODE::BRANCH_ON_LESS_EQUAL:
+            case H_OPCODE::BRANCH_ON_GREATER:
+            case H_OPCODE::BRANCH_ON_GREATER_EQUAL:
+
+                if (ConditionHolds(opcode, r_psr))
+                {
+                    if (!Checked || ProgramAddressInRange(r_pc))
+                    {
+                        // Get next instruction from current instruction.
+                        r_pc = CodeWord<Paged>(r_pc);
+                        if (mtops_shadow != nullptr && r_pc <= r_mar) { ProfileBranch(r_mar, r_pc); } // Loop back-edge.
+                    }
+                    else
+                    {
+                        Console() << "Invalid address for program counter on " << debug_opcode_descs[opcode] << ": " << r_pc;
+                        return E_INVALID_PC;
+                    }
+                }
+                else
+                {
+                    r_pc++; // Skip branch instruction.
+                    H_PERF(mtops_perf->counts[P_BRANCH_NOT_TAKEN]++);
+                }
+
+                break;
+            case H_OPCODE::BLOCK_MOVE: // Opcodes 22 to 25, work on the GPR0 words from the operands' addresses.
+            case H_OPCODE::BLOCK_FILL:
+            case H_OPCODE::BLOCK_SUM:
+            case H_OPCODE::BLOCK_COMPARE:
+
+                status = FetchOperand<Checked, Paged>(op1_mode, op1_gpr, &op1_addr, &op1_value);
+                if (status < 0) { return status; }
+
+                status = FetchOperand<Checked, Paged>(op2_mode, op2_gpr, &op2_addr, &op2_value);
+                if (status < 0) { return status; }
+
+                status = BlockOpcode(opcode, op1_mode, op1_gpr, op1_addr, op2_addr, op2_value, time_left);
+                if (status < 0) { return status; }
+
+                break;
+            default:
+                Console() << "Invalid opcode: " << opcode;
+                return E_INVALID_OPCODE;
+            }
+
+            clock += h_cycle_costs[opcode];
+            time_left -= h_cycle_costs[opcode];
+
+            if (mtops_cache != nullptr) // Misses are already on the clock, they also use up the burst.
+            {
+                time_left -= mtops_cache->stall;
+                mtops_cache->stall = 0;
+            }
+        }
+
+        if (should_halt)         { return H_HALT; }
+        else if (left_verified)  { return H_UNVERIFIED; }
+        else if (time_left <= 0) { return H_TTL_EXP; }
+        else                     { return E_UNKNOWN; }
+    }
+
+    // Clock ticks a process may run in its next burst: the TTL, cut to what is left of its quota for this period.
+    word BurstBudget(word pcb_ptr)
+    {
+        word quota = memory[pcb_ptr + I_QUOTA];
+        if (quota <= 0) { return h_ttl; }
+
+        word epoch = clock / h_quota_period;
+
+        if (memory[pcb_ptr + I_QUOTA_EPOCH] != epoch) // A new period, the quota is full again.
+        {
+            StoreWord(pcb_ptr + I_QUOTA_USED, 0);
+            StoreWord(pcb_ptr + I_QUOTA_EPOCH, epoch);
+        }
+
+        return std::min(h_ttl, quota - memory[pcb_ptr + I_QUOTA_USED]);
+    }
+
+    /*
+    * word: CPU
+    *
+    * Simulate the Hypo CPU for the running process, skipping the checks its code passed when it was
+    * verified. The burst ends when the TTL or the process' quota runs out, whichever comes first,
+    * and the ticks it ran are charged to the quota. A process whose RETURN leaves the verified code
+    * finishes the burst, and runs from then on, with every check.
+    *
+    * @return A status code corresponding to H_ERROR_CODE.
+    *
+    */
+    word CPU()
+    {
+        auto verified_entry = mtops_pcb_ptr != H_EOL ? mtops_verified_pids.find(memory[mtops_pcb_ptr + I_PID]) : mtops_verified_pids.end();
+        bool verified = h_verify && verified_entry != mtops_verified_pids.end();
+        word budget = mtops_pcb_ptr != H_EOL ? BurstBudget(mtops_pcb_ptr) : h_ttl;
+        word time_left = budget;
+        word status;
+
+        mtops_return_sites = verified ? &verified_entry->second : nullptr;
+
+        if (mtops_vm != nullptr) { status = verified ? Interpret<false, true>(time_left) : Interpret<true, true>(time_left); }
+        else { status = verified ? Interpret<false, false>(time_left) : Interpret<true, false>(time_left); }
+
+        if (status == H_UNVERIFIED)
+        {
+            mtops_verified_pids.erase(memory[mtops_pcb_ptr + I_PID]); // By key, a fork in the burst may have rehashed the map.
+            mtops_return_sites = nullptr;
+            status = mtops_vm != nullptr ? Interpret<true, true>(time_left) : Interpret<true, false>(time_left);
+        }
+
+        bool alive = status != H_HALT && status != H_EXIT && status >= 0;
+
+        if (alive && mtops_pcb_ptr != H_EOL && memory[mtops_pcb_ptr + I_QUOTA] > 0)
+        {
+            StoreWord(mtops_pcb_ptr + I_QUOTA_USED, memory[mtops_pcb_ptr + I_QUOTA_USED] + budget - time_left);
+        }
+
+        return status;
+    }
+
+    // Whether a process has used up its quota for a period that is still running, and the clock that period ends at.
+    bool QuotaExhausted(word pcb_ptr, word* period_end)
+    {
+        *period_end = (memory[pcb_ptr + I_QUOTA_EPOCH] + 1) * h_quota_period;
+
+        return memory[pcb_ptr + I_QUOTA] > 0 && memory[pcb_ptr + I_QUOTA_USED] >= memory[pcb_ptr + I_QUOTA] && *period_end > clock;
+    }
+
+    /*
+    * word: HandleBurstStatus
+    *
+    * File the running process according to the status its CPU burst ended with: back into the RQ,
+    * into the WQ, or terminated.
+    *
+    * @param status The status returned by CPU or IdleBurst.
+    *
+    * @return OK, or E_UNKNOWN for a status the OS does not know.
+    *
+    */
+    word HandleBurstStatus(word status)
+    {
+        H_PERF(RecordLatency(mtops_perf->latency[L_BURST], clock - mtops_burst_start)); // A process that deleted itself is already retired, its burst counts as unattributed.
+        CountError(status);
+
+        word period_end;
+
+        if (status == H_TTL_EXP && QuotaExhausted(mtops_pcb_ptr, &period_end)) // Quota used up, park until the next period.
+        {
+            Console() << "\nQuota used up, PID " << memory[mtops_pcb_ptr + I_PID] << " parked until " << period_end;
+            H_PERF(mtops_perf->counts[P_THROTTLES]++);
+            SaveContext(mtops_pcb_ptr);
+            StoreWord(mtops_pcb_ptr + I_WAIT_REASON, H_THROTTLED);
+            InsertIntoWQ(mtops_pcb_ptr);
+            AddTimer(mtops_pcb_ptr, period_end);
+            mtops_pcb_ptr = H_EOL;
+        }
+
+        else if (status == H_TTL_EXP) // Time has expired.
+        {
+            Console() << "TTL has timed out, saving context and reinserting to RQ...";
+            H_PERF(mtops_perf->counts[P_TTL_EXPIRATIONS]++);
+            SaveContext(mtops_pcb_ptr); // Save CPU context because the process is giving up CPU.
+            InsertIntoRQ(mtops_pcb_ptr); // Insert the current PCB into the RQ.
+            mtops_pcb_ptr = H_EOL;
+        }
+
+        else if (status == H_HALT || status == H_EXIT || status < 0) // Halt reached or the process deleted itself.
+        {
+            Console() << "Halt reached, terminating program...";
+            TerminateProcess(mtops_pcb_ptr); // End the process.
+            mtops_pcb_ptr = H_EOL;
+        }
+        
+        else if (status == INT_IO_GETC) // Input IO started.
+        {
+            Console() << "\nIIO_GETC, enter interrupt for PID: " << memory[mtops_pcb_ptr + I_PID];
+            SaveContext(mtops_pcb_ptr); //Save CPU Context of running process in its PCB, because the running process is losing control of the CPU.
+            StoreWord(mtops_pcb_ptr + I_WAIT_REASON, INT_IO_GETC);
+            InsertIntoWQ(mtops_pcb_ptr); //Insert running process into WQ.
+            mtops_pcb_ptr = H_EOL; 
+        }
+
+        else if (status == INT_IO_PUTC)  // Output IO started.
+        {
+            Console() << "\nIO_PUTC, enter interrupt for PID: " << memory[mtops_pcb_ptr + I_PID];
+            SaveContext(mtops_pcb_ptr); //Save CPU Context of running process in its PCB, because the running process is losing control of the CPU.
+            StoreWord(mtops_pcb_ptr + I_WAIT_REASON, INT_IO_PUTC); //Set reason for waiting in the running PCB to 'Output Completion Event'.
+            InsertIntoWQ(mtops_pcb_ptr); //Insert running process into WQ.
+            mtops_pcb_ptr = H_EOL; // Set the running PCB ptr to the end of list.
+        }
+
+        else if (status == H_FUTEX_WAIT) // Blocked on a shared memory word.
+        {
+            Console() << "\nFUTEX_WAIT, PID " << memory[mtops_pcb_ptr + I_PID] << " blocked on address " << memory[mtops_pcb_ptr + I_WAIT_ADDR];
+            SaveContext(mtops_pcb_ptr); // Save CPU context, the process sleeps until another process calls FUTEX_WAKE.
+            StoreWord(mtops_pcb_ptr + I_WAIT_REASON, H_FUTEX_WAIT);
+            InsertIntoWQ(mtops_pcb_ptr);
+            mtops_pcb_ptr = H_EOL;
+        }
+
+        else if (status == H_SLEEP) // Sleeping until a clock time.
+        {
+            Console() << "\nTIME_SLEEP, PID " << memory[mtops_pcb_ptr + I_PID] << " sleeping until " << memory[mtops_pcb_ptr + I_WAKE_TIME];
+            SaveContext(mtops_pcb_ptr); // Save CPU context, the timer wheel moves the process back to the RQ.
+            StoreWord(mtops_pcb_ptr + I_WAIT_REASON, H_SLEEP);
+            InsertIntoWQ(mtops_pcb_ptr);
+            AddTimer(mtops_pcb_ptr, memory[mtops_pcb_ptr + I_WAKE_TIME]);
+            mtops_pcb_ptr = H_EOL;
+        }
+
+        else if (status == H_PAGE_FAULT) // A page of the program area is not resident.
+        {
+            Console() << "\nPAGE_FAULT, PID " << memory[mtops_pcb_ptr + I_PID] << " reading in page " << mtops_vm->fault_page;
+            H_PERF(mtops_perf->counts[P_PAGE_FAULTS]++);
+            SaveContext(mtops_pcb_ptr); // The PC is still at the faulting instruction.
+
+            if (PageIn(memory[mtops_pcb_ptr + I_PAGE_TABLE], mtops_vm->fault_page, false) < 0)
+            {
+                Console() << "\nNo frame to read the page into, terminating program...";
+                TerminateProcess(mtops_pcb_ptr);
+            }
+            else
+            {
+                StoreWord(mtops_pcb_ptr + I_WAIT_REASON, H_PAGE_FAULT);
+                InsertIntoWQ(mtops_pcb_ptr);
+                AddTimer(mtops_pcb_ptr, clock + H_PAGE_FAULT_TICKS); // The timer wheel moves it back to the RQ once the read is done.
+            }
+
+            mtops_pcb_ptr = H_EOL;
+        }
+
+        else
+        {
+            Console() << "\nUnknown error. (0xDEAD)"; // Unknown programming error.
+            return E_UNKNOWN;
+        }
+
+        if (mtops_metrics != nullptr) { PublishMetrics(); }
+
+        return OK;
+    }
+
+    // Pristine machine image every pooled machine is reset to. Written once by CaptureMachineBaseline, then only read.
+    std::vector<word> h_baseline_memory;
+    SnapshotHeader h_baseline_header;
+
+    // Whether the machine on this thread holds the baseline apart from the pages marked H_DIRTY_RESET.
+    thread_local bool mtops_pooled = false;
+
+    /*
+    * void: CaptureMachineBaseline
+    *
+    * Take the machine on this thread, freshly booted with InitializeSystem, as the baseline that
+    * ResetMachine restores. Must be called before any other thread resets its machine.
+    *
+    */
+    void CaptureMachineBaseline()
+    {
+        h_baseline_memory.assign(memory, memory + sizeof(memory) / sizeof(memory[0]));
+        CaptureSnapshotHeader(&h_baseline_header, H_SNAPSHOT_FULL);
+
+        ClearDirtyPages(H_DIRTY_RESET);
+        mtops_pooled = true;
+    }
+
+    /*
+    * void: ResetMachine
+    *
+    * Reset the machine on this thread to the baseline. The first reset on a thread copies all of
+    * memory; later resets only copy back the pages written since the previous one.
+    *
+    */
+    void ResetMachine()
+    {
+        if (!mtops_pooled)
+        {
+            memcpy(memory, h_baseline_memory.data(), sizeof(memory));
+            MarkAllPagesDirty();
+            mtops_pooled = true;
+        }
+        else
+        {
+            for (int page = 0; page < H_PAGE_COUNT; page++)
+            {
+                if (mtops_dirty_pages[page] & H_DIRTY_RESET)
+                {
+                    word start = page * H_PAGE_SIZE;
+                    word count = std::min<word>(H_PAGE_SIZE, H_MAX_MEM_ADDR + 1 - start);
+
+                    memcpy(memory + start, h_baseline_memory.data() + start, count * sizeof(word));
+                    mtops_dirty_pages[page] = H_DIRTY_ALL; // Other consumers see the page change back.
+                }
+            }
+        }
+
+        ClearDirtyPages(H_DIRTY_RESET);
+
+        ApplySnapshotHeader(&h_baseline_header);
+        shutdown_status = false;
+    }
+
+    // Outcome of one batch run.
+    struct BatchResult
+    {
+        word status = OK; // Status of the program's last burst (H_HALT on a clean halt), or an error code.
+        word clock = 0; // Clock when the machine went idle.
+        word r_gpr[8] = {}; // Registers of the program when it ended.
+        word r_sp = 0;
+        word r_pc = 0;
+        word r_psr = 0;
+        uint64_t digest = 0; // FNV-1a hash of memory when the machine went idle.
+        std::vector<word> output; // Characters written with IO_PUTC, in order.
+        word context_switches = 0; // Processes dispatched.
+    };
+
+    // FNV-1a hash of memory taken a word at a time, so runs can be compared without keeping their memory.
+    uint64_t MemoryDigest()
+    {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+
+        for (word addr = 0; addr <= H_MAX_MEM_ADDR; addr++)
+        {
+            hash ^= (uint64_t) memory[addr];
+            hash *= 0x100000001b3ULL;
+        }
+
+        return hash;
+    }
+
+    // Whether nothing but the null process is left on the machine.
+    bool OnlyNullProcessLeft()
+    {
+        return mtops_pcb_ptr == H_EOL && WQ == H_EOL && RQ != H_EOL
+            && memory[RQ + I_PID] == mtops_null_pid && memory[RQ + I_NEXT_POINTER] == H_EOL;
+    }
+
+    // Header line of record/replay logs.
+    const std::string H_REPLAY_MAGIC = "hypo-replay 1";
+
+    // Start logging the operator's inputs for a later replay.
+    word StartRecord(const std::string& filename)
+    {
+        mtops_record.open(filename, std::ios::trunc);
+
+        if (!mtops_record.is_open())
+        {
+            std::cerr << "Failed to open replay log [" + filename + "]." << std::endl;
+            return E_FS_CANT_OPEN;
+        }
+
+        mtops_record << H_REPLAY_MAGIC << "\n";
+
+        return OK;
+    }
+
+    // End the log with where the session ended and a digest of memory, which a replay must reproduce.
+    void FinishRecord()
+    {
+        if (!mtops_record.is_open()) { return; }
+
+        mtops_record << "end " << mtops_sched_point << " " << clock << " " << std::hex << MemoryDigest() << std::dec << "\n";
+        mtops_record.close();
+    }
+
+    /*
+    * word: StartReplay
+    *
+    * Load a log made with StartRecord and feed its inputs to ReadInput in place of the operator's.
+    *
+    * @param filename The log to replay.
+    *
+    * @return OK, E_FS_CANT_OPEN, or E_MTOPS_BAD_REPLAY if the log is malformed.
+    *
+    */
+    word StartReplay(const std::string& filename)
+    {
+        std::ifstream in(filename);
+
+        if (!in.is_open())
+        {
+            std::cerr << "Failed to open replay log [" + filename + "]." << std::endl;
+            return E_FS_CANT_OPEN;
+        }
+
+        std::string line;
+        if (!std::getline(in, line) || line != H_REPLAY_MAGIC) { return E_MTOPS_BAD_REPLAY; }
+
+        mtops_replay.clear();
+        mtops_replay_next = 0;
+        mtops_replay_diverged = false;
+
+        while (std::getline(in, line))
+        {
+            ReplayEvent event;
+            std::istringstream fields(line);
+
+            if (line.compare(0, 4, "end ") == 0) { fields.ignore(4); }
+            if (!(fields >> event.point >> event.clock >> event.token)) { return E_MTOPS_BAD_REPLAY; }
+
+            mtops_replay.push_back(event); // The end line is kept last.
+        }
+
+        if (mtops_replay.empty()) { return E_MTOPS_BAD_REPLAY; }
+
+        mtops_replaying = true;
+
+        return OK;
+    }
+
+    /*
+    * word: FinishReplay
+    *
+    * Check that the replayed session ended where the recorded one did, with the same memory.
+    *
+    * @return OK if it did, E_MTOPS_BAD_REPLAY if not.
+    *
+    */
+    word FinishReplay()
+    {
+        if (!mtops_replaying) { return OK; }
+
+        mtops_replaying = false;
+
+        const ReplayEvent& end = mtops_replay.back();
+        std::ostringstream digest;
+        digest << std::hex << MemoryDigest();
+
+        if (mtops_replay_diverged || mtops_replay_next != mtops_replay.size() - 1 || end.point != mtops_sched_point || end.clock != clock || end.token != digest.str())
+        {
+            std::cerr << "Replay diverged: recording ended at scheduling point " << end.point << " clock " << end.clock << " digest " << end.token
+                << ", replay at scheduling point " << mtops_sched_point << " clock " << clock << " digest " << digest.str()
+                << " after " << mtops_replay_next << " of " << mtops_replay.size() - 1 << " inputs." << std::endl;
+            return E_MTOPS_BAD_REPLAY;
+        }
+
+        return OK;
+    }
+
+    /*
+    * BatchResult: RunBatch
+    *
+    * Run one program to completion on the pooled machine of this thread, without a console or an
+    * operator. IO_GETC is completed from the input vector and IO_PUTC into the result's output as
+    * soon as the process blocks, so no interrupts are needed.
+    *
+    * An interrupt script, if given, is read the way the operator's interrupts are, one interrupt
+    * before each dispatch until it runs out. A shutdown interrupt ends the run.
+    *
+    * @param image The program to run.
+    * @param input The characters IO_GETC returns, in order.
+    * @param max_clock Clock value after which the run is abandoned.
+    * @param interrupts The interrupt script, or nullptr.
+    *
+    * @return The result of the run. Its status is E_MTOPS_DEADLOCK if every process left is waiting
+    * on something that can never happen, and E_MTOPS_CYCLE_LIMIT if max_clock was reached.
+    *
+    */
+    BatchResult RunBatch(const ProgramImage& image, const std::vector<word>& input, word max_clock, std::istream* interrupts = nullptr)
+    {
+        BatchResult result;
+
+        std::ostream* console = h_console;
+        std::istream* source = h_input;
+        h_console = &h_null_console;
+        h_input = interrupts;
+
+        ResetMachine();
+
+        size_t next_input = 0;
+        word pcb_ptr = CreateProcessFromImage(image, H_DEFAULT_PRIORITY);
+
+        if (pcb_ptr < 0)
+        {
+            result.status = pcb_ptr;
+        }
+        else
+        {
+            word root_pid = memory[pcb_ptr + I_PID];
+            InsertIntoRQ(pcb_ptr);
+
+            while (!OnlyNullProcessLeft())
+            {
+                if (clock >= max_clock)
+                {
+                    result.status = E_MTOPS_CYCLE_LIMIT;
+                    break;
+                }
+
+                bool scripted = interrupts != nullptr && !(*interrupts >> std::ws).eof();
+
+                if (scripted)
+                {
+                    CheckAndProcessInterrupt();
+                    if (shutdown_status) { break; }
+                }
+                else if (RQ != H_EOL && memory[RQ + I_PID] == mtops_null_pid && memory[RQ + I_NEXT_POINTER] == H_EOL && mtops_timer_count == 0)
+                {
+                    result.status = E_MTOPS_DEADLOCK; // Everyone left is waiting and no timer will wake them.
+                    break;
+                }
+
+                AdvanceTimers(clock);
+
+                mtops_pcb_ptr = SelectProcessFromRQ();
+                Dispatcher(mtops_pcb_ptr);
+                result.context_switches++;
+
+                word pid = memory[mtops_pcb_ptr + I_PID];
+                word status = IdleSpinning(mtops_pcb_ptr) ? IdleBurst() : CPU();
+
+                if (pid == root_pid && (status == H_HALT || status == H_EXIT || status < 0))
+                {
+                    result.status = status;
+                    memcpy(result.r_gpr, r_gpr, sizeof(r_gpr));
+                    result.r_sp = r_sp;
+                    result.r_pc = r_pc;
+                    result.r_psr = r_psr;
+                }
+
+                if (HandleBurstStatus(status) < 0)
+                {
+                    result.status = E_UNKNOWN;
+                    break;
+                }
+
+                if (status == INT_IO_GETC && next_input < input.size())
+                {
+                    word waiting = SearchAndRemovePCBfromWQ(pid); // Input is already there, complete it right away.
+                    StoreWord(waiting + I_GPR1, input[next_input++]);
+                    StoreWord(waiting + I_STATE, H_READY_STATE);
+                    InsertIntoRQ(waiting);
+                }
+                else if (status == INT_IO_PUTC)
+                {
+                    word waiting = SearchAndRemovePCBfromWQ(pid);
+                    result.output.push_back(memory[waiting + I_GPR1]);
+                    StoreWord(waiting + I_STATE, H_READY_STATE);
+                    InsertIntoRQ(waiting);
+                }
+            }
+        }
+
+        result.clock = clock;
+        result.digest = MemoryDigest();
+
+        h_console = console;
+        h_input = source;
+
+        return result;
+    }
+    // Program symbols by address, from the symbol tables of program docs.
+    std::map<word, std::string> h_symbols;
+
+    /*
+    * int: LoadSymbols
+    *
+    * Read the "Symbol Table" section of a program doc, such as evensum.doc.md: a markdown table
+    * of symbol names and addresses.
+    *
+    * @param filename The doc to read.
+    *
+    * @return The number of symbols read, or E_FS_CANT_OPEN.
+    *
+    */
+    int LoadSymbols(std::string filename)
+    {
+        std::ifstream i_doc(filename);
+
+        if (!i_doc)
+        {
+            std::cerr << "Cannot open file: " << filename;
+            return E_FS_CANT_OPEN;
+        }
+
+        std::string line;
+        bool in_table = false;
+        int count = 0;
+
+        while (std::getline(i_doc, line))
+        {
+            if (line.find("Symbol Table") != std::string::npos) { in_table = true; continue; }
+            if (!in_table) { continue; }
+            if (line.compare(0, 2, "##") == 0) { break; } // Next section.
+            if (line.empty() || line[0] != '|') { continue; }
+
+            std::vector<std::string> cells;
+            std::istringstream row(line.substr(1));
+            std::string cell;
+
+            while (std::getline(row, cell, '|'))
+            {
+                size_t first = cell.find_first_not_of(" \t");
+                size_t last = cell.find_last_not_of(" \t");
+                cells.push_back(first == std::string::npos ? "" : cell.substr(first, last - first + 1));
+            }
+
+            if (cells.size() < 2 || cells[1].empty() || cells[1].find_first_not_of("0123456789") != std::string::npos)
+            {
+                continue; // Header or separator row.
+            }
+
+            h_symbols[std::stol(cells[1])] = cells[0];
+            count++;
+        }
+
+        return count;
+    }
+
+    // Name an address after the closest symbol at or below it, or by number if there is none.
+    std::string Symbolize(word addr)
+    {
+        auto symbol = h_symbols.upper_bound(addr);
+
+        if (symbol == h_symbols.begin()) { return "@" + std::to_string(addr); }
+
+        --symbol;
+
+        if (symbol->first == addr) { return symbol->second; }
+        return symbol->second + "+" + std::to_string(addr - symbol->first);
+    }
+
+    // Disassemble one instruction word, or return an empty string if it is not an instruction.
+    std::string Disassemble(word instruction)
+    {
+        word opcode = instruction / 10000;
+        if (instruction < 0 || opcode >= H_OPCODE_COUNT) { return ""; }
+
+        word modes[2] = { (instruction / 1000) % 10, (instruction / 10) % 10 };
+        word gprs[2] = { (instruction / 100) % 10, instruction % 10 };
+        std::string text = debug_opcode_descs[opcode];
+
+        for (int op = 0; op < 2; op++)
+        {
+            std::string gpr = "GPR" + std::to_string(gprs[op]);
+            std::string operand;
+
+            switch (modes[op])
+            {
+            case H_OPMODE::NO_OP: continue;
+            case H_OPMODE::REGISTER: operand = gpr; break;
+            case H_OPMODE::REGISTER_DEF: operand = "(" + gpr + ")"; break;
+            case H_OPMODE::AUTO_INC: operand = "(" + gpr + ")+"; break;
+            case H_OPMODE::AUTO_DEC: operand = "-(" + gpr + ")"; break;
+            case H_OPMODE::DIRECT: operand = "direct"; break;
+            case H_OPMODE::IMMEDIATE: operand = "immediate"; break;
+            default: return "";
+            }
+
+            text += (op == 0 ? " " : ", ") + operand;
+        }
+
+        return text;
+    }
+
+    // Whether the assembler runs its optimization passes.
+    bool h_asm_optimize = true;
+
+    // Assembler mnemonics, by opcode, as opcodes.md names them.
+    const std::string asm_mnemonics[H_OPCODE_COUNT] =
+    {
+        "halt", "add", "subtract", "multiply", "divide", "move", "branch", "bronminus", "bronplus", "bronzero",
+        "push", "pop", "systemcall", "call", "return", "compare", "bronequal", "bronnoteq", "bronless", "bronlesseq",
+        "brongreater", "brongreateq", "blockmove", "blockfill", "blocksum", "blockcompare"
+    };
+
+    // An operand as written in assembly: its mode and GPR, and for DIRECT and IMMEDIATE the word
+    // that follows the instruction, as a number or a symbol to resolve.
+    struct AsmOperand
+    {
+        word mode = H_OPMODE::NO_OP;
+        word gpr = 0;
+        word value = 0;
+        std::string symbol;
+    };
+
+    // A statement of an assembly source: an instruction, or a data word.
+    struct AsmStatement
+    {
+        std::vector<std::string> labels; // Labels naming its address.
+        bool data = false;
+        word opcode = H_OPCODE::HALT;
+        AsmOperand ops[2];
+        AsmOperand target; // Branch or call target, or the word of a data statement.
+        word origin = H_EOL; // Address an "org" before it moved assembly to.
+        int line = 0;
+    };
+
+    // A parsed assembly source.
+    struct AsmProgram
+    {
+        std::string filename;
+        std::vector<AsmStatement> statements;
+        std::map<std::string, word> equates;
+        std::map<word, bool> volatiles; // Addresses other processes may share, left alone by the optimizer.
+        AsmOperand entry;
+    };
+
+    // What the optimization passes changed, and the clock ticks it saves each time the changed code runs.
+    struct AsmReport
+    {
+        int threaded = 0;
+        int forwarded = 0;
+        int removed = 0;
+        int hoisted = 0;
+        word ticks = 0;
+    };
+
+    // Trim blanks off both ends of a string.
+    std::string AsmTrim(const std::string& text)
+    {
+        size_t first = text.find_first_not_of(" \t\r");
+        size_t last = text.find_last_not_of(" \t\r");
+        return first == std::string::npos ? "" : text.substr(first, last - first + 1);
+    }
+
+    // Lower case copy of a string, for mnemonics and GPR names.
+    std::string AsmLower(std::string text)
+    {
+        for (char& c : text) { c = (char) tolower((unsigned char) c); }
+        return text;
+    }
+
+    // Whether a string can name a label or an equate.
+    bool AsmIdentifier(const std::string& text)
+    {
+        if (text.empty() || !(isalpha((unsigned char) text[0]) || text[0] == '_')) { return false; }
+
+        for (char c : text)
+        {
+            if (!(isalnum((unsigned char) c) || c == '_')) { return false; }
+        }
+        return true;
+    }
+
+    // Parse a number or a symbol into the word of an operand.
+    bool AsmParseWord(const std::string& text, AsmOperand* op)
+    {
+        if (AsmIdentifier(text))
+        {
+            op->symbol = text;
+            return true;
+        }
+
+        size_t used = 0;
+
+        try { op->value = std::stol(text, &used); }
+        catch (...) { return false; }
+
+        return used == text.size();
+    }
+
+    // Parse a GPR name, GPR0 to GPR7.
+    bool AsmParseGPR(const std::string& text, word* gpr)
+    {
+        std::string name = AsmLower(text);
+
+        if (name.size() != 4 || name.compare(0, 3, "gpr") != 0 || name[3] < '0' || name[3] > '7') { return false; }
+
+        *gpr = name[3] - '0';
+        return true;
+    }
+
+    // Parse an operand in the syntax of its mode: GPRn, (GPRn), (GPRn)+, -(GPRn), #word, or a word for DIRECT.
+    bool AsmParseOperand(const std::string& text, AsmOperand* op)
+    {
+        size_t size = text.size();
+
+        if (AsmParseGPR(text, &op->gpr)) { op->mode = H_OPMODE::REGISTER; return true; }
+
+        if (size > 3 && text[0] == '(' && text.compare(size - 2, 2, ")+") == 0)
+        {
+            op->mode = H_OPMODE::AUTO_INC;
+            return AsmParseGPR(text.substr(1, size - 3), &op->gpr);
+        }
+        if (size > 3 && text.compare(0, 2, "-(") == 0 && text[size - 1] == ')')
+        {
+            op->mode = H_OPMODE::AUTO_DEC;
+            return AsmParseGPR(text.substr(2, size - 3), &op->gpr);
+        }
+        if (size > 2 && text[0] == '(' && text[size - 1] == ')')
+        {
+            op->mode = H_OPMODE::REGISTER_DEF;
+            return AsmParseGPR(text.substr(1, size - 2), &op->gpr);
+        }
+        if (size > 1 && text[0] == '#')
+        {
+            op->mode = H_OPMODE::IMMEDIATE;
+            return AsmParseWord(text.substr(1), op);
+        }
+
+        op->mode = H_OPMODE::DIRECT;
+        return AsmParseWord(text, op);
+    }
+
+    /*
+    * word: ParseAssembly
+    *
+    * Parse an assembly source. Each line holds optional "label:" prefixes, then an instruction or a
+    * directive, then an optional "; comment". Instructions are an opcodes.md mnemonic and its
+    * operands, separated by commas; branches and Call end with their target. Directives are
+    * "long word", "org address", "equ name, value", "volatile address" and "end entry".
+    *
+    * @param filename The source to read.
+    * @param program The program to fill.
+    *
+    * @return OK, or the loader status code closest to the error, printed as file:line: message.
+    *
+    */
+    word ParseAssembly(std::string filename, AsmProgram* program)
+    {
+        std::ifstream i_src(filename);
+
+        if (!i_src)
+        {
+            std::cerr << "Cannot open file: " << filename;
+            return E_FS_CANT_OPEN;
+        }
+
+        program->filename = filename;
+
+        std::map<std::string, int> defined; // Labels and equates, by the line defining them.
+        std::vector<std::string> pending; // Labels waiting for the statement they name.
+        word origin = H_EOL;
+        bool ended = false;
+        int line_no = 0;
+        std::string line;
+
+        auto fail = [&](const std::string& why, word status)
+        {
+            std::cerr << filename << ":" << line_no << ": " << why << std::endl;
+            return status;
+        };
+
+        auto define = [&](const std::string& name)
+        {
+            if (!AsmIdentifier(name)) { return false; }
+            return defined.emplace(name, line_no).second;
+        };
+
+        while (std::getline(i_src, line))
+        {
+            line_no++;
+
+            std::string text = line.substr(0, line.find(';'));
+            size_t colon;
+
+            while ((colon = text.find(':')) != std::string::npos)
+            {
+                std::string label = AsmTrim(text.substr(0, colon));
+
+                if (!define(label)) { return fail("bad or duplicate label \"" + label + "\"", E_INVALID_ADDR_IN_PROGRAM); }
+
+                pending.push_back(label);
+                text = text.substr(colon + 1);
+            }
+
+            std::istringstream tokens(text);
+            std::string mnemonic, rest, operand;
+            std::vector<std::string> operands;
+
+            if (!(tokens >> mnemonic)) { continue; }
+
+            std::getline(tokens, rest);
+            std::istringstream list(rest);
+
+            while (AsmTrim(rest) != "" && std::getline(list, operand, ','))
+            {
+                operands.push_back(AsmTrim(operand));
+            }
+
+            mnemonic = AsmLower(mnemonic);
+
+            if (ended) { return fail("statement after end", E_NO_EOF); }
+
+            AsmStatement statement;
+            AsmOperand value;
+
+            if (mnemonic == "equ" || mnemonic == "org" || mnemonic == "volatile" || mnemonic == "end")
+            {
+                size_t expect = mnemonic == "equ" ? 2 : 1;
+
+                if (operands.size() != expect || !AsmParseWord(operands.back(), &value))
+                {
+                    return fail(mnemonic + " takes " + (expect == 2 ? "a name and a word" : "one word"), E_INVALID_MODE);
+                }
+                if (mnemonic != "end" && !value.symbol.empty())
+                {
+                    auto equate = program->equates.find(value.symbol);
+                    if (equate == program->equates.end()) { return fail(mnemonic + " needs a number or an earlier equ", E_INVALID_MODE); }
+                    value.value = equate->second;
+                }
+
+                if (mnemonic == "equ")
+                {
+                    if (!define(operands[0])) { return fail("bad or duplicate equ \"" + operands[0] + "\"", E_INVALID_ADDR_IN_PROGRAM); }
+                    program->equates[operands[0]] = value.value;
+                }
+                else if (mnemonic == "org")
+                {
+                    if (!ProgramAddressInRange(value.value)) { return fail("org outside the program area", E_INVALID_ADDR_IN_PROGRAM); }
+                    origin = value.value;
+                }
+                else if (mnemonic == "volatile")
+                {
+                    program->volatiles[value.value] = true;
+                }
+                else
+                {
+                    program->entry = value;
+                    ended = true;
+                }
+                continue;
+            }
+            else if (mnemonic == "long")
+            {
+                if (operands.size() != 1 || !AsmParseWord(operands[0], &statement.target)) { return fail("long takes one word", E_INVALID_MODE); }
+                statement.data = true;
+            }
+            else
+            {
+                word opcode = std::find(asm_mnemonics, asm_mnemonics + H_OPCODE_COUNT, mnemonic) - asm_mnemonics;
+                if (opcode == H_OPCODE_COUNT) { return fail("unknown mnemonic \"" + mnemonic + "\"", E_INVALID_OPCODE); }
+
+                size_t count = OpcodeOperands(opcode);
+                size_t expect = count + (OpcodeBranches(opcode) ? 1 : 0);
+
+                if (operands.size() != expect) { return fail(mnemonic + " takes " + std::to_string(expect) + " operands", E_INVALID_MODE); }
+
+                for (size_t op = 0; op < count; op++)
+                {
+                    if (!AsmParseOperand(operands[op], &statement.ops[op])) { return fail("bad operand \"" + operands[op] + "\"", E_INVALID_MODE); }
+                }
+                if (OpcodeBranches(opcode) && !AsmParseWord(operands.back(), &statement.target))
+                {
+                    return fail("bad target \"" + operands.back() + "\"", E_INVALID_MODE);
+                }
+
+                bool stores = (opcode >= H_OPCODE::ADD && opcode <= H_OPCODE::MOVE) || opcode == H_OPCODE::POP || opcode == H_OPCODE::BLOCK_SUM;
+                if (stores && statement.ops[0].mode == H_OPMODE::IMMEDIATE) { return fail("immediate destination", E_INVALID_MODE); }
+
+                statement.opcode = opcode;
+            }
+
+            statement.labels.swap(pending);
+            statement.origin = origin;
+            statement.line = line_no;
+            origin = H_EOL;
+            program->statements.push_back(statement);
+        }
+
+        if (!ended) { return fail("missing end", E_NO_EOF); }
+        if (!pending.empty()) { return fail("label \"" + pending[0] + "\" names nothing", E_INVALID_ADDR_IN_PROGRAM); }
+
+        // Equates are plain numbers from here on, so the optimizer sees one spelling of each address.
+        for (AsmStatement& statement : program->statements)
+        {
+            for (AsmOperand* op : { &statement.ops[0], &statement.ops[1], &statement.target })
+            {
+                auto equate = program->equates.find(op->symbol);
+
+                if (!op->symbol.empty() && equate != program->equates.end())
+                {
+                    op->value = equate->second;
+                    op->symbol.clear();
+                }
+            }
+        }
+
+        return OK;
+    }
+
+    // Whether an opcode stores into operand 1.
+    bool AsmStoresOp1(word opcode)
+    {
+        return (opcode >= H_OPCODE::ADD && opcode <= H_OPCODE::MOVE) || opcode == H_OPCODE::POP || opcode == H_OPCODE::BLOCK_SUM;
+    }
+
+    // Whether an opcode reads the value of an operand, not only its address.
+    bool AsmReadsValue(word opcode, int op)
+    {
+        if (op == 0)
+        {
+            return (opcode >= H_OPCODE::ADD && opcode <= H_OPCODE::DIVIDE) || opcode == H_OPCODE::COMPARE
+                || (opcode >= H_OPCODE::BRANCH_ON_MINUS && opcode <= H_OPCODE::BRANCH_ON_ZERO) || opcode == H_OPCODE::PUSH || opcode == H_OPCODE::SYSCALL;
+        }
+        return (opcode >= H_OPCODE::ADD && opcode <= H_OPCODE::MOVE) || opcode == H_OPCODE::COMPARE || opcode == H_OPCODE::BLOCK_FILL;
+    }
+
+    // Whether a DIRECT operand names a shareable word the optimizer may track: a known user free address no one marked volatile.
+    bool AsmTrackable(const AsmProgram& program, const AsmOperand& op)
+    {
+        return op.mode == H_OPMODE::DIRECT && op.symbol.empty() && UserFreeAddressInRange(op.value) && program.volatiles.count(op.value) == 0;
+    }
+
+    /*
+    * bool: AsmBarrier
+    *
+    * Whether the value passes must forget what they know at a statement: data, anything that may
+    * fault, leave straight-line code other than by a branch, run other code, or reach memory
+    * through a GPR or an address they cannot vouch for.
+    *
+    */
+    bool AsmBarrier(const AsmProgram& program, const AsmStatement& statement)
+    {
+        if (statement.data) { return true; }
+
+        switch (statement.opcode)
+        {
+        case H_OPCODE::HALT: case H_OPCODE::DIVIDE: case H_OPCODE::PUSH: case H_OPCODE::POP: case H_OPCODE::SYSCALL:
+        case H_OPCODE::CALL: case H_OPCODE::RETURN:
+        case H_OPCODE::BLOCK_MOVE: case H_OPCODE::BLOCK_FILL: case H_OPCODE::BLOCK_SUM: case H_OPCODE::BLOCK_COMPARE:
+            return true;
+        }
+
+        for (int op = 0; op < OpcodeOperands(statement.opcode); op++)
+        {
+            word mode = statement.ops[op].mode;
+
+            if (mode == H_OPMODE::REGISTER_DEF || mode == H_OPMODE::AUTO_INC || mode == H_OPMODE::AUTO_DEC) { return true; }
+            if (mode == H_OPMODE::DIRECT && !AsmTrackable(program, statement.ops[op])) { return true; }
+        }
+        return false;
+    }
+
+    // Whether an operand of a statement is the location loc, a REGISTER or a trackable DIRECT operand.
+    bool AsmSameLocation(const AsmOperand& op, const AsmOperand& loc)
+    {
+        if (op.mode != loc.mode) { return false; }
+        return loc.mode == H_OPMODE::REGISTER ? op.gpr == loc.gpr : op.value == loc.value;
+    }
+
+    // Where each label of a program is, by statement index.
+    std::map<std::string, size_t> AsmLabelIndex(const AsmProgram& program)
+    {
+        std::map<std::string, size_t> index;
+
+        for (size_t i = 0; i < program.statements.size(); i++)
+        {
+            for (const std::string& label : program.statements[i].labels) { index[label] = i; }
+        }
+        return index;
+    }
+
+    // Whether straight-line code starts at a statement: it is first, named, placed by org, or follows a branch or a data word.
+    bool AsmBlockStart(const AsmProgram& program, size_t i)
+    {
+        if (i == 0) { return true; }
+
+        const AsmStatement& statement = program.statements[i];
+        const AsmStatement& previous = program.statements[i - 1];
+
+        return !statement.labels.empty() || statement.origin != H_EOL || previous.data || OpcodeBranches(previous.opcode)
+            || previous.opcode == H_OPCODE::HALT || previous.opcode == H_OPCODE::RETURN;
+    }
+
+    // Drop a statement, handing its labels and org to the one after it.
+    void AsmRemove(AsmProgram* program, size_t i)
+    {
+        std::vector<AsmStatement>& statements = program->statements;
+        AsmStatement& next = statements[i + 1];
+
+        next.labels.insert(next.labels.begin(), statements[i].labels.begin(), statements[i].labels.end());
+        if (next.origin == H_EOL) { next.origin = statements[i].origin; }
+
+        statements.erase(statements.begin() + i);
+    }
+
+    // Send branches that land on a Branch straight to its target, and drop branches to the next statement.
+    void ThreadBranches(AsmProgram* program, AsmReport* report)
+    {
+        std::vector<AsmStatement>& statements = program->statements;
+        std::map<std::string, size_t> index = AsmLabelIndex(*program);
+
+        for (AsmStatement& statement : statements)
+        {
+            if (statement.data || !OpcodeBranches(statement.opcode) || statement.target.symbol.empty()) { continue; }
+
+            std::string target = statement.target.symbol;
+
+            for (size_t hops = 0; hops < statements.size(); hops++)
+            {
+                auto at = index.find(target);
+                if (at == index.end()) { break; }
+
+                const AsmStatement& landing = statements[at->second];
+                if (landing.data || landing.opcode != H_OPCODE::BRANCH || landing.target.symbol.empty()) { break; }
+
+                target = landing.target.symbol;
+            }
+
+            if (target != statement.target.symbol)
+            {
+                statement.target.symbol = target;
+                report->threaded++;
+                report->ticks += h_cycle_costs[H_OPCODE::BRANCH];
+            }
+        }
+
+        for (size_t i = 0; i + 1 < statements.size(); i++)
+        {
+            const AsmStatement& statement = statements[i];
+            const AsmStatement& next = statements[i + 1];
+
+            if (statement.data || statement.opcode != H_OPCODE::BRANCH || next.origin != H_EOL) { continue; }
+            if (std::find(next.labels.begin(), next.labels.end(), statement.target.symbol) == next.labels.end()) { continue; }
+
+            AsmRemove(program, i);
+            report->removed++;
+            report->ticks += h_cycle_costs[H_OPCODE::BRANCH];
+
+            i -= std::min<size_t>(i, 1) + 1; // The statement before may now branch to the next one too.
+        }
+    }
+
+    // Read DIRECT operands from a GPR that already holds the word, within straight-line code.
+    void ForwardOperands(AsmProgram* program, AsmReport* report)
+    {
+        std::map<word, word> held; // GPR holding each DIRECT address' word.
+
+        for (size_t i = 0; i < program->statements.size(); i++)
+        {
+            AsmStatement& statement = program->statements[i];
+
+            if (AsmBlockStart(*program, i)) { held.clear(); }
+            if (AsmBarrier(*program, statement)) { held.clear(); continue; }
+
+            for (int op = 0; op < OpcodeOperands(statement.opcode); op++)
+            {
+                AsmOperand& operand = statement.ops[op];
+                auto gpr = held.find(operand.value);
+
+                if (operand.mode != H_OPMODE::DIRECT || !AsmReadsValue(statement.opcode, op) || gpr == held.end()) { continue; }
+                if (op == 0 && AsmStoresOp1(statement.opcode)) { continue; } // Still stores to memory.
+
+                operand.mode = H_OPMODE::REGISTER;
+                operand.gpr = gpr->second;
+                operand.value = 0;
+                report->forwarded++;
+            }
+
+            if (!AsmStoresOp1(statement.opcode)) { continue; }
+
+            const AsmOperand& to = statement.ops[0];
+            const AsmOperand& from = statement.ops[1];
+
+            if (to.mode == H_OPMODE::REGISTER)
+            {
+                for (auto entry = held.begin(); entry != held.end();)
+                {
+                    entry = entry->second == to.gpr ? held.erase(entry) : std::next(entry);
+                }
+                if (statement.opcode == H_OPCODE::MOVE && from.mode == H_OPMODE::DIRECT) { held[from.value] = to.gpr; }
+            }
+            else
+            {
+                held.erase(to.value);
+                if (statement.opcode == H_OPCODE::MOVE && from.mode == H_OPMODE::REGISTER) { held[to.value] = from.gpr; }
+            }
+        }
+    }
+
+    // Drop arithmetic and moves whose result a later Move overwrites before anything reads it, within straight-line code.
+    void RemoveDeadStores(AsmProgram* program, AsmReport* report)
+    {
+        std::vector<AsmStatement>& statements = program->statements;
+
+        for (size_t i = 0; i + 1 < statements.size(); i++)
+        {
+            const AsmStatement& statement = statements[i];
+            const AsmOperand& loc = statement.ops[0];
+
+            if (AsmBarrier(*program, statement) || statement.opcode < H_OPCODE::ADD || statement.opcode > H_OPCODE::MOVE) { continue; }
+
+            bool dead = false;
+
+            for (size_t j = i + 1; j < statements.size() && !AsmBlockStart(*program, j); j++)
+            {
+                const AsmStatement& later = statements[j];
+                bool read = false;
+
+                if (AsmBarrier(*program, later)) { break; }
+
+                for (int op = 0; op < OpcodeOperands(later.opcode); op++)
+                {
+                    read = read || (AsmReadsValue(later.opcode, op) && AsmSameLocation(later.ops[op], loc));
+                }
+                if (read) { break; }
+
+                if (later.opcode == H_OPCODE::MOVE && AsmSameLocation(later.ops[0], loc)) { dead = true; break; }
+                if (OpcodeBranches(later.opcode)) { break; }
+            }
+
+            if (dead)
+            {
+                report->removed++;
+                report->ticks += h_cycle_costs[statement.opcode];
+                AsmRemove(program, i--);
+            }
+        }
+    }
+
+    /*
+    * bool: HoistInvariant
+    *
+    * Move one loop invariant "Move GPRn, #word" or "Move GPRn, address" out of a loop: the
+    * statements from a backward branch's target up to the branch, entered only by falling into
+    * its head. The Move must run on every pass before anything that may branch or fault, GPRn must
+    * not be read before it or written elsewhere in the loop, its address must not be stored to in
+    * the loop, and the loop must not call or enter the OS.
+    *
+    * @return true if it hoisted one.
+    *
+    */
+    bool HoistInvariant(AsmProgram* program, AsmReport* report)
+    {
+        std::vector<AsmStatement>& statements = program->statements;
+        std::map<std::string, size_t> index = AsmLabelIndex(*program);
+
+        for (size_t end = 0; end < statements.size(); end++)
+        {
+            const AsmStatement& branch = statements[end];
+            if (branch.data || !OpcodeBranches(branch.opcode) || branch.opcode == H_OPCODE::CALL) { continue; }
+
+            auto at = index.find(branch.target.symbol);
+            if (at == index.end() || at->second == 0 || at->second > end) { continue; }
+
+            size_t head = at->second;
+            const AsmStatement& before = statements[head - 1];
+
+            if (statements[head].origin != H_EOL || before.data || before.opcode == H_OPCODE::BRANCH
+                || before.opcode == H_OPCODE::HALT || before.opcode == H_OPCODE::RETURN) { continue; }
+
+            // The loop's labels may only be reached from inside it.
+            std::map<std::string, bool> inside;
+            bool plain = true;
+
+            for (size_t k = head; k <= end; k++)
+            {
+                for (const std::string& label : statements[k].labels) { inside[label] = true; }
+
+                const AsmStatement& statement = statements[k];
+                plain = plain && !statement.data && (k == head || statement.origin == H_EOL) && statement.opcode != H_OPCODE::SYSCALL
+                    && statement.opcode != H_OPCODE::CALL && statement.opcode != H_OPCODE::RETURN && statement.opcode < H_OPCODE::BLOCK_MOVE;
+            }
+            bool closed = inside.count(program->entry.symbol) == 0;
+
+            for (size_t k = 0; k < statements.size() && closed; k++)
+            {
+                if (k >= head && k <= end) { continue; }
+
+                for (const AsmOperand* op : { &statements[k].ops[0], &statements[k].ops[1], &statements[k].target })
+                {
+                    closed = closed && inside.count(op->symbol) == 0;
+                }
+            }
+            if (!plain || !closed) { continue; }
+
+            for (size_t c = head; c < end; c++)
+            {
+                const AsmStatement& move = statements[c];
+                const AsmOperand& to = move.ops[0];
+                const AsmOperand& from = move.ops[1];
+
+                bool candidate = move.opcode == H_OPCODE::MOVE && to.mode == H_OPMODE::REGISTER
+                    && (from.mode == H_OPMODE::IMMEDIATE || AsmTrackable(*program, from));
+
+                for (size_t k = head; k <= end && candidate; k++)
+                {
+                    const AsmStatement& other = statements[k];
+
+                    for (int op = 0; op < OpcodeOperands(other.opcode) && candidate; op++)
+                    {
+                        const AsmOperand& operand = other.ops[op];
+                        bool indirect = operand.mode == H_OPMODE::REGISTER_DEF || operand.mode == H_OPMODE::AUTO_INC || operand.mode == H_OPMODE::AUTO_DEC;
+                        bool uses_gpr = operand.gpr == to.gpr && (indirect || operand.mode == H_OPMODE::REGISTER);
+
+                        if (k == c) { continue; }
+                        if (other.opcode == H_OPCODE::PUSH && from.mode == H_OPMODE::DIRECT) { candidate = false; } // Stacks are user free memory too.
+                        if (k < c && uses_gpr) { candidate = false; } // Read, or stepped, before the Move.
+                        if (uses_gpr && (operand.mode == H_OPMODE::AUTO_INC || operand.mode == H_OPMODE::AUTO_DEC)) { candidate = false; }
+                        if (op == 0 && AsmStoresOp1(other.opcode) && AsmSameLocation(operand, to)) { candidate = false; }
+                        if (op == 0 && AsmStoresOp1(other.opcode) && from.mode == H_OPMODE::DIRECT
+                            && (indirect || AsmSameLocation(operand, from) || (operand.mode == H_OPMODE::DIRECT && !AsmTrackable(*program, operand)))) { candidate = false; }
+                    }
+                }
+
+                if (candidate)
+                {
+                    AsmStatement hoisted = move;
+                    hoisted.labels.clear();
+
+                    AsmRemove(program, c); // Its labels stay in the loop, where the GPR already holds the word.
+                    statements.insert(statements.begin() + head, hoisted);
+
+                    report->hoisted++;
+                    report->ticks += h_cycle_costs[H_OPCODE::MOVE];
+                    return true;
+                }
+
+                if (AsmBarrier(*program, move) || OpcodeBranches(move.opcode)) { break; } // Later statements may not run every pass.
+            }
+        }
+
+        return false;
+    }
+
+    /*
+    * word: LayoutAssembly
+    *
+    * Give each statement its address, resolve every symbol, and encode the program into an image.
+    *
+    * @param program The parsed, possibly optimized program.
+    * @param image The image to fill.
+    *
+    * @return OK, E_INVALID_ADDR_IN_PROGRAM for unknown symbols and words outside the program area, or E_INVALID_PC.
+    *
+    */
+    word LayoutAssembly(const AsmProgram& program, ProgramImage* image)
+    {
+        std::map<std::string, word> labels;
+        std::map<word, int> placed; // Line that placed each address.
+        word addr = 0;
+
+        for (const AsmStatement& statement : program.statements)
+        {
+            if (statement.origin != H_EOL) { addr = statement.origin; }
+            for (const std::string& label : statement.labels) { labels[label] = addr; }
+
+            addr += 1 + (OpcodeBranches(statement.opcode) && !statement.data ? 1 : 0);
+
+            for (int op = 0; op < OpcodeOperands(statement.opcode) && !statement.data; op++)
+            {
+                addr += statement.ops[op].mode == H_OPMODE::DIRECT || statement.ops[op].mode == H_OPMODE::IMMEDIATE ? 1 : 0;
+            }
+        }
+
+        int line_no = 0;
+        bool resolved = true;
+
+        auto resolve = [&](const AsmOperand& op)
+        {
+            if (op.symbol.empty()) { return op.value; }
+
+            auto label = labels.find(op.symbol);
+            if (label != labels.end()) { return label->second; }
+
+            std::cerr << program.filename << ":" << line_no << ": unknown symbol \"" << op.symbol << "\"" << std::endl;
+            resolved = false;
+            return (word) 0;
+        };
+
+        auto emit = [&](word at, word content)
+        {
+            if (!ProgramAddressInRange(at) || !placed.emplace(at, line_no).second)
+            {
+                std::cerr << program.filename << ":" << line_no << ": address " << at << " is outside the program area or already used" << std::endl;
+                resolved = false;
+            }
+            image->words.push_back(std::make_pair(at, content));
+        };
+
+        image->words.clear();
+        addr = 0;
+
+        for (const AsmStatement& statement : program.statements)
+        {
+            line_no = statement.line;
+            if (statement.origin != H_EOL) { addr = statement.origin; }
+
+            if (statement.data)
+            {
+                emit(addr++, resolve(statement.target));
+                continue;
+            }
+
+            const AsmOperand* ops = statement.ops;
+            emit(addr++, statement.opcode * 10000 + ops[0].mode * 1000 + ops[0].gpr * 100 + ops[1].mode * 10 + ops[1].gpr);
+
+            for (int op = 0; op < OpcodeOperands(statement.opcode); op++)
+            {
+                if (ops[op].mode == H_OPMODE::DIRECT || ops[op].mode == H_OPMODE::IMMEDIATE) { emit(addr++, resolve(ops[op])); }
+            }
+            if (OpcodeBranches(statement.opcode)) { emit(addr++, resolve(statement.target)); }
+        }
+
+        if (!resolved) { return E_INVALID_ADDR_IN_PROGRAM; }
+
+        line_no = 0;
+        image->entry = resolve(program.entry);
+
+        if (!resolved || !ProgramAddressInRange(image->entry))
+        {
+            std::cerr << program.filename << ": entry point outside the program area" << std::endl;
+            return E_INVALID_PC;
+        }
+        return OK;
+    }
+
+    // Write a program image as a text EOM, or as a binary EOM that starts with H_EOM_MAGIC.
+    word WriteProgramImage(const ProgramImage& image, std::string filename, bool binary)
+    {
+        std::ofstream o_prog(filename, binary ? std::ios::binary : std::ios::out);
+
+        if (!o_prog)
+        {
+            std::cerr << "Cannot open file: " << filename;
+            return E_FS_CANT_OPEN;
+        }
+
+        if (!binary)
+        {
+            for (const auto& pair : image.words) { o_prog << pair.first << " " << pair.second << "\n"; }
+            o_prog << H_EOF << " " << image.entry << "\n";
+            return OK;
+        }
+
+        uint32_t count = (uint32_t) image.words.size();
+        int64_t entry = image.entry;
+
+        o_prog.write(H_EOM_MAGIC, sizeof(H_EOM_MAGIC));
+        o_prog.write(reinterpret_cast<const char*>(&count), sizeof(count));
+
+        for (const auto& pair : image.words)
+        {
+            int64_t words[2] = { pair.first, pair.second };
+            o_prog.write(reinterpret_cast<const char*>(words), sizeof(words));
+        }
+
+        o_prog.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        return o_prog ? OK : E_FS_CANT_OPEN;
+    }
+
+    /*
+    * word: Assemble
+    *
+    * Assemble a source into an EOM the loader runs, optimizing it first unless h_asm_optimize is
+    * off. The passes thread branches, forward DIRECT reads from GPRs, drop dead stores and hoist
+    * loop invariant moves; they assume code addresses are only ever written as labels, so a
+    * source with numeric branch targets is assembled as written.
+    *
+    * @param source The assembly source.
+    * @param output The EOM to write.
+    * @param binary Whether to write a binary EOM.
+    *
+    * @return OK, or the first error's status code.
+    *
+    */
+    word Assemble(std::string source, std::string output, bool binary)
+    {
+        AsmProgram program;
+        AsmReport report;
+        ProgramImage image;
+
+        word status = ParseAssembly(source, &program);
+        if (status < 0) { return status; }
+
+        bool symbolic = std::none_of(program.statements.begin(), program.statements.end(), [](const AsmStatement& statement)
+        {
+            return !statement.data && OpcodeBranches(statement.opcode) && statement.target.symbol.empty();
+        });
+
+        if (h_asm_optimize && symbolic)
+        {
+            ThreadBranches(&program, &report);
+            while (HoistInvariant(&program, &report)) {}
+            ForwardOperands(&program, &report);
+            RemoveDeadStores(&program, &report);
+        }
+
+        status = LayoutAssembly(program, &image);
+        if (status < 0) { return status; }
+
+        status = WriteProgramImage(image, output, binary);
+        if (status < 0) { return status; }
+
+        std::cout << source << " -> " << output << ": " << image.words.size() << " words, entry " << image.entry << std::endl;
+
+        if (h_asm_optimize && symbolic)
+        {
+            std::cout << "Threaded " << report.threaded << " branches, forwarded " << report.forwarded << " operands, removed "
+                << report.removed << " statements, hoisted " << report.hoisted << " invariants; "
+                << report.ticks << " clock ticks fewer per pass through the changed code." << std::endl;
+        }
+        else if (h_asm_optimize)
+        {
+            std::cout << "Not optimized: numeric branch targets." << std::endl;
+        }
+
+        return OK;
+    }
+
+    /*
+    * word: WriteProfile
+    *
+    * Write the profiler's samples as <prefix>.folded, one "pid;loop;...;pc count" line per stack
+    * for flame graph tools, and <prefix>.listing, the sampled program range annotated with samples.
+    *
+    * @param prefix The path both files start with.
+    *
+    * @return OK, or E_FS_CANT_OPEN.
+    *
+    */
+    word WriteProfile(std::string prefix)
+    {
+        std::ofstream o_folded(prefix + ".folded");
+        std::ofstream o_listing(prefix + ".listing");
+
+        if (!o_folded || !o_listing)
+        {
+            std::cerr << "Cannot open file: " << prefix << ".folded/.listing";
+            return E_FS_CANT_OPEN;
+        }
+
+        for (const auto& stack : mtops_profile_stacks)
+        {
+            o_folded << "pid " << stack.first[0];
+
+            for (size_t frame = 1; frame + 1 < stack.first.size(); frame++)
+            {
+                o_folded << ";loop " << Symbolize(stack.first[frame]);
+            }
+
+            o_folded << ";" << Symbolize(stack.first.back()) << " " << stack.second << "\n";
+        }
+
+        uint64_t total = 0;
+        word first = H_EOL, last = H_EOL;
+
+        for (word addr = 0; addr < (word) mtops_profile_hits.size(); addr++)
+        {
+            if (mtops_profile_hits[addr] == 0) { continue; }
+
+            total += mtops_profile_hits[addr];
+            if (first == H_EOL) { first = addr; }
+            last = addr;
+        }
+
+        o_listing << "Samples every " << mtops_profile_period << " clock ticks, " << total << " in the program area.\n\n";
+        o_listing << "Samples      %   Addr  Content  Instruction\n";
+
+        for (word addr = first; first != H_EOL && addr <= last; addr++)
+        {
+            auto symbol = h_symbols.find(addr);
+            if (symbol != h_symbols.end()) { o_listing << symbol->second << ":\n"; }
+
+            uint64_t hits = mtops_profile_hits[addr];
+
+            if (hits > 0)
+            {
+                o_listing << std::setw(7) << hits << std::setw(7) << std::fixed << std::setprecision(2) << 100.0 * hits / total;
+            }
+            else
+            {
+                o_listing << std::setw(14) << "";
+            }
+
+            o_listing << std::setw(7) << addr << std::setw(9) << memory[addr] << "  " << (hits > 0 ? Disassemble(memory[addr]) : "") << "\n";
+        }
+
+        return OK;
+    }
+
+    // One job of a batch manifest and what it is expected to produce.
+    struct BatchJob
+    {
+        std::string program;
+        std::string script; // Interrupt script, read from the file named in the manifest. Empty for none.
+        std::vector<word> input; // Characters IO_GETC returns.
+        word max_clock = H_BATCH_MAX_CLOCK;
+
+        bool check_status = false;
+        bool check_clock = false;
+        bool check_output = false;
+        word expect_status = 0;
+        word expect_clock = 0;
+        std::string expect_output;
+
+        ProgramImage image;
+        word load_status = OK; // Status of reading the program and script, checked before the job runs.
+    };
+
+    // What running one job produced.
+    struct BatchJobReport
+    {
+        BatchResult result;
+        long long wall_us = 0;
+        bool passed = false;
+    };
+
+    // Decode the escapes allowed in manifest values: \s for a space, \n for a newline, \\ for a backslash.
+    std::string DecodeManifestValue(const std::string& value)
+    {
+        std::string decoded;
+
+        for (size_t i = 0; i < value.size(); i++)
+        {
+            if (value[i] == '\\' && i + 1 < value.size())
+            {
+                char escape = value[++i];
+                decoded += escape == 's' ? ' ' : escape == 'n' ? '\n' : escape;
+            }
+            else
+            {
+                decoded += value[i];
+            }
+        }
+
+        return decoded;
+    }
+
+    /*
+    * int: ReadManifest
+    *
+    * Read a batch manifest. Each line is a job: the EOM file followed by key=value options, with
+    * blank lines and lines starting with # ignored. The options are script, input, max_clock,
+    * expect_status, expect_clock and expect_output.
+    *
+    * Every program and script is read here, so workers never touch the file system.
+    *
+    * @param filename The manifest to read.
+    * @param jobs The jobs read.
+    *
+    * @return OK, or E_FS_CANT_OPEN if the manifest can't be opened.
+    *
+    */
+    int ReadManifest(std::string filename, std::vector<BatchJob>* jobs)
+    {
+        std::ifstream i_manifest(filename);
+
+        if (!i_manifest)
+        {
+            std::cerr << "Cannot open file: " << filename;
+            return E_FS_CANT_OPEN;
+        }
+
+        std::string line;
+
+        while (std::getline(i_manifest, line))
+        {
+            std::istringstream fields(line);
+            BatchJob job;
+
+            if (!(fields >> job.program) || job.program[0] == '#') { continue; }
+
+            std::string option;
+
+            while (fields >> option)
+            {
+                size_t split = option.find('=');
+                std::string key = option.substr(0, split);
+                std::string value = split == std::string::npos ? "" : DecodeManifestValue(option.substr(split + 1));
+
+                if (key == "script") { job.script = value; }
+                else if (key == "input") { job.input.assign(value.begin(), value.end()); }
+                else if (key == "max_clock") { job.max_clock = std::stol(value); }
+                else if (key == "expect_status") { job.check_status = true; job.expect_status = std::stol(value); }
+                else if (key == "expect_clock") { job.check_clock = true; job.expect_clock = std::stol(value); }
+                else if (key == "expect_output") { job.check_output = true; job.expect_output = value; }
+                else { std::cerr << "Unknown manifest option: " << key << std::endl; }
+            }
+
+            job.load_status = ReadProgramImage(job.program, &job.image);
+
+            if (job.load_status >= 0 && !job.script.empty())
+            {
+                std::ifstream i_script(job.script);
+                std::ostringstream script;
+
+                if (!i_script)
+                {
+                    std::cerr << "Cannot open file: " << job.script;
+                    job.load_status = E_FS_CANT_OPEN;
+                }
+                else
+                {
+                    script << i_script.rdbuf();
+                    job.script = script.str();
+                }
+            }
+
+            jobs->push_back(std::move(job));
+        }
+
+        return OK;
+    }
+
+    // Run one job on the pooled machine of this thread and check it against its expectations.
+    BatchJobReport RunBatchJob(const BatchJob& job)
+    {
+        BatchJobReport report;
+
+        auto start = std::chrono::steady_clock::now();
+
+        if (job.load_status < 0)
+        {
+            report.result.status = job.load_status;
+        }
+        else if (job.script.empty())
+        {
+            report.result = RunBatch(job.image, job.input, job.max_clock);
+        }
+        else
+        {
+            std::istringstream interrupts(job.script);
+            report.result = RunBatch(job.image, job.input, job.max_clock, &interrupts);
+        }
+
+        report.wall_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+        std::string output(report.result.output.begin(), report.result.output.end());
+
+        report.passed = job.load_status >= 0
+            && (!job.check_status || report.result.status == job.expect_status)
+            && (!job.check_clock || report.result.clock == job.expect_clock)
+            && (!job.check_output || output == job.expect_output);
+
+        return report;
+    }
+
+    // Jobs of one worker. The worker takes from the back, idle workers steal from the front.
+    struct WorkQueue
+    {
+        std::mutex lock;
+        std::deque<size_t> jobs;
+    };
+
+    // Take the next job for a worker, stealing from the other workers once its own queue is empty.
+    bool TakeJob(std::vector<WorkQueue>& queues, size_t self, size_t* job)
+    {
+        for (size_t i = 0; i < queues.size(); i++)
+        {
+            WorkQueue& queue = queues[(self + i) % queues.size()];
+            std::lock_guard<std::mutex> guard(queue.lock);
+
+            if (queue.jobs.empty()) { continue; }
+
+            if (i == 0) { *job = queue.jobs.back(); queue.jobs.pop_back(); }
+            else { *job = queue.jobs.front(); queue.jobs.pop_front(); }
+
+            return true;
+        }
+
+        return false;
+    }
+
+    /*
+    * void: RunBatchJobs
+    *
+    * Spread jobs across a work-stealing pool of host threads, each with its own pooled machine.
+    * CaptureMachineBaseline must have been called first.
+    *
+    * @param jobs The jobs to run.
+    * @param threads The number of worker threads.
+    * @param reports One report per job, in job order.
+    *
+    */
+    void RunBatchJobs(const std::vector<BatchJob>& jobs, size_t threads, std::vector<BatchJobReport>* reports)
+    {
+        threads = std::max<size_t>(1, std::min(threads, jobs.size()));
+
+        std::vector<WorkQueue> queues(threads);
+        reports->assign(jobs.size(), BatchJobReport());
+
+        for (size_t job = 0; job < jobs.size(); job++)
+        {
+            queues[job % threads].jobs.push_back(job); // Deal the jobs out, stealing evens out the rest.
+        }
+
+        std::vector<std::thread> workers;
+
+        for (size_t worker = 0; worker < threads; worker++)
+        {
+            workers.emplace_back([&jobs, &queues, reports, worker]()
+            {
+                size_t job;
+
+                while (TakeJob(queues, worker, &job))
+                {
+                    (*reports)[job] = RunBatchJob(jobs[job]);
+                }
+            });
+        }
+
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    // Write a string as a JSON string literal.
+    void WriteJSONString(std::ostream& out, const std::string& value)
+    {
+        out << '"';
+
+        for (unsigned char c : value)
+        {
+            if (c == '"' || c == '\\') { out << '\\' << c; }
+            else if (c == '\n') { out << "\\n"; }
+            else if (c < 0x20 || c >= 0x7F) { out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int) c << std::dec << std::setfill(' '); }
+            else { out << c; }
+        }
+
+        out << '"';
+    }
+
+    // Write the report of a batch run as JSON.
+    void WriteBatchReport(std::ostream& out, const std::vector<BatchJob>& jobs, const std::vector<BatchJobReport>& reports, size_t threads, long long wall_us)
+    {
+        size_t passed = 0;
+
+        out << "{\n  \"threads\": " << threads << ",\n  \"jobs\": [";
+
+        for (size_t job = 0; job < jobs.size(); job++)
+        {
+            const BatchResult& result = reports[job].result;
+            std::ostringstream digest;
+            digest << std::hex << std::setw(16) << std::setfill('0') << result.digest;
+
+            if (reports[job].passed) { passed++; }
+
+            out << (job == 0 ? "\n" : ",\n") << "    {\"program\": ";
+            WriteJSONString(out, jobs[job].program);
+            out << ", \"status\": " << result.status
+                << ", \"clock\": " << result.clock
+                << ", \"context_switches\": " << result.context_switches
+                << ", \"wall_us\": " << reports[job].wall_us
+                << ", \"digest\": \"" << digest.str() << "\""
+                << ", \"output\": ";
+            WriteJSONString(out, std::string(result.output.begin(), result.output.end()));
+            out << ", \"passed\": " << (reports[job].passed ? "true" : "false") << "}";
+        }
+
+        out << "\n  ],\n  \"passed\": " << passed << ",\n  \"failed\": " << jobs.size() - passed << ",\n  \"wall_us\": " << wall_us << "\n}\n";
+    }
+
+}
+
+/*
+* int: BootBatchBaseline
+*
+* Boot the machine on this thread without a console and take it as the baseline of every pooled machine.
+*
+* @return OK, or E_FS_CANT_OPEN if the null process could not be loaded.
+*
+*/
+int BootBatchBaseline()
+{
+    Hypo::h_console = &Hypo::h_null_console;
+    Hypo::InitializeSystem();
+    Hypo::h_console = &std::cout;
+
+    if (Hypo::mtops_null_pid == Hypo::H_EOL || Hypo::RQ == Hypo::H_EOL)
+    {
+        std::cerr << "Cannot load null process: " << Hypo::h_null_program << std::endl;
+        return Hypo::E_FS_CANT_OPEN;
+    }
+
+    Hypo::CaptureMachineBaseline();
+
+    return Hypo::OK;
+}
+
+/*
+* int: RunBatchMode
+*
+* Boot one machine, take it as the pool baseline and run a program on it the given number of times,
+* printing the result of each run. With a profile prefix, the runs are profiled together.
+*
+* @return 0, or the error code of the boot or the program file.
+*
+*/
+int RunBatchMode(const std::string& program, long runs, const std::vector<Hypo::word>& input, const std::string& profile, Hypo::word profile_period)
+{
+    int boot = BootBatchBaseline();
+    if (boot < 0) { return boot; }
+
+    Hypo::ProgramImage image;
+    Hypo::word status = Hypo::ReadProgramImage(program, &image);
+    if (status < 0) { return (int) status; }
+
+    if (!profile.empty()) { Hypo::StartProfiler(profile_period); }
+
+    for (long run = 0; run < runs; run++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        Hypo::BatchResult result = Hypo::RunBatch(image, input, Hypo::H_BATCH_MAX_CLOCK);
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+        std::cout << "run " << run << ": status " << result.status << " clock " << result.clock << " pc " << result.r_pc << " sp " << result.r_sp << " gpr";
+
+        for (int gpr = 0; gpr < 8; gpr++)
+        {
+            std::cout << " " << result.r_gpr[gpr];
+        }
+
+        std::cout << " digest " << std::hex << result.digest << std::dec << " output \"";
+
+        for (Hypo::word c : result.output)
+        {
+            std::cout << (char) c;
+        }
+
+        std::cout << "\" " << elapsed.count() << "us" << std::endl;
+    }
+
+    if (!profile.empty()) { return (int) Hypo::WriteProfile(profile); }
+
+    return 0;
+}
+
+/*
+* int: RunManifestMode
+*
+* Run every job of a manifest across a pool of threads and write a JSON report.
+*
+* @param manifest The manifest file.
+* @param threads The number of worker threads.
+* @param report The report file, or empty for standard output.
+*
+* @return 0 if every job passed, 1 if any failed, or an error code.
+*
+*/
+int RunManifestMode(const std::string& manifest, size_t threads, const std::string& report)
+{
+    int boot = BootBatchBaseline();
+    if (boot < 0) { return boot; }
+
+    std::vector<Hypo::BatchJob> jobs;
+    int status = Hypo::ReadManifest(manifest, &jobs);
+    if (status < 0) { return status; }
+
+    std::vector<Hypo::BatchJobReport> reports;
+
+    auto start = std::chrono::steady_clock::now();
+    Hypo::RunBatchJobs(jobs, threads, &reports);
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+    threads = std::max<size_t>(1, std::min(threads, jobs.size()));
+
+    if (report.empty())
+    {
+        Hypo::WriteBatchReport(std::cout, jobs, reports, threads, elapsed.count());
+    }
+    else
+    {
+        std::ofstream o_report(report);
+
+        if (!o_report)
+        {
+            std::cerr << "Cannot open file: " << report;
+            return Hypo::E_FS_CANT_OPEN;
+        }
+
+        Hypo::WriteBatchReport(o_report, jobs, reports, threads, elapsed.count());
+    }
+
+    for (const Hypo::BatchJobReport& job : reports)
+    {
+        if (!job.passed) { return 1; }
+    }
+
+    return 0;
+}
+
+#ifdef HYPO_BENCH
+
+// Directory holding null.eom and the shipped EOM programs.
+#ifndef HYPO_PROGRAM_DIR
+#define HYPO_PROGRAM_DIR ".."
+#endif
+
+// Micro and macro benchmarks of the simulator, built only into the hypo_bench target.
+namespace HypoBench
+{
+    using Hypo::word;
+
+    // Guest instructions each opcode loop repeats its body before branching back.
+    constexpr int B_UNROLL = 16;
+
+    // CPU bursts run per opcode measurement.
+    constexpr int B_OPCODE_BURSTS = 1000;
+
+    // Calls per FetchOperand, context switch and RQ measurement.
+    constexpr int B_CALLS = 1000000;
+
+    // Words of a block opcode measurement.
+    constexpr int B_BLOCK_WORDS = 1000;
+
+    // Operations per allocator measurement.
+    constexpr int B_ALLOC_OPS = 50000;
+
+    // Batch runs per macro measurement.
+    constexpr int B_MACRO_RUNS = 200;
+
+    // Address and content pairs of the generated EOM the loader is measured on.
+    constexpr int B_LOAD_PAIRS = 1 << 20;
+
+    // Host timestamp counter where there is one, nanoseconds otherwise.
+    inline uint64_t HostCycles()
+    {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // Host nanoseconds.
+    inline uint64_t HostNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Keeps results of benchmarked calls alive so the compiler can't drop the calls.
+    volatile word b_sink;
+
+    // Median of repeated measurements.
+    double Median(std::vector<double> values)
+    {
+        std::sort(values.begin(), values.end());
+        return values[values.size() / 2];
+    }
+
+    // Value at a percentile of sorted samples.
+    double Percentile(const std::vector<double>& sorted, double percent)
+    {
+        size_t index = std::min(sorted.size() - 1, (size_t) (percent / 100.0 * sorted.size()));
+        return sorted[index];
+    }
+
+    // Write latency percentiles of a set of samples as a JSON object.
+    void WritePercentiles(std::ostream& out, std::vector<double> samples)
+    {
+        std::sort(samples.begin(), samples.end());
+
+        out << "{\"p50\": " << Percentile(samples, 50) << ", \"p90\": " << Percentile(samples, 90)
+            << ", \"p99\": " << Percentile(samples, 99) << ", \"p999\": " << Percentile(samples, 99.9)
+            << ", \"max\": " << samples.back() << "}";
+    }
+
+    // Reset the pooled machine and make a process of the image the running one.
+    word DispatchImage(const Hypo::ProgramImage& image)
+    {
+        Hypo::ResetMachine();
+
+        word pcb_ptr = Hypo::CreateProcessFromImage(image, Hypo::H_DEFAULT_PRIORITY);
+        Hypo::InsertIntoRQ(pcb_ptr);
+
+        Hypo::mtops_pcb_ptr = Hypo::SelectProcessFromRQ();
+        Hypo::Dispatcher(Hypo::mtops_pcb_ptr);
+
+        return Hypo::mtops_pcb_ptr;
+    }
+
+    // Words of one instruction of the opcode loop, placed at addr. GPR1 is 0 and GPR2 is 1.
+    std::vector<word> OpcodeBody(int opcode, word addr)
+    {
+        switch (opcode)
+        {
+        case Hypo::H_OPCODE::BRANCH: return { 60000, addr + 2 };
+        case Hypo::H_OPCODE::BRANCH_ON_MINUS: return { 71100, addr + 2 }; // GPR1 is 0, not taken.
+        case Hypo::H_OPCODE::BRANCH_ON_PLUS: return { 81200, addr + 2 }; // GPR2 is 1, taken.
+        case Hypo::H_OPCODE::BRANCH_ON_ZERO: return { 91100, addr + 2 }; // GPR1 is 0, taken.
+        case Hypo::H_OPCODE::PUSH: return { 101100, 111100 }; // Push and pop in pairs so the stack never fills.
+        case Hypo::H_OPCODE::SYSCALL: return { 126000, Hypo::TIME_GET };
+        case Hypo::H_OPCODE::CALL: return { 130000, addr + 4, 60000, addr + 5, 140000 }; // Call a RETURN, then branch over it.
+        case Hypo::H_OPCODE::BRANCH_ON_EQUAL: return { 160000, addr + 2 }; // No COMPARE has set ZERO, not taken.
+        default: return { opcode * 10000 + 1112 }; // Op1 = GPR1, op2 = GPR2, register mode.
+        }
+    }
+
+    // Build the loop for an opcode: GPR2 = 1, then the body unrolled B_UNROLL times and a branch back.
+    Hypo::ProgramImage OpcodeLoop(int opcode)
+    {
+        Hypo::ProgramImage image;
+        word addr = 0;
+
+        image.words.push_back({ addr++, 51260 }); // MOVE GPR2, #1
+        image.words.push_back({ addr++, 1 });
+
+        for (int i = 0; i < B_UNROLL; i++)
+        {
+            for (word w : OpcodeBody(opcode, addr))
+            {
+                image.words.push_back({ addr++, w });
+            }
+        }
+
+        image.words.push_back({ addr++, 60000 });
+        image.words.push_back({ addr++, 2 });
+        image.entry = 0;
+
+        return image;
+    }
+
+    // Decode and dispatch cost of each opcode, running loops of it through CPU.
+    void BenchOpcodes(std::ostream& out, int repeat)
+    {
+        const int opcodes[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 12, 13, 15, 16 };
+
+        out << "    \"opcodes\": [";
+
+        for (size_t i = 0; i < sizeof(opcodes) / sizeof(opcodes[0]); i++)
+        {
+            int opcode = opcodes[i];
+            Hypo::ProgramImage image = OpcodeLoop(opcode);
+            std::vector<double> ns, cycles, clocks;
+
+            for (int rep = 0; rep < repeat; rep++)
+            {
+                DispatchImage(image);
+
+                uint64_t instructions = Hypo::mtops_instructions;
+                word clock = Hypo::clock;
+                uint64_t start_ns = HostNs(), start_cycles = HostCycles();
+
+                for (int burst = 0; burst < B_OPCODE_BURSTS; burst++)
+                {
+                    b_sink = Hypo::CPU();
+                }
+
+                double retired = (double) (Hypo::mtops_instructions - instructions);
+                ns.push_back((HostNs() - start_ns) / retired);
+                cycles.push_back((HostCycles() - start_cycles) / retired);
+                clocks.push_back((Hypo::clock - clock) / retired);
+            }
+
+            std::string name = opcode == Hypo::H_OPCODE::PUSH ? "push/pop" : opcode == Hypo::H_OPCODE::CALL ? "call/return" : Hypo::debug_opcode_descs[opcode];
+
+            out << (i == 0 ? "\n" : ",\n") << "      {\"opcode\": \"" << name << "\""
+                << ", \"ns_per_instruction\": " << Median(ns)
+                << ", \"host_cycles_per_instruction\": " << Median(cycles)
+                << ", \"guest_mips\": " << 1000.0 / Median(ns)
+                << ", \"guest_clock_per_instruction\": " << Median(clocks) << "}";
+        }
+
+        out << "\n    ],\n";
+    }
+
+    // Image of a fill or a sum of B_BLOCK_WORDS words, as a block opcode or as the AUTO_INC loop guests use without one.
+    Hypo::ProgramImage BlockImage(bool sum, bool block)
+    {
+        Hypo::ProgramImage image;
+        std::vector<word> words = { 51160, Hypo::H_MAX_PROGRAM_ADDR + 100, 51060, B_BLOCK_WORDS, 51260, 7 }; // GPR1 = block, GPR0 = words, GPR2 = 7.
+
+        if (block) { words.push_back(sum ? 241321 : 232112); } // BLOCK_SUM GPR3, (GPR1) or BLOCK_FILL (GPR1), GPR2.
+        else { words.insert(words.end(), { sum ? 11331 : 53112, 21060, 1, 81000, 6 }); } // ADD GPR3, (GPR1)+ or MOVE (GPR1)+, GPR2, until GPR0 counts down to 0.
+
+        words.push_back(0); // HALT.
+
+        for (word addr = 0; addr < (word) words.size(); addr++)
+        {
+            image.words.push_back({ addr, words[addr] });
+        }
+
+        image.entry = 0;
+
+        return image;
+    }
+
+    // Block opcodes against the loops they replace, in host time and guest clock ticks.
+    void BenchBlockOpcodes(std::ostream& out, int repeat)
+    {
+        const char* kernels[] = { "fill", "sum" };
+
+        out << "    \"block_opcodes\": [";
+
+        for (int kernel = 0; kernel < 2; kernel++)
+        {
+            double ns[2], clocks[2]; // Loop, then block opcode.
+
+            for (int block = 0; block < 2; block++)
+            {
+                Hypo::ProgramImage image = BlockImage(kernel == 1, block == 1);
+                std::vector<double> run_ns, run_clocks;
+
+                for (int rep = 0; rep < repeat; rep++)
+                {
+                    DispatchImage(image);
+
+                    word clock = Hypo::clock;
+                    uint64_t start = HostNs();
+
+                    while ((b_sink = Hypo::CPU()) == Hypo::H_TTL_EXP) {}
+
+                    run_ns.push_back((double) (HostNs() - start));
+                    run_clocks.push_back((double) (Hypo::clock - clock));
+                }
+
+                ns[block] = Median(run_ns);
+                clocks[block] = Median(run_clocks);
+            }
+
+            out << (kernel == 0 ? "\n" : ",\n") << "      {\"kernel\": \"" << kernels[kernel] << "\", \"words\": " << B_BLOCK_WORDS
+                << ", \"loop_ns\": " << ns[0] << ", \"block_ns\": " << ns[1]
+                << ", \"loop_guest_clock\": " << clocks[0] << ", \"block_guest_clock\": " << clocks[1] << "}";
+        }
+
+        out << "\n    ],\n";
+    }
+
+    // Cost of FetchOperand in each addressing mode.
+    void BenchFetchOperand(std::ostream& out, int repeat)
+    {
+        out << "    \"fetch_operand\": [";
+
+        for (word mode = Hypo::H_OPMODE::REGISTER; mode <= Hypo::H_OPMODE::IMMEDIATE; mode++)
+        {
+            std::vector<double> ns;
+
+            for (int rep = 0; rep < repeat; rep++)
+            {
+                Hypo::ResetMachine();
+                Hypo::StoreWord(10, Hypo::H_MAX_PROGRAM_ADDR + 100); // Operand word for direct and immediate modes.
+
+                word addr, value, sum = 0;
+                uint64_t start = HostNs();
+
+                for (int call = 0; call < B_CALLS; call++)
+                {
+                    Hypo::r_pc = 10;
+                    Hypo::r_gpr[1] = Hypo::H_MAX_PROGRAM_ADDR + 100;
+                    Hypo::FetchOperand(mode, 1, &addr, &value);
+                    sum += value;
+                }
+
+                ns.push_back((double) (HostNs() - start) / B_CALLS);
+                b_sink = sum;
+            }
+
+            out << (mode == Hypo::H_OPMODE::REGISTER ? "\n" : ",\n") << "      {\"mode\": \"" << Hypo::debug_opmode_descs[mode] << "\", \"ns_per_call\": " << Median(ns) << "}";
+        }
+
+        out << "\n    ],\n";
+    }
+
+    // Latency of AllocateUserMemory and FreeUserMemory on a fragmented user free list.
+    void BenchUserMemory(std::ostream& out)
+    {
+        std::mt19937 rng(1);
+        std::uniform_int_distribution<int> size_dist(2, 8);
+        std::vector<std::pair<word, word>> live;
+        std::vector<double> alloc_ns, free_ns;
+        size_t free_blocks = 0;
+        int failed = 0;
+
+        Hypo::ResetMachine();
+
+        // Fill user memory with small blocks, then free every other one.
+        for (;;)
+        {
+            word size = size_dist(rng);
+            word ptr = Hypo::AllocateUserMemory(size);
+            if (ptr < 0) { break; }
+            live.push_back({ ptr, size });
+        }
+
+        for (size_t block = 0; block < live.size(); block += 2)
+        {
+            Hypo::FreeUserMemory(live[block].first, live[block].second);
+            live[block].first = Hypo::H_EOL;
+            free_blocks++;
+        }
+
+        live.erase(std::remove_if(live.begin(), live.end(), [](const std::pair<word, word>& block) { return block.first == Hypo::H_EOL; }), live.end());
+
+        // Random mix of allocations and frees.
+        for (int op = 0; op < B_ALLOC_OPS; op++)
+        {
+            if (live.empty() || rng() % 2 == 0)
+            {
+                word size = size_dist(rng);
+                uint64_t start = HostNs();
+                word ptr = Hypo::AllocateUserMemory(size);
+                alloc_ns.push_back((double) (HostNs() - start));
+
+                if (ptr < 0) { failed++; }
+                else { live.push_back({ ptr, size }); }
+            }
+            else
+            {
+                size_t victim = rng() % live.size();
+                uint64_t start = HostNs();
+                Hypo::FreeUserMemory(live[victim].first, live[victim].second);
+                free_ns.push_back((double) (HostNs() - start));
+
+                live[victim] = live.back();
+                live.pop_back();
+            }
+        }
+
+        out << "    \"user_memory\": {\"fragmented_free_blocks\": " << free_blocks << ", \"failed_allocs\": " << failed << ", \"alloc_ns\": ";
+        WritePercentiles(out, alloc_ns);
+        out << ", \"free_ns\": ";
+        WritePercentiles(out, free_ns);
+        out << "},\n";
+    }
+
+    // Cost of InsertIntoRQ, paired with RemovePCBfromRQ, with N processes resident in the RQ.
+    void BenchReadyQueue(std::ostream& out, int repeat)
+    {
+        const int residents[] = { 1, 16, 64, 128 };
+
+        out << "    \"insert_into_rq\": [";
+
+        for (size_t i = 0; i < sizeof(residents) / sizeof(residents[0]); i++)
+        {
+            std::vector<double> ns;
+
+            for (int rep = 0; rep < repeat; rep++)
+            {
+                std::mt19937 rng(1);
+                std::uniform_int_distribution<int> priority_dist(1, 255);
+
+                Hypo::ResetMachine(); // The null process is the first resident.
+
+                for (int resident = 1; resident < residents[i]; resident++)
+                {
+                    word pcb_ptr = Hypo::AllocateOSMemory(Hypo::H_PCBSIZE);
+                    Hypo::InitializePCB(pcb_ptr);
+                    Hypo::StoreWord(pcb_ptr + Hypo::I_PRIORITY, priority_dist(rng));
+                    Hypo::InsertIntoRQ(pcb_ptr);
+                }
+
+                word probe = Hypo::AllocateOSMemory(Hypo::H_PCBSIZE);
+                Hypo::InitializePCB(probe);
+
+                std::vector<word> priorities(1024);
+                for (word& priority : priorities) { priority = priority_dist(rng); }
+
+                uint64_t start = HostNs();
+
+                for (int call = 0; call < B_CALLS; call++)
+                {
+                    Hypo::StoreWord(probe + Hypo::I_PRIORITY, priorities[call % priorities.size()]);
+                    Hypo::InsertIntoRQ(probe);
+                    Hypo::RemovePCBfromRQ(probe);
+                }
+
+                ns.push_back((double) (HostNs() - start) / B_CALLS);
+            }
+
+            out << (i == 0 ? "\n" : ",\n") << "      {\"resident\": " << residents[i] << ", \"ns_per_insert_remove\": " << Median(ns) << "}";
+        }
+
+        out << "\n    ],\n";
+    }
+
+    // Cost of a SaveContext and Dispatcher pair.
+    void BenchContextSwitch(std::ostream& out, int repeat)
+    {
+        std::vector<double> ns;
+
+        for (int rep = 0; rep < repeat; rep++)
+        {
+            word pcb_ptr = DispatchImage(OpcodeLoop(Hypo::H_OPCODE::ADD));
+            uint64_t start = HostNs();
+
+            for (int call = 0; call < B_CALLS; call++)
+            {
+                Hypo::SaveContext(pcb_ptr);
+                Hypo::Dispatcher(pcb_ptr);
+            }
+
+            ns.push_back((double) (HostNs() - start) / B_CALLS);
+        }
+
+        out << "    \"context_switch\": {\"ns_per_save_dispatch\": " << Median(ns) << "}\n";
+    }
+
+    // ReadProgramImage on a large generated text EOM, against formatted stream extraction of the same file.
+    void BenchLoader(std::ostream& out, int repeat)
+    {
+        const std::string path = "hypo_bench_load.eom";
+
+        {
+            std::ofstream o_prog(path);
+
+            for (int pair = 0; pair < B_LOAD_PAIRS; pair++)
+            {
+                o_prog << pair % (Hypo::H_MAX_PROGRAM_ADDR + 1) << " " << pair * 7919 % 100000 << "\n";
+            }
+            o_prog << Hypo::H_EOF << " 0\n";
+        }
+
+        std::vector<double> loader_ns, stream_ns;
+
+        for (int rep = 0; rep < repeat; rep++)
+        {
+            Hypo::ProgramImage image;
+            uint64_t start = HostNs();
+
+            b_sink = Hypo::ReadProgramImage(path, &image);
+            loader_ns.push_back((double) (HostNs() - start) / B_LOAD_PAIRS);
+
+            std::ifstream i_prog(path);
+            int32_t addr, content;
+            word sum = 0;
+
+            start = HostNs();
+
+            while (i_prog >> addr >> content && addr != Hypo::H_EOF) { sum += content; }
+
+            stream_ns.push_back((double) (HostNs() - start) / B_LOAD_PAIRS);
+            b_sink = sum;
+        }
+
+        std::remove(path.c_str());
+
+        out << "    \"loader\": {\"pairs\": " << B_LOAD_PAIRS << ", \"threads\": " << std::max(1u, std::thread::hardware_concurrency())
+            << ", \"ns_per_pair\": " << Median(loader_ns) << ", \"stream_ns_per_pair\": " << Median(stream_ns) << "},\n";
+    }
+
+    // Whole shipped programs run headless through RunBatch.
+    void BenchPrograms(std::ostream& out, const std::string& dir, int repeat)
+    {
+        const char* programs[] = { "evensum.eom", "program1.eom", "hw2-1.eom", "hw2-2.eom", "hw2-3.eom" };
+        const std::vector<word> input;
+        bool first = true;
+
+        out << "  \"macro\": [";
+
+        for (const char* program : programs)
+        {
+            Hypo::ProgramImage image;
+
+            if (Hypo::ReadProgramImage(dir + "/" + program, &image) < 0)
+            {
+                std::cerr << std::endl;
+                continue;
+            }
+
+            std::vector<double> ns, cycles, run_us;
+            Hypo::BatchResult result;
+            uint64_t retired = 0;
+
+            for (int rep = 0; rep < repeat; rep++)
+            {
+                uint64_t instructions = Hypo::mtops_instructions;
+                uint64_t start_ns = HostNs(), start_cycles = HostCycles();
+
+                for (int run = 0; run < B_MACRO_RUNS; run++)
+                {
+                    result = Hypo::RunBatch(image, input, Hypo::H_BATCH_MAX_CLOCK);
+                }
+
+                retired = (Hypo::mtops_instructions - instructions) / B_MACRO_RUNS;
+                double total = (double) std::max<uint64_t>(1, Hypo::mtops_instructions - instructions);
+
+                ns.push_back((HostNs() - start_ns) / total);
+                cycles.push_back((HostCycles() - start_cycles) / total);
+                run_us.push_back((HostNs() - start_ns) / 1000.0 / B_MACRO_RUNS);
+            }
+
+            out << (first ? "\n" : ",\n") << "    {\"program\": \"" << program << "\""
+                << ", \"status\": " << result.status
+                << ", \"clock\": " << result.clock
+                << ", \"instructions\": " << retired
+                << ", \"guest_mips\": " << 1000.0 / Median(ns)
+                << ", \"host_cycles_per_instruction\": " << Median(cycles)
+                << ", \"run_us\": " << Median(run_us) << "}";
+
+            first = false;
+        }
+
+        out << "\n  ]\n";
+    }
+
+    /*
+    * int: RunBenchmarks
+    *
+    * Run every benchmark and write the results as JSON. Options: --programs <dir> holding null.eom
+    * and the shipped programs, --repeat <n> repetitions per measurement (the median is reported)
+    * and --out <file> instead of standard output. --no-verify measures the fully checked CPU and
+    * --cache <spec> measures with the memory hierarchy model on, --costs <file> with a cost table.
+    *
+    * @return 0, or an error code if the machine could not boot.
+    *
+    */
+    int RunBenchmarks(int argc, char* argv[])
+    {
+        std::string dir = HYPO_PROGRAM_DIR;
+        std::string out_file;
+        int repeat = 5;
+
+        for (int arg = 1; arg < argc; arg++)
+        {
+            std::string opt = argv[arg];
+
+            if (opt == "--no-verify") { Hypo::h_verify = false; }
+            else if (arg + 1 == argc) { break; } // The rest take a value.
+            else if (opt == "--programs") { dir = argv[++arg]; }
+            else if (opt == "--repeat") { repeat = std::max(1, std::stoi(argv[++arg])); }
+            else if (opt == "--out") { out_file = argv[++arg]; }
+            else if (opt == "--cache" && Hypo::ConfigureCaches(argv[++arg]) < 0) { return Hypo::E_MTOPS_INVALID_SIZE; }
+            else if (opt == "--costs" && Hypo::LoadCostTable(argv[++arg]) < 0) { return Hypo::E_MTOPS_INVALID_SIZE; }
+            else if (opt == "--stack") { Hypo::h_stack_words = std::max(2L, std::min((long) Hypo::H_MAX_STACK_SIZE, std::stol(argv[++arg]))); }
+        }
+
+        Hypo::h_null_program = dir + "/null.eom";
+        int boot = BootBatchBaseline();
+        if (boot < 0) { return boot; }
+
+        Hypo::h_console = &Hypo::h_null_console;
+
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(3);
+
+        out << "{\n  \"repeat\": " << repeat << ",\n  \"micro\": {\n";
+        BenchOpcodes(out, repeat);
+        BenchBlockOpcodes(out, repeat);
+        BenchFetchOperand(out, repeat);
+        BenchUserMemory(out);
+        BenchReadyQueue(out, repeat);
+        BenchLoader(out, repeat);
+        BenchContextSwitch(out, repeat);
+        out << "  },\n";
+        BenchPrograms(out, dir, repeat);
+        out << "}\n";
+
+        Hypo::h_console = &std::cout;
+
+        if (out_file.empty())
+        {
+            std::cout << out.str();
+        }
+        else
+        {
+            std::ofstream o_report(out_file);
+
+            if (!o_report)
+            {
+                std::cerr << "Cannot open file: " << out_file;
+                return Hypo::E_FS_CANT_OPEN;
+            }
+
+            o_report << out.str();
+        }
+
+        return 0;
+    }
+}
+
+// Run the benchmarks instead of the simulator.
+int main(int argc, char* argv[])
+{
+    return HypoBench::RunBenchmarks(argc, argv);
+}
+
+#else
+
+// Begin Hypo process execution.
+int main(int argc, char* argv[])
+{
+    Hypo::word status; // Init status.
+
+    bool restore = false;
+
+    std::string batch_program; // Run this program headless instead of taking interrupts.
+    long batch_runs = 1;
+    std::vector<Hypo::word> batch_input;
+
+    std::string profile; // Profile into <profile>.folded and <profile>.listing.
+    Hypo::word profile_period = 100;
+
+    std::string trace; // Record an execution trace into this file.
+
+    std::string metrics; // Export metrics into this file, or on unix:<path>.
+    long metrics_interval = 1000;
+
+    std::string record; // Log the operator's inputs into this file.
+    std::string replay; // Take the operator's inputs from this log instead.
+
+    std::string swap; // Page each process' program area through this swap file.
+    long swap_slots = Hypo::H_SWAP_SLOTS;
+    std::string manifest; // Run the jobs of this manifest across a thread pool.
+    std::string report;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int arg = 1; arg < argc; arg++)
+    {
+        std::string opt = argv[arg];
+
+        if (opt == "--diff-dump") // Only print changed words in memory dumps.
+        {
+            Hypo::h_dump_diff = true;
+        }
+        else if (opt == "--profile" && arg + 1 < argc) // Sample the guest PC into profile files.
+        {
+            profile = argv[++arg];
+        }
+        else if (opt == "--profile-period" && arg + 1 < argc) // Clock ticks between profiler samples.
+        {
+            profile_period = std::max(1L, std::stol(argv[++arg]));
+        }
+        else if (opt == "--trace" && arg + 1 < argc) // Record every instruction run into a trace file.
+        {
+            trace = argv[++arg];
+        }
+        else if (opt == "--decode-trace" && arg + 1 < argc) // Print a trace file and exit.
+        {
+            status = Hypo::DecodeTrace(argv[++arg], std::cout);
+            return status < 0 ? (int) status : 0;
+        }
+        else if (opt == "--no-optimize") // Assemble programs as written.
+        {
+            Hypo::h_asm_optimize = false;
+        }
+        else if ((opt == "--assemble" || opt == "--assemble-binary") && arg + 2 < argc) // Assemble a source into an EOM and exit.
+        {
+            std::string source = argv[++arg];
+            std::string output = argv[++arg];
+
+            status = Hypo::Assemble(source, output, opt == "--assemble-binary");
+            return status < 0 ? (int) status : 0;
+        }
+        else if (opt == "--metrics" && arg + 1 < argc) // Export Prometheus metrics to a file or a Unix socket.
+        {
+            metrics = argv[++arg];
+        }
+        else if (opt == "--metrics-interval" && arg + 1 < argc) // Milliseconds between metrics snapshots.
+        {
+            metrics_interval = std::max(1L, std::stol(argv[++arg]));
+        }
+        else if (opt == "--record" && arg + 1 < argc) // Log interrupts and inputs with when they were taken.
+        {
+            record = argv[++arg];
+        }
+        else if (opt == "--replay" && arg + 1 < argc) // Replay a logged session without an operator.
+        {
+            replay = argv[++arg];
+        }
+        else if (opt == "--symbols" && arg + 1 < argc) // Program doc with a symbol table for the profiler.
+        {
+            if (Hypo::LoadSymbols(argv[++arg]) < 0) { return Hypo::E_FS_CANT_OPEN; }
+        }
+        else if (opt == "--no-verify") // Run every program with all of the CPU's checks.
+        {
+            Hypo::h_verify = false;
+        }
+        else if (opt == "--costs" && arg + 1 < argc) // Load instruction costs, the TTL and CPU quotas from a config file.
+        {
+            if (Hypo::LoadCostTable(argv[++arg]) < 0) { return Hypo::E_MTOPS_INVALID_SIZE; }
+        }
+        else if (opt == "--cache" && arg + 1 < argc) // Price memory accesses with a cache and TLB model.
+        {
+            if (Hypo::ConfigureCaches(argv[++arg]) < 0) { return Hypo::E_MTOPS_INVALID_SIZE; }
+        }
+        else if (opt == "--stack" && arg + 1 < argc) // Words of stack a loaded process starts with.
+        {
+            Hypo::h_stack_words = std::stol(argv[++arg]);
+
+            if (Hypo::h_stack_words < 2 || Hypo::h_stack_words > Hypo::H_MAX_STACK_SIZE)
+            {
+                std::cerr << "--stack takes 2 to " << Hypo::H_MAX_STACK_SIZE << " words." << std::endl;
+                return Hypo::E_MTOPS_INVALID_SIZE;
+            }
+        }
+        else if (opt == "--vm" && arg + 1 < argc) // Give each process a private, demand-paged program area.
+        {
+            swap = argv[++arg];
+        }
+        else if (opt == "--vm-slots" && arg + 1 < argc) // Program areas the swap file holds.
+        {
+            swap_slots = std::max(1L, std::stol(argv[++arg]));
+        }
+        else if (opt == "--null" && arg + 1 < argc) // Load a different null process.
+        {
+            Hypo::h_null_program = argv[++arg];
+        }
+        else if (opt == "--batch" && arg + 1 < argc) // Run a program on a pooled machine, optionally many times.
+        {
+            batch_program = argv[++arg];
+
+            if (arg + 1 < argc && argv[arg + 1][0] != '-')
+            {
+                batch_runs = std::stol(argv[++arg]);
+            }
+        }
+        else if (opt == "--input" && arg + 1 < argc) // Characters IO_GETC returns in batch runs.
+        {
+            for (const char* c = argv[++arg]; *c; c++)
+            {
+                batch_input.push_back(*c);
+            }
+        }
+        else if (opt == "--manifest" && arg + 1 < argc) // Run a manifest of batch jobs.
+        {
+            manifest = argv[++arg];
+        }
+        else if (opt == "--threads" && arg + 1 < argc) // Worker threads for --manifest.
+        {
+            threads = std::max(1L, std::stol(argv[++arg]));
+        }
+        else if (opt == "--report" && arg + 1 < argc) // JSON report file for --manifest.
+        {
+            report = argv[++arg];
+        }
+        else if (opt == "--restore") // Warm start from a snapshot and the checkpoints that follow it instead of booting.
+        {
+            restore = true;
+
+            while (arg + 1 < argc && argv[arg + 1][0] != '-')
+            {
+                status = Hypo::RestoreSnapshot(argv[++arg]);
+                if (status < 0) { return (int) status; }
+            }
+        }
+    }
+
+    if (!swap.empty() && (restore || !batch_program.empty() || !manifest.empty()))
+    {
+        std::cerr << "--vm pages interactive sessions that boot, not --batch, --manifest or --restore." << std::endl;
+        return 1;
+    }
+
+    if (!manifest.empty())
+    {
+        return RunManifestMode(manifest, threads, report);
+    }
+
+    if (!trace.empty() && Hypo::StartTrace(trace) < 0) { return Hypo::E_FS_CANT_OPEN; }
+
+    if (!metrics.empty() && Hypo::StartMetrics(metrics, std::chrono::milliseconds(metrics_interval)) < 0) { return Hypo::E_FS_CANT_OPEN; }
+
+    if (!batch_program.empty())
+    {
+        int result = RunBatchMode(batch_program, batch_runs, batch_input, profile, profile_period);
+        Hypo::StopTrace();
+        Hypo::StopMetrics();
+        return result;
+    }
+
+    if (!swap.empty() && Hypo::StartPaging(swap, swap_slots) < 0) { return Hypo::E_FS_CANT_OPEN; }
+
+    if (!restore)
+    {
+        Hypo::InitializeSystem();
+    }
+    else
+    {
+        Hypo::ResetCacheModel(); // --cache may have come after --restore.
+    }
+
+    Hypo::ResetDumpBaseline();
+
+    if (!profile.empty()) { Hypo::StartProfiler(profile_period); }
+
+    if (!record.empty() && Hypo::StartRecord(record) < 0) { return Hypo::E_FS_CANT_OPEN; }
+
+    if (!replay.empty())
+    {
+        status = Hypo::StartReplay(replay);
+        if (status < 0) { return (int) status; }
+    }
+
+    int exit_code = 0;
+    auto session_start = std::chrono::steady_clock::now();
+
+    while (!Hypo::shutdown_status) // Loop while machine is running.
+    {
+        status = Hypo::CheckAndProcessInterrupt(); // Process interrupt for next user step.
+        if (status == Hypo::INT_SHUTDOWN) { break; } // Break out of loop if shutdown interrupt is entered.
+
+        std::cout << "\nPre-CPU scheduling RQ: ";
+        Hypo::PrintQueue(Hypo::RQ);
+
+        std::cout << "\nPre-CPU scheduling WQ: ";
+        Hypo::PrintQueue(Hypo::WQ);
+
+        Hypo::DumpMemory("\nMemory pre-CPU scheduling: ", Hypo::H_MAX_PROGRAM_ADDR + 1, 249);
+
+        Hypo::AdvanceTimers(Hypo::clock); // Wake sleeping processes whose time has come.
+
+        Hypo::mtops_pcb_ptr = Hypo::SelectProcessFromRQ(); // Select a process from the RQ to dispatch and load.
+        if (Hypo::mtops_pcb_ptr == Hypo::H_EOL) { std::cout << "\nNo process is ready to run."; continue; } // Wait for the next interrupt.
+
+        Hypo::Dispatcher(Hypo::mtops_pcb_ptr); // Restore context given the current PCB pointer.
+
+        std::cout << "\nPost-process selection from RQ: ";
+        Hypo::PrintQueue(Hypo::RQ);
+
+        std::cout << "Dumping memory of running PCB: ";
+        Hypo::PrintPCB(Hypo::mtops_pcb_ptr);
+
+        std::cout << "\nCPU execution starting...\n";
+        if (Hypo::IdleSpinning(Hypo::mtops_pcb_ptr)) { status = Hypo::IdleBurst(); } // Only the null process can run, skip interpreting its spin loop.
+        else { status = Hypo::CPU(); } // Run CPU.
+        std::cout << "\n --> CPU execution completed. Status code: " << (int) status << std::endl;
+
+        Hypo::DumpMemory("\nDynamic memory post-exeuction: ", Hypo::H_MAX_PROGRAM_ADDR + 1, 249);
+
+        status = Hypo::HandleBurstStatus(status); // File the process according to how its burst ended.
+        if (status < 0) { exit_code = (int) status; break; }
+    }
+
+    if (exit_code == 0) { std::cout << "System is shutting down."; }
+
+    Hypo::StopTrace();
+    Hypo::StopMetrics();
+    Hypo::FinishRecord();
+    Hypo::StopPaging();
+
+    if (!replay.empty())
+    {
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - session_start);
+        std::cerr << "Replayed " << Hypo::mtops_sched_point << " scheduling points in " << elapsed.count() << "us." << std::endl;
+
+        if (Hypo::FinishReplay() < 0 && exit_code == 0) { exit_code = Hypo::E_MTOPS_BAD_REPLAY; }
+    }
+
+    if (!profile.empty() && exit_code == 0) { return (int) Hypo::WriteProfile(profile); }
+
+    return exit_code;
+}
+
+#endif
@@ -0,0 +1,25 @@
+; Sum of the first 50 even numbers: evensum.eom, written for the assembler.
+; Assemble with: hypo --assemble evensum.asm evensum.eom
+
+        org         2
+Start:  Move        GPR0, #2            ; Step between even numbers.
+        Move        GPR3, #550
+        Move        GPR4, #100
+        Move        GPR5, #5
+        Move        GPR6, #50           ; Numbers left to add.
+        Move        GPR7, #1
+Loop:   Add         GPR1, GPR0          ; Next even number.
+        Add         GPR2, GPR1          ; Running sum.
+        Subtract    GPR6, GPR7
+        BrOnPlus    GPR6, Loop
+        Subtract    GPR3, GPR2          ; Check the sum against 2550.
+        Divide      GPR3, GPR4
+        Multiply    GPR3, GPR5
+        BrOnMinus   GPR3, Low
+        BrOnPlus    GPR3, High
+Low:    Add         GPR6, GPR7
+        Halt
+High:   Add         GPR6, GPR7
+        Add         GPR6, GPR7
+        Halt
+        end         Start